@@ -17,10 +17,12 @@
 package com.android.inputmethod.latin;
 
 import android.content.Context;
+import android.text.TextUtils;
 
 import com.android.inputmethod.keyboard.ProximityInfo;
 
 import java.util.Arrays;
+import java.util.BitSet;
 
 /**
  * Implements a static, compacted, binary dictionary of standard words.
@@ -38,6 +40,8 @@ public class BinaryDictionary extends Dictionary {
      */
     public static final int MAX_WORD_LENGTH = 48;
     public static final int MAX_WORDS = 18;
+    // Must be equal to NOT_A_FREQUENCY in native/src/defines.h
+    public static final int NOT_A_FREQUENCY = -1;
 
     private static final String TAG = "BinaryDictionary";
     private static final int MAX_PROXIMITY_CHARS_SIZE = ProximityInfo.MAX_PROXIMITY_CHARS_SIZE;
@@ -48,6 +52,7 @@ public class BinaryDictionary extends Dictionary {
     private int mDicTypeId;
     private int mNativeDict;
     private final int[] mInputCodes = new int[MAX_WORD_LENGTH * MAX_PROXIMITY_CHARS_SIZE];
+    private final int[] mPrimaryCodes = new int[MAX_WORD_LENGTH];
     private final char[] mOutputChars = new char[MAX_WORD_LENGTH * MAX_WORDS];
     private final char[] mOutputChars_bigrams = new char[MAX_WORD_LENGTH * MAX_BIGRAMS];
     private final int[] mScores = new int[MAX_WORDS];
@@ -61,6 +66,18 @@ public class BinaryDictionary extends Dictionary {
     // the evaluation at the size the user typed.
     public static final Flag FLAG_USE_FULL_EDIT_DISTANCE = new Flag(0x2);
 
+    // TIERED_CORRECTION is a flag that makes the dictionary look for exact and proximity matches
+    // first, and only try the other corrections and the split words if those are not good enough.
+    public static final Flag FLAG_USE_TIERED_CORRECTION = new Flag(0x4);
+
+    // TWO_STAGE_RANKING is a flag that makes the dictionary collect the best candidates with a
+    // cheap score first, and apply the touch position model to those candidates only.
+    public static final Flag FLAG_USE_TWO_STAGE_RANKING = new Flag(0x8);
+
+    // LOG_SCORING is a flag that makes the dictionary score the words with a sum of log-domain
+    // costs, which lets it prune the search. The scores stay on the same scale.
+    public static final Flag FLAG_USE_LOG_SCORING = new Flag(0x10);
+
     // Can create a new flag from extravalue :
     // public static final Flag FLAG_MYFLAG =
     //         new Flag("my_flag", 0x02);
@@ -80,6 +97,7 @@ public class BinaryDictionary extends Dictionary {
     };
 
     private int mFlags = 0;
+    private boolean mComputesProximityCodesNatively = false;
 
     /**
      * Constructor for the binary dictionary. This is supposed to be called from the
@@ -112,12 +130,26 @@ public class BinaryDictionary extends Dictionary {
             int maxWords, int maxAlternatives);
     private native void closeNative(int dict);
     private native boolean isValidWordNative(int nativeData, char[] word, int wordLength);
+    private native int getFrequencyNative(int nativeData, char[] word, int wordLength);
+    private native int getFrequenciesNative(int nativeData, char[] chars, int[] offsets,
+            int wordCount, int[] frequencies);
     private native int getSuggestionsNative(int dict, int proximityInfo, int[] xCoordinates,
-            int[] yCoordinates, int[] inputCodes, int codesSize, int flags, char[] outputChars,
+            int[] yCoordinates, int[] inputCodes, int codesSize, char[] prevWord,
+            int prevWordLength, int flags, char[] outputChars, int[] scores);
+    private native int getSuggestionsFromPrimaryCodesNative(int dict, int proximityInfo,
+            int[] xCoordinates, int[] yCoordinates, int[] primaryCodes, int codesSize,
+            char[] prevWord, int prevWordLength, int flags, char[] outputChars, int[] scores);
+    private native int getGestureSuggestionsNative(int dict, int proximityInfo,
+            int[] xCoordinates, int[] yCoordinates, int sampleCount, char[] outputChars,
             int[] scores);
     private native int getBigramsNative(int dict, char[] prevWord, int prevWordLength,
             int[] inputCodes, int inputCodesLength, char[] outputChars, int[] scores,
             int maxWordLength, int maxBigrams, int maxAlternatives);
+    private native int getTrigramsNative(int dict, char[] prevPrevWord, int prevPrevWordLength,
+            char[] prevWord, int prevWordLength, int[] inputCodes, int inputCodesLength,
+            char[] outputChars, int[] scores, int maxWordLength, int maxTrigrams);
+    private native boolean setBloomFilterBitsPerWordNative(int dict, int bitsPerWord);
+    private native boolean setRankingParamsNative(int dict, String params);
 
     private final void loadDictionary(String path, long startOffset, long length) {
         mNativeDict = openNative(path, startOffset, length,
@@ -163,11 +195,87 @@ public class BinaryDictionary extends Dictionary {
         }
     }
 
+    /**
+     * Searches for the words that follow two previous words in the trigram section of the
+     * dictionary, if it has one. If something was typed, only the words that start with one
+     * of the alternatives of the first key are returned. They are reported as bigrams.
+     */
+    public void getTrigrams(final WordComposer codes, final CharSequence prevPrevWord,
+            final CharSequence previousWord, final WordCallback callback) {
+        if (mNativeDict == 0) return;
+
+        char[] prevPrevChars = prevPrevWord.toString().toCharArray();
+        char[] prevChars = previousWord.toString().toCharArray();
+        Arrays.fill(mOutputChars_bigrams, (char) 0);
+        Arrays.fill(mBigramScores, 0);
+
+        int codesSize = codes.size();
+        Arrays.fill(mInputCodes, -1);
+        if (codesSize > 0) {
+            int[] alternatives = codes.getCodesAt(0);
+            System.arraycopy(alternatives, 0, mInputCodes, 0,
+                    Math.min(alternatives.length, MAX_PROXIMITY_CHARS_SIZE));
+        }
+
+        int count = getTrigramsNative(mNativeDict, prevPrevChars, prevPrevChars.length, prevChars,
+                prevChars.length, mInputCodes, codesSize, mOutputChars_bigrams, mBigramScores,
+                MAX_WORD_LENGTH, MAX_BIGRAMS);
+
+        for (int j = 0; j < count; ++j) {
+            final int start = j * MAX_WORD_LENGTH;
+            int len = 0;
+            while (len <  MAX_WORD_LENGTH && mOutputChars_bigrams[start + len] != 0) {
+                ++len;
+            }
+            if (len > 0) {
+                callback.addWord(mOutputChars_bigrams, start, len, mBigramScores[j],
+                        mDicTypeId, DataType.BIGRAM);
+            }
+        }
+    }
+
     // proximityInfo may not be null.
     @Override
     public void getWords(final WordComposer codes, final WordCallback callback,
             final ProximityInfo proximityInfo) {
-        final int count = getSuggestions(codes, proximityInfo, mOutputChars, mScores);
+        getWords(codes, null, callback, proximityInfo);
+    }
+
+    // proximityInfo may not be null.
+    @Override
+    public void getWords(final WordComposer codes, final CharSequence previousWord,
+            final WordCallback callback, final ProximityInfo proximityInfo) {
+        final int count = getSuggestions(codes, previousWord, proximityInfo, mOutputChars,
+                mScores);
+
+        for (int j = 0; j < count; ++j) {
+            if (mScores[j] < 1) break;
+            final int start = j * MAX_WORD_LENGTH;
+            int len = 0;
+            while (len < MAX_WORD_LENGTH && mOutputChars[start + len] != 0) {
+                ++len;
+            }
+            if (len > 0) {
+                callback.addWord(mOutputChars, start, len, mScores[j], mDicTypeId,
+                        DataType.UNIGRAM);
+            }
+        }
+    }
+
+    /**
+     * Decodes a gesture, the path of a finger that slides over the keys of a word, and reports
+     * the words that match it best to the callback, like getWords does for the taps.
+     * @param xCoordinates the x coordinates of the points of the path, in order.
+     * @param yCoordinates the y coordinates of the points of the path, in order.
+     * @param sampleCount the number of points of the path.
+     * @param callback the callback to report the words to.
+     * @param proximityInfo the keyboard the path was drawn on. May not be null.
+     */
+    public void getWordsForGesture(final int[] xCoordinates, final int[] yCoordinates,
+            final int sampleCount, final WordCallback callback,
+            final ProximityInfo proximityInfo) {
+        final int count = getGestureSuggestions(xCoordinates, yCoordinates, sampleCount,
+                proximityInfo, mOutputChars, mScores);
 
         for (int j = 0; j < count; ++j) {
             if (mScores[j] < 1) break;
@@ -183,6 +291,12 @@ public class BinaryDictionary extends Dictionary {
         }
     }
 
+    // The native code boosts the words that follow the previous word while it looks them up.
+    @Override
+    public boolean appliesBigramsToWords() {
+        return true;
+    }
+
     /* package for test */ boolean isValidDictionary() {
         return mNativeDict != 0;
     }
@@ -190,34 +304,158 @@ public class BinaryDictionary extends Dictionary {
     // proximityInfo may not be null.
     /* package for test */ int getSuggestions(final WordComposer codes,
             final ProximityInfo proximityInfo, char[] outputChars, int[] scores) {
+        return getSuggestions(codes, null, proximityInfo, outputChars, scores);
+    }
+
+    // previousWord may be null. proximityInfo may not be null.
+    /* package for test */ synchronized int getSuggestions(final WordComposer codes,
+            final CharSequence previousWord, final ProximityInfo proximityInfo,
+            char[] outputChars, int[] scores) {
         if (!isValidDictionary()) return -1;
 
         final int codesSize = codes.size();
         // Won't deal with really long words.
         if (codesSize > MAX_WORD_LENGTH - 1) return -1;
 
+        Arrays.fill(outputChars, (char) 0);
+        Arrays.fill(scores, 0);
+
+        final char[] prevWordChars = TextUtils.isEmpty(previousWord)
+                ? null : previousWord.toString().toCharArray();
+        if (mComputesProximityCodesNatively) {
+            for (int i = 0; i < codesSize; i++) {
+                int[] alternatives = codes.getCodesAt(i);
+                mPrimaryCodes[i] = alternatives.length > 0
+                        ? alternatives[0] : WordComposer.NOT_A_CODE;
+            }
+            return getSuggestionsFromPrimaryCodesNative(
+                    mNativeDict, proximityInfo.getNativeProximityInfo(),
+                    codes.getXCoordinates(), codes.getYCoordinates(), mPrimaryCodes, codesSize,
+                    prevWordChars, null == prevWordChars ? 0 : prevWordChars.length,
+                    mFlags, outputChars, scores);
+        }
         Arrays.fill(mInputCodes, WordComposer.NOT_A_CODE);
         for (int i = 0; i < codesSize; i++) {
             int[] alternatives = codes.getCodesAt(i);
             System.arraycopy(alternatives, 0, mInputCodes, i * MAX_PROXIMITY_CHARS_SIZE,
                     Math.min(alternatives.length, MAX_PROXIMITY_CHARS_SIZE));
         }
-        Arrays.fill(outputChars, (char) 0);
-        Arrays.fill(scores, 0);
-
         return getSuggestionsNative(
                 mNativeDict, proximityInfo.getNativeProximityInfo(),
                 codes.getXCoordinates(), codes.getYCoordinates(), mInputCodes, codesSize,
+                prevWordChars, null == prevWordChars ? 0 : prevWordChars.length,
                 mFlags, outputChars, scores);
     }
 
+    // proximityInfo may not be null.
+    /* package for test */ int getGestureSuggestions(final int[] xCoordinates,
+            final int[] yCoordinates, final int sampleCount, final ProximityInfo proximityInfo,
+            char[] outputChars, int[] scores) {
+        if (!isValidDictionary()) return -1;
+        if (sampleCount <= 0 || sampleCount > xCoordinates.length
+                || sampleCount > yCoordinates.length) {
+            return -1;
+        }
+
+        Arrays.fill(outputChars, (char) 0);
+        Arrays.fill(scores, 0);
+
+        return getGestureSuggestionsNative(mNativeDict, proximityInfo.getNativeProximityInfo(),
+                xCoordinates, yCoordinates, sampleCount, outputChars, scores);
+    }
+
     @Override
-    public boolean isValidWord(CharSequence word) {
+    public synchronized boolean isValidWord(CharSequence word) {
         if (word == null) return false;
         char[] chars = word.toString().toCharArray();
         return isValidWordNative(mNativeDict, chars, chars.length);
     }
 
+    /**
+     * Returns the frequency of a word in this dictionary.
+     * @param word the word to look up.
+     * @return its frequency, or NOT_A_FREQUENCY if the word is not in the dictionary.
+     */
+    public synchronized int getFrequency(CharSequence word) {
+        if (word == null || mNativeDict == 0) return NOT_A_FREQUENCY;
+        char[] chars = word.toString().toCharArray();
+        return getFrequencyNative(mNativeDict, chars, chars.length);
+    }
+
+    /**
+     * Looks up many words with one native call, for example all the words of a sentence.
+     * @param words the words to look up. Null words are not valid.
+     * @param outFrequencies if not null, receives the frequency of each word, or
+     *         NOT_A_FREQUENCY if it is not in the dictionary. Must be at least as long as words.
+     * @return the set of the indices of the words that are in the dictionary.
+     */
+    public synchronized BitSet getValidWords(CharSequence[] words, int[] outFrequencies) {
+        final int wordCount = words.length;
+        final BitSet validWords = new BitSet(wordCount);
+        if (mNativeDict == 0 || wordCount == 0) {
+            if (outFrequencies != null) Arrays.fill(outFrequencies, 0, wordCount, NOT_A_FREQUENCY);
+            return validWords;
+        }
+        // Pack the words into one buffer: the word i is chars[offsets[i]..offsets[i + 1]).
+        final int[] offsets = new int[wordCount + 1];
+        for (int i = 0; i < wordCount; ++i) {
+            offsets[i + 1] = offsets[i] + (words[i] == null ? 0 : words[i].length());
+        }
+        final char[] chars = new char[offsets[wordCount]];
+        for (int i = 0; i < wordCount; ++i) {
+            if (words[i] == null) continue;
+            final String word = words[i].toString();
+            word.getChars(0, word.length(), chars, offsets[i]);
+        }
+        final int[] frequencies = outFrequencies != null ? outFrequencies : new int[wordCount];
+        getFrequenciesNative(mNativeDict, chars, offsets, wordCount, frequencies);
+        for (int i = 0; i < wordCount; ++i) {
+            if (frequencies[i] != NOT_A_FREQUENCY) validWords.set(i);
+        }
+        return validWords;
+    }
+
+    /**
+     * Rebuilds the Bloom filter that lets isValidWord and getFrequency reject most of the words
+     * that are not in the dictionary without looking them up. The filter takes bitsPerWord / 8
+     * bytes per word of the dictionary, and lets through about 0.62 ^ bitsPerWord of the
+     * words that are not in it: about 1% with 10 bits per word. By default, a filter of 10 bits
+     * per word is built only for the dictionaries whose words are not indexed by a hash already.
+     * @param bitsPerWord the size of the filter, up to 32, or 0 to drop the filter.
+     * @return whether the dictionary has a filter afterwards. If the new filter could not be
+     *         built, the dictionary keeps the one it had.
+     */
+    public synchronized boolean setBloomFilterBitsPerWord(int bitsPerWord) {
+        if (mNativeDict == 0) return false;
+        return setBloomFilterBitsPerWordNative(mNativeDict, bitsPerWord);
+    }
+
+    /**
+     * Makes getSuggestions send only the primary code and the touch point of each char. The
+     * native code then takes the proximity chars from the keys around each touch point, nearest
+     * first, instead of using the proximity chars of the WordComposer. This only suits input
+     * that comes from touches on the keyboard of the ProximityInfo; the chars without a touch
+     * point get no proximity chars.
+     * @param enabled whether the proximity chars are computed by the native code.
+     */
+    public void setComputesProximityCodesNatively(boolean enabled) {
+        mComputesProximityCodesNatively = enabled;
+    }
+
+    /**
+     * Overrides the ranking constants of the native dictionary. Any constant that is not in the
+     * block goes back to its default.
+     * @param params a list of NAME=VALUE entries separated by white spaces, commas or semicolons,
+     *         where NAME is the name of the constant in native/src/defines.h, or null to restore
+     *         all the defaults.
+     * @return false if some entry could not be parsed or is out of bounds, in which case the
+     *         constants are left as they were.
+     */
+    public synchronized boolean setRankingParams(String params) {
+        if (mNativeDict == 0) return false;
+        return setRankingParamsNative(mNativeDict, params);
+    }
+
     @Override
     public synchronized void close() {
         closeInternal();
@@ -69,6 +69,31 @@ public abstract class Dictionary {
     abstract public void getWords(final WordComposer composer, final WordCallback callback,
             final ProximityInfo proximityInfo);
 
+    /**
+     * Searches for words in the dictionary that match the characters in the composer, like
+     * {@link #getWords(WordComposer, WordCallback, ProximityInfo)}. If this dictionary
+     * {@link #appliesBigramsToWords()}, the scores of the words that follow the previous word
+     * in its bigrams include the bigram multiplier. The base implementation ignores the previous
+     * word.
+     * @param composer the key sequence to match
+     * @param previousWord the word before, or null
+     * @param callback the callback object to send matched words to as possible candidates
+     * @param proximityInfo the object for key proximity. May be ignored by some implementations.
+     */
+    public void getWords(final WordComposer composer, final CharSequence previousWord,
+            final WordCallback callback, final ProximityInfo proximityInfo) {
+        getWords(composer, callback, proximityInfo);
+    }
+
+    /**
+     * Tells whether getWords applies the bigrams of this dictionary to the scores of the words
+     * when it is given the previous word, so that the caller must not apply them again.
+     * @return true if the bigrams are applied by getWords
+     */
+    public boolean appliesBigramsToWords() {
+        return false;
+    }
+
     /**
      * Searches for pairs in the bigram dictionary that matches the previous word and all the
      * possible words following are added through the callback object.
@@ -55,6 +55,23 @@ public class DictionaryCollection extends Dictionary {
             dict.getWords(composer, callback, proximityInfo);
     }
 
+    @Override
+    public void getWords(final WordComposer composer, final CharSequence previousWord,
+            final WordCallback callback, final ProximityInfo proximityInfo) {
+        // Either all the dictionaries apply their bigrams, or none of them does.
+        final CharSequence previousWordForDictionaries =
+                appliesBigramsToWords() ? previousWord : null;
+        for (final Dictionary dict : mDictionaries)
+            dict.getWords(composer, previousWordForDictionaries, callback, proximityInfo);
+    }
+
+    @Override
+    public boolean appliesBigramsToWords() {
+        for (final Dictionary dict : mDictionaries)
+            if (!dict.appliesBigramsToWords()) return false;
+        return true;
+    }
+
     @Override
     public void getBigrams(final WordComposer composer, final CharSequence previousWord,
             final WordCallback callback) {
@@ -98,6 +98,8 @@ public class Suggest implements Dictionary.WordCallback {
     private double mAutoCorrectionThreshold;
     private int[] mScores = new int[mPrefMaxSuggestions];
     private int[] mBigramScores = new int[PREF_MAX_BIGRAMS];
+    // The type of the dictionary each of mBigramSuggestions comes from
+    private int[] mBigramDicTypeIds = new int[PREF_MAX_BIGRAMS];
 
     private ArrayList<CharSequence> mSuggestions = new ArrayList<CharSequence>();
     ArrayList<CharSequence> mBigramSuggestions  = new ArrayList<CharSequence>();
@@ -106,6 +108,8 @@ public class Suggest implements Dictionary.WordCallback {
     // TODO: Remove these member variables by passing more context to addWord() callback method
     private boolean mIsFirstCharCapitalized;
     private boolean mIsAllUpperCase;
+    // Whether the dictionary that is adding unigrams already applied its own bigrams to them
+    private boolean mBigramsAppliedByDictionary;
 
     private int mCorrectionMode = CORRECTION_BASIC;
 
@@ -243,6 +247,7 @@ public class Suggest implements Dictionary.WordCallback {
         mPrefMaxSuggestions = maxSuggestions;
         mScores = new int[mPrefMaxSuggestions];
         mBigramScores = new int[PREF_MAX_BIGRAMS];
+        mBigramDicTypeIds = new int[PREF_MAX_BIGRAMS];
         collectGarbage(mSuggestions, mPrefMaxSuggestions);
         StringBuilderPool.ensureCapacity(mPrefMaxSuggestions, getApproxMaxWordLength());
     }
@@ -307,17 +312,21 @@ public class Suggest implements Dictionary.WordCallback {
         }
         mTypedWord = typedWord;
 
-        if (wordComposer.size() <= 1 && (mCorrectionMode == CORRECTION_FULL_BIGRAM
-                || mCorrectionMode == CORRECTION_BASIC)) {
+        final boolean usesBigrams = mCorrectionMode == CORRECTION_FULL_BIGRAM
+                || mCorrectionMode == CORRECTION_BASIC;
+        if (usesBigrams && !TextUtils.isEmpty(prevWordForBigram)) {
+            CharSequence lowerPrevWord = prevWordForBigram.toString().toLowerCase();
+            if (mMainDict != null && mMainDict.isValidWord(lowerPrevWord)) {
+                prevWordForBigram = lowerPrevWord;
+            }
+        }
+
+        if (wordComposer.size() <= 1 && usesBigrams) {
             // At first character typed, search only the bigrams
             Arrays.fill(mBigramScores, 0);
             collectGarbage(mBigramSuggestions, PREF_MAX_BIGRAMS);
 
             if (!TextUtils.isEmpty(prevWordForBigram)) {
-                CharSequence lowerPrevWord = prevWordForBigram.toString().toLowerCase();
-                if (mMainDict != null && mMainDict.isValidWord(lowerPrevWord)) {
-                    prevWordForBigram = lowerPrevWord;
-                }
                 for (final Dictionary dictionary : mBigramDictionaries.values()) {
                     dictionary.getBigrams(wordComposer, prevWordForBigram, this);
                 }
@@ -349,13 +358,19 @@ public class Suggest implements Dictionary.WordCallback {
 
         } else if (wordComposer.size() > 1) {
             // At second character typed, search the unigrams (scores being affected by bigrams)
+            final CharSequence prevWordForUnigrams = usesBigrams ? prevWordForBigram : null;
             for (final String key : mUnigramDictionaries.keySet()) {
                 // Skip UserUnigramDictionary and WhitelistDictionary to lookup
                 if (key.equals(DICT_KEY_USER_UNIGRAM) || key.equals(DICT_KEY_WHITELIST))
                     continue;
                 final Dictionary dictionary = mUnigramDictionaries.get(key);
-                dictionary.getWords(wordComposer, this, proximityInfo);
+                // Dictionaries that apply their bigrams while looking up the words save us from
+                // merging them here.
+                mBigramsAppliedByDictionary = !TextUtils.isEmpty(prevWordForUnigrams)
+                        && dictionary.appliesBigramsToWords();
+                dictionary.getWords(wordComposer, prevWordForUnigrams, this, proximityInfo);
             }
+            mBigramsAppliedByDictionary = false;
         }
         final String typedWordString = typedWord == null ? null : typedWord.toString();
 
@@ -441,7 +456,7 @@ public class Suggest implements Dictionary.WordCallback {
         } else {
             if (dataType == Dictionary.DataType.UNIGRAM) {
                 // Check if the word was already added before (by bigram data)
-                int bigramSuggestion = searchBigramSuggestion(word,offset,length);
+                int bigramSuggestion = searchBigramSuggestion(word, offset, length, dicTypeId);
                 if(bigramSuggestion >= 0) {
                     dataTypeForLog = Dictionary.DataType.BIGRAM;
                     // turn freq from bigram into multiplier specified above
@@ -474,6 +489,11 @@ public class Suggest implements Dictionary.WordCallback {
 
         System.arraycopy(sortedScores, pos, sortedScores, pos + 1, prefMaxSuggestions - pos - 1);
         sortedScores[pos] = score;
+        if (dataType == Dictionary.DataType.BIGRAM) {
+            System.arraycopy(mBigramDicTypeIds, pos, mBigramDicTypeIds, pos + 1,
+                    prefMaxSuggestions - pos - 1);
+            mBigramDicTypeIds[pos] = dicTypeId;
+        }
         final StringBuilder sb = StringBuilderPool.getStringBuilder(getApproxMaxWordLength());
         // TODO: Must pay attention to locale when changing case.
         if (mIsAllUpperCase) {
@@ -498,10 +518,12 @@ public class Suggest implements Dictionary.WordCallback {
         return true;
     }
 
-    private int searchBigramSuggestion(final char[] word, final int offset, final int length) {
+    private int searchBigramSuggestion(final char[] word, final int offset, final int length,
+            final int dicTypeId) {
         // TODO This is almost O(n^2). Might need fix.
         // search whether the word appeared in bigram data
         int bigramSuggestSize = mBigramSuggestions.size();
+        int found = -1;
         for(int i = 0; i < bigramSuggestSize; i++) {
             if(mBigramSuggestions.get(i).length() == length) {
                 boolean chk = true;
@@ -511,11 +533,16 @@ public class Suggest implements Dictionary.WordCallback {
                         break;
                     }
                 }
-                if(chk) return i;
+                if(chk) {
+                    if (!mBigramsAppliedByDictionary) return i;
+                    // The dictionary of this word already applied the bigrams it knows of
+                    if (mBigramDicTypeIds[i] == dicTypeId) return -1;
+                    if (found < 0) found = i;
+                }
             }
         }
 
-        return -1;
+        return found;
     }
 
     private void collectGarbage(ArrayList<CharSequence> suggestions, int prefMaxSuggestions) {
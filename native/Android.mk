@@ -13,11 +13,19 @@ LOCAL_SRC_FILES := \
     jni/com_android_inputmethod_latin_BinaryDictionary.cpp \
     jni/jni_common.cpp \
     src/bigram_dictionary.cpp \
+    src/bloom_filter.cpp \
     src/char_utils.cpp \
     src/correction.cpp \
     src/dictionary.cpp \
+    src/gesture_decoder.cpp \
+    src/input_context.cpp \
     src/proximity_info.cpp \
-    src/unigram_dictionary.cpp
+    src/proximity_info_cache.cpp \
+    src/ranking_params.cpp \
+    src/terminal_index.cpp \
+    src/trigram_dictionary.cpp \
+    src/unigram_dictionary.cpp \
+    src/word_index.cpp
 
 #FLAG_DBG := true
 #FLAG_DO_PROFILE := true
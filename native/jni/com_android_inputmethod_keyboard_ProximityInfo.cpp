@@ -21,6 +21,7 @@
 #include "jni.h"
 #include "jni_common.h"
 #include "proximity_info.h"
+#include "proximity_info_cache.h"
 
 #include <assert.h>
 #include <errno.h>
@@ -44,7 +45,7 @@ static jint latinime_Keyboard_setProximityInfo(JNIEnv *env, jobject object,
     jfloat *sweetSpotCenterXs = safeGetFloatArrayElements(env, sweetSpotCenterXArray);
     jfloat *sweetSpotCenterYs = safeGetFloatArrayElements(env, sweetSpotCenterYArray);
     jfloat *sweetSpotRadii = safeGetFloatArrayElements(env, sweetSpotRadiusArray);
-    ProximityInfo *proximityInfo = new ProximityInfo(maxProximityCharsSize, displayWidth,
+    ProximityInfo *proximityInfo = ProximityInfoCache::acquire(maxProximityCharsSize, displayWidth,
             displayHeight, gridWidth, gridHeight, (const uint32_t*)proximityChars,
             keyCount, (const int32_t*)keyXCoordinates, (const int32_t*)keyYCoordinates,
             (const int32_t*)keyWidths, (const int32_t*)keyHeights, (const int32_t*)keyCharCodes,
@@ -63,9 +64,7 @@ static jint latinime_Keyboard_setProximityInfo(JNIEnv *env, jobject object,
 }
 
 static void latinime_Keyboard_release(JNIEnv *env, jobject object, jint proximityInfo) {
-    ProximityInfo *pi = (ProximityInfo*)proximityInfo;
-    if (!pi) return;
-    delete pi;
+    ProximityInfoCache::release((ProximityInfo*)proximityInfo);
 }
 
 static JNINativeMethod sKeyboardMethods[] = {
@@ -124,10 +124,12 @@ static jint latinime_BinaryDictionary_open(JNIEnv *env, jobject object,
     return (jint)dictionary;
 }
 
-static int latinime_BinaryDictionary_getSuggestions(JNIEnv *env, jobject object, jint dict,
-        jint proximityInfo, jintArray xCoordinatesArray, jintArray yCoordinatesArray,
-        jintArray inputArray, jint arraySize, jint flags,
-        jcharArray outputArray, jintArray frequencyArray) {
+// When hasPrimaryCodesOnly is true, inputArray holds one code per char and the proximity chars
+// are computed from the coordinates.
+static int getSuggestions(JNIEnv *env, jint dict, jint proximityInfo,
+        jintArray xCoordinatesArray, jintArray yCoordinatesArray, jintArray inputArray,
+        jint arraySize, jcharArray prevWordArray, jint prevWordLength, jint flags,
+        jcharArray outputArray, jintArray frequencyArray, const bool hasPrimaryCodesOnly) {
     Dictionary *dictionary = (Dictionary*)dict;
     if (!dictionary) return 0;
     ProximityInfo *pInfo = (ProximityInfo*)proximityInfo;
@@ -138,9 +140,24 @@ static int latinime_BinaryDictionary_getSuggestions(JNIEnv *env, jobject object,
     int *frequencies = env->GetIntArrayElements(frequencyArray, NULL);
     int *inputCodes = env->GetIntArrayElements(inputArray, NULL);
     jchar *outputChars = env->GetCharArrayElements(outputArray, NULL);
+    jchar *prevWord = prevWordArray ? env->GetCharArrayElements(prevWordArray, NULL) : NULL;
 
-    int count = dictionary->getSuggestions(pInfo, xCoordinates, yCoordinates, inputCodes,
-            arraySize, flags, (unsigned short*) outputChars, frequencies);
+    const int *codes = inputCodes;
+    int *computedCodes = NULL;
+    if (hasPrimaryCodesOnly) {
+        computedCodes = new int[MAX_WORD_LENGTH_INTERNAL * pInfo->getMaxProximityCharsSize()];
+        pInfo->computeProximityCodes(inputCodes, arraySize, xCoordinates, yCoordinates,
+                computedCodes);
+        codes = computedCodes;
+    }
+    int count = dictionary->getSuggestions(pInfo, xCoordinates, yCoordinates, codes,
+            arraySize, (unsigned short*) prevWord, prevWord ? prevWordLength : 0, flags,
+            (unsigned short*) outputChars, frequencies);
+    delete[] computedCodes;
+
+    if (prevWord) {
+        env->ReleaseCharArrayElements(prevWordArray, prevWord, JNI_ABORT);
+    }
 
     env->ReleaseIntArrayElements(frequencyArray, frequencies, 0);
     env->ReleaseIntArrayElements(inputArray, inputCodes, JNI_ABORT);
@@ -151,6 +168,48 @@ static int latinime_BinaryDictionary_getSuggestions(JNIEnv *env, jobject object,
     return count;
 }
 
+static int latinime_BinaryDictionary_getSuggestions(JNIEnv *env, jobject object, jint dict,
+        jint proximityInfo, jintArray xCoordinatesArray, jintArray yCoordinatesArray,
+        jintArray inputArray, jint arraySize, jcharArray prevWordArray, jint prevWordLength,
+        jint flags, jcharArray outputArray, jintArray frequencyArray) {
+    return getSuggestions(env, dict, proximityInfo, xCoordinatesArray, yCoordinatesArray,
+            inputArray, arraySize, prevWordArray, prevWordLength, flags, outputArray,
+            frequencyArray, false);
+}
+
+static int latinime_BinaryDictionary_getSuggestionsFromPrimaryCodes(JNIEnv *env,
+        jobject object, jint dict, jint proximityInfo, jintArray xCoordinatesArray,
+        jintArray yCoordinatesArray, jintArray primaryCodeArray, jint arraySize,
+        jcharArray prevWordArray, jint prevWordLength, jint flags, jcharArray outputArray,
+        jintArray frequencyArray) {
+    return getSuggestions(env, dict, proximityInfo, xCoordinatesArray, yCoordinatesArray,
+            primaryCodeArray, arraySize, prevWordArray, prevWordLength, flags, outputArray,
+            frequencyArray, true);
+}
+
+static int latinime_BinaryDictionary_getGestureSuggestions(JNIEnv *env, jobject object,
+        jint dict, jint proximityInfo, jintArray xCoordinatesArray, jintArray yCoordinatesArray,
+        jint sampleCount, jcharArray outputArray, jintArray frequencyArray) {
+    Dictionary *dictionary = (Dictionary*)dict;
+    if (!dictionary) return 0;
+    ProximityInfo *pInfo = (ProximityInfo*)proximityInfo;
+
+    int *xCoordinates = env->GetIntArrayElements(xCoordinatesArray, NULL);
+    int *yCoordinates = env->GetIntArrayElements(yCoordinatesArray, NULL);
+    jchar *outputChars = env->GetCharArrayElements(outputArray, NULL);
+    int *frequencies = env->GetIntArrayElements(frequencyArray, NULL);
+
+    int count = dictionary->getGestureSuggestions(pInfo, xCoordinates, yCoordinates,
+            sampleCount, (unsigned short*) outputChars, frequencies);
+
+    env->ReleaseIntArrayElements(frequencyArray, frequencies, 0);
+    env->ReleaseCharArrayElements(outputArray, outputChars, 0);
+    env->ReleaseIntArrayElements(yCoordinatesArray, yCoordinates, JNI_ABORT);
+    env->ReleaseIntArrayElements(xCoordinatesArray, xCoordinates, JNI_ABORT);
+
+    return count;
+}
+
 static int latinime_BinaryDictionary_getBigrams(JNIEnv *env, jobject object, jint dict,
         jcharArray prevWordArray, jint prevWordLength, jintArray inputArray, jint inputArraySize,
         jcharArray outputArray, jintArray frequencyArray, jint maxWordLength, jint maxBigrams,
@@ -175,6 +234,32 @@ static int latinime_BinaryDictionary_getBigrams(JNIEnv *env, jobject object, jin
     return count;
 }
 
+static int latinime_BinaryDictionary_getTrigrams(JNIEnv *env, jobject object, jint dict,
+        jcharArray prevPrevWordArray, jint prevPrevWordLength, jcharArray prevWordArray,
+        jint prevWordLength, jintArray inputArray, jint inputArraySize, jcharArray outputArray,
+        jintArray frequencyArray, jint maxWordLength, jint maxTrigrams) {
+    Dictionary *dictionary = (Dictionary*)dict;
+    if (!dictionary) return 0;
+
+    jchar *prevPrevWord = env->GetCharArrayElements(prevPrevWordArray, NULL);
+    jchar *prevWord = env->GetCharArrayElements(prevWordArray, NULL);
+    int *inputCodes = env->GetIntArrayElements(inputArray, NULL);
+    jchar *outputChars = env->GetCharArrayElements(outputArray, NULL);
+    int *frequencies = env->GetIntArrayElements(frequencyArray, NULL);
+
+    int count = dictionary->getTrigrams((unsigned short*) prevPrevWord, prevPrevWordLength,
+            (unsigned short*) prevWord, prevWordLength, inputCodes, inputArraySize,
+            (unsigned short*) outputChars, frequencies, maxWordLength, maxTrigrams);
+
+    env->ReleaseCharArrayElements(prevPrevWordArray, prevPrevWord, JNI_ABORT);
+    env->ReleaseCharArrayElements(prevWordArray, prevWord, JNI_ABORT);
+    env->ReleaseIntArrayElements(inputArray, inputCodes, JNI_ABORT);
+    env->ReleaseCharArrayElements(outputArray, outputChars, 0);
+    env->ReleaseIntArrayElements(frequencyArray, frequencies, 0);
+
+    return count;
+}
+
 static jboolean latinime_BinaryDictionary_isValidWord(JNIEnv *env, jobject object, jint dict,
         jcharArray wordArray, jint wordLength) {
     Dictionary *dictionary = (Dictionary*)dict;
@@ -187,6 +272,61 @@ static jboolean latinime_BinaryDictionary_isValidWord(JNIEnv *env, jobject objec
     return result;
 }
 
+static int latinime_BinaryDictionary_getFrequency(JNIEnv *env, jobject object, jint dict,
+        jcharArray wordArray, jint wordLength) {
+    Dictionary *dictionary = (Dictionary*)dict;
+    if (!dictionary) return NOT_A_FREQUENCY;
+
+    jchar *word = env->GetCharArrayElements(wordArray, NULL);
+    int frequency = dictionary->getFrequency((unsigned short*) word, wordLength);
+    env->ReleaseCharArrayElements(wordArray, word, JNI_ABORT);
+
+    return frequency;
+}
+
+static int latinime_BinaryDictionary_getFrequencies(JNIEnv *env, jobject object, jint dict,
+        jcharArray charArray, jintArray offsetArray, jint wordCount, jintArray frequencyArray) {
+    Dictionary *dictionary = (Dictionary*)dict;
+    if (!dictionary) return 0;
+
+    jchar *chars = env->GetCharArrayElements(charArray, NULL);
+    int *offsets = env->GetIntArrayElements(offsetArray, NULL);
+    int *frequencies = env->GetIntArrayElements(frequencyArray, NULL);
+
+    int count = dictionary->getFrequencies((unsigned short*) chars, offsets, wordCount,
+            frequencies);
+
+    env->ReleaseCharArrayElements(charArray, chars, JNI_ABORT);
+    env->ReleaseIntArrayElements(offsetArray, offsets, JNI_ABORT);
+    env->ReleaseIntArrayElements(frequencyArray, frequencies, 0);
+
+    return count;
+}
+
+static jboolean latinime_BinaryDictionary_setBloomFilterBitsPerWord(JNIEnv *env,
+        jobject object, jint dict, jint bitsPerWord) {
+    Dictionary *dictionary = (Dictionary*)dict;
+    if (!dictionary) return (jboolean) false;
+    return (jboolean) dictionary->setBloomFilterBitsPerWord(bitsPerWord);
+}
+
+static jboolean latinime_BinaryDictionary_setRankingParams(JNIEnv *env, jobject object,
+        jint dict, jstring params) {
+    Dictionary *dictionary = (Dictionary*)dict;
+    if (!dictionary) return (jboolean) false;
+    if (!params) return (jboolean) dictionary->setRankingParams(NULL);
+
+    const char *paramsChars = env->GetStringUTFChars(params, NULL);
+    if (!paramsChars) {
+        LOGE("DICT: Can't get params string");
+        return (jboolean) false;
+    }
+    jboolean result = dictionary->setRankingParams(paramsChars);
+    env->ReleaseStringUTFChars(params, paramsChars);
+
+    return result;
+}
+
 static void latinime_BinaryDictionary_close(JNIEnv *env, jobject object, jint dict) {
     Dictionary *dictionary = (Dictionary*)dict;
     if (!dictionary) return;
@@ -219,9 +359,21 @@ void releaseDictBuf(void* dictBuf, const size_t length, int fd) {
 static JNINativeMethod sMethods[] = {
     {"openNative", "(Ljava/lang/String;JJIIIII)I", (void*)latinime_BinaryDictionary_open},
     {"closeNative", "(I)V", (void*)latinime_BinaryDictionary_close},
-    {"getSuggestionsNative", "(II[I[I[III[C[I)I", (void*)latinime_BinaryDictionary_getSuggestions},
+    {"getSuggestionsNative", "(II[I[I[II[CII[C[I)I",
+            (void*)latinime_BinaryDictionary_getSuggestions},
+    {"getSuggestionsFromPrimaryCodesNative", "(II[I[I[II[CII[C[I)I",
+            (void*)latinime_BinaryDictionary_getSuggestionsFromPrimaryCodes},
+    {"getGestureSuggestionsNative", "(II[I[II[C[I)I",
+            (void*)latinime_BinaryDictionary_getGestureSuggestions},
     {"isValidWordNative", "(I[CI)Z", (void*)latinime_BinaryDictionary_isValidWord},
-    {"getBigramsNative", "(I[CI[II[C[IIII)I", (void*)latinime_BinaryDictionary_getBigrams}
+    {"getFrequencyNative", "(I[CI)I", (void*)latinime_BinaryDictionary_getFrequency},
+    {"getFrequenciesNative", "(I[C[II[I)I", (void*)latinime_BinaryDictionary_getFrequencies},
+    {"getBigramsNative", "(I[CI[II[C[IIII)I", (void*)latinime_BinaryDictionary_getBigrams},
+    {"getTrigramsNative", "(I[CI[CI[II[C[III)I", (void*)latinime_BinaryDictionary_getTrigrams},
+    {"setBloomFilterBitsPerWordNative", "(II)Z",
+            (void*)latinime_BinaryDictionary_setBloomFilterBitsPerWord},
+    {"setRankingParamsNative", "(ILjava/lang/String;)Z",
+            (void*)latinime_BinaryDictionary_setRankingParams}
 };
 
 int register_BinaryDictionary(JNIEnv *env) {
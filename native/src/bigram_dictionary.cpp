@@ -22,15 +22,25 @@
 #include "bigram_dictionary.h"
 #include "dictionary.h"
 #include "binary_format.h"
+#include "terminal_index.h"
 
 namespace latinime {
 
-BigramDictionary::BigramDictionary(const unsigned char *dict, int maxWordLength,
-        int maxAlternatives, const bool isLatestDictVersion, const bool hasBigram,
-        Dictionary *parentDictionary)
-    : DICT(dict + NEW_DICTIONARY_HEADER_SIZE), MAX_WORD_LENGTH(maxWordLength),
+BigramDictionary::BigramDictionary(const unsigned char *dict, const int32_t *alphabet,
+        int maxWordLength, int maxAlternatives, const bool isLatestDictVersion,
+        const bool hasBigram, Dictionary *parentDictionary, const TerminalIndex *terminalIndex)
+    : DICT(dict + BinaryFormat::getHeaderSize(dict)), ALPHABET(alphabet),
+    MAX_WORD_LENGTH(maxWordLength),
     MAX_ALTERNATIVES(maxAlternatives), IS_LATEST_DICT_VERSION(isLatestDictVersion),
-    HAS_BIGRAM(hasBigram), mParentDictionary(parentDictionary) {
+    HAS_BIGRAM(hasBigram),
+    BIGRAMS_SORTED_BY_FREQUENCY(0 != (BinaryFormat::getOptions(dict)
+            & BinaryFormat::OPTION_BIGRAMS_SORTED_BY_FREQUENCY)),
+    mParentDictionary(parentDictionary),
+    mTerminalIndex(terminalIndex), mUseCount(0) {
+    for (int i = 0; i < BIGRAM_CACHE_SIZE; ++i) {
+        mBigramLists[i].mTerminalPos = NOT_VALID_WORD;
+        mBigramLists[i].mLastUse = 0;
+    }
     if (DEBUG_DICT) {
         LOGI("BigramDictionary - constructor");
         LOGI("Has Bigram : %d", hasBigram);
@@ -112,35 +122,139 @@ int BigramDictionary::getBigrams(unsigned short *prevWord, int prevWordLength, i
     mMaxBigrams = maxBigrams;
 
     const uint8_t* const root = DICT;
-    int pos = BinaryFormat::getTerminalPosition(root, prevWord, prevWordLength);
+    const int terminalPos = BinaryFormat::getTerminalPosition(root, ALPHABET, prevWord,
+            prevWordLength);
+    if (NOT_VALID_WORD == terminalPos) return 0;
 
+    const BigramList *const list = getBigramList(terminalPos);
+    if (list) {
+        // The list is in output order already: keep the bigrams that match the input.
+        int count = 0;
+        for (int i = 0; i < list->mCount && count < mMaxBigrams; ++i) {
+            unsigned short firstChar = list->mFirstChars[i];
+            if (!checkFirstCharacter(&firstChar)) continue;
+            unsigned short *const dest = mBigramChars + count * MAX_WORD_LENGTH;
+            const int length = mTerminalIndex->getWord(list->mWordIds[i], MAX_WORD_LENGTH - 1,
+                    dest);
+            dest[length] = 0;
+            mBigramFreq[count] = list->mFrequencies[i];
+            ++count;
+        }
+        return list->mBigramCount;
+    }
+
+    int pos = getAttributeListPosition(terminalPos);
     if (NOT_VALID_WORD == pos) return 0;
+    int bigramFlags;
+    int bigramCount = 0;
+    bool isCutOff = false;
+    do {
+        bigramFlags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+        const int bigramPos = BinaryFormat::getAttributeAddressAndForwardPointer(root, bigramFlags,
+                &pos);
+        ++bigramCount;
+        // Past the cut off, only count the remaining bigrams for the return value.
+        if (isCutOff) continue;
+        const int frequency = UnigramDictionary::MASK_ATTRIBUTE_FREQUENCY & bigramFlags;
+        if (BIGRAMS_SORTED_BY_FREQUENCY && (frequency <= 0 || mMaxBigrams <= 0
+                || frequency < mBigramFreq[mMaxBigrams - 1])) {
+            // This bigram can't be output: either the output is full of more frequent ones, or
+            // it has frequency 0, which addWordBigram never outputs. The rest of the list can
+            // only be less frequent.
+            isCutOff = true;
+            continue;
+        }
+        uint16_t bigramBuffer[MAX_WORD_LENGTH];
+        const int length = mTerminalIndex->getWordAtAddress(bigramPos, MAX_WORD_LENGTH,
+                bigramBuffer);
+
+        if (checkFirstCharacter(bigramBuffer)) {
+            addWordBigram(bigramBuffer, length, frequency);
+        }
+    } while (0 != (UnigramDictionary::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags));
+    return bigramCount;
+}
+
+// Returns the position of the attributes of the word at terminalPos, or NOT_VALID_WORD if it
+// has no bigrams.
+int BigramDictionary::getAttributeListPosition(int pos) {
+    const uint8_t* const root = DICT;
     const int flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
-    if (0 == (flags & UnigramDictionary::FLAG_HAS_BIGRAMS)) return 0;
+    if (0 == (flags & UnigramDictionary::FLAG_HAS_BIGRAMS)) return NOT_VALID_WORD;
     if (0 == (flags & UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS)) {
-        BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
+        BinaryFormat::getCharCodeAndForwardPointer(root, ALPHABET, &pos);
     } else {
         pos = BinaryFormat::skipOtherCharacters(root, pos);
     }
     pos = BinaryFormat::skipChildrenPosition(flags, pos);
-    pos = BinaryFormat::skipFrequency(flags, pos);
+    return BinaryFormat::skipFrequency(flags, pos);
+}
+
+// Returns the cached bigram list of the word at terminalPos, reading it into the least
+// recently used entry if it is not there. Returns NULL if the list can't be cached.
+const BigramDictionary::BigramList *BigramDictionary::getBigramList(int terminalPos) {
+    ++mUseCount;
+    BigramList *victim = &mBigramLists[0];
+    for (int i = 0; i < BIGRAM_CACHE_SIZE; ++i) {
+        BigramList *const list = &mBigramLists[i];
+        if (list->mTerminalPos == terminalPos) {
+            list->mLastUse = mUseCount;
+            return list;
+        }
+        if (list->mLastUse < victim->mLastUse) victim = list;
+    }
+    if (!readBigramList(terminalPos, victim)) {
+        victim->mTerminalPos = NOT_VALID_WORD;
+        victim->mLastUse = 0;
+        return NULL;
+    }
+    victim->mTerminalPos = terminalPos;
+    victim->mLastUse = mUseCount;
+    return victim;
+}
+
+bool BigramDictionary::readBigramList(int terminalPos, BigramList *list) {
+    list->mBigramCount = 0;
+    list->mCount = 0;
+    int pos = getAttributeListPosition(terminalPos);
+    if (NOT_VALID_WORD == pos) return true;
+    if (mTerminalIndex->getWordCount() <= 0) return false;
+
+    const uint8_t* const root = DICT;
     int bigramFlags;
-    int bigramCount = 0;
     do {
         bigramFlags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
-        uint16_t bigramBuffer[MAX_WORD_LENGTH];
         const int bigramPos = BinaryFormat::getAttributeAddressAndForwardPointer(root, bigramFlags,
                 &pos);
-        const int length = BinaryFormat::getWordAtAddress(root, bigramPos, MAX_WORD_LENGTH,
-                bigramBuffer);
+        ++list->mBigramCount;
+        const int frequency = UnigramDictionary::MASK_ATTRIBUTE_FREQUENCY & bigramFlags;
+        const int wordId = mTerminalIndex->getWordId(bigramPos);
+        if (frequency <= 0 || TerminalIndex::NOT_A_WORD_ID == wordId) continue;
+        if (list->mCount >= BIGRAM_CACHE_MAX_BIGRAMS) return false;
 
-        if (checkFirstCharacter(bigramBuffer)) {
-            const int frequency = UnigramDictionary::MASK_ATTRIBUTE_FREQUENCY & bigramFlags;
-            addWordBigram(bigramBuffer, length, frequency);
+        // Insertion sort by decreasing frequency, then increasing length, then in the order
+        // of the dictionary, which is the order addWordBigram puts them in.
+        const int length = min(mTerminalIndex->getWordLength(wordId), MAX_WORD_LENGTH - 1);
+        int insertAt = list->mCount;
+        while (insertAt > 0) {
+            const int previous = insertAt - 1;
+            const int previousLength = min(
+                    mTerminalIndex->getWordLength(list->mWordIds[previous]), MAX_WORD_LENGTH - 1);
+            if (frequency < list->mFrequencies[previous]
+                    || (frequency == list->mFrequencies[previous] && length >= previousLength)) {
+                break;
+            }
+            list->mWordIds[insertAt] = list->mWordIds[previous];
+            list->mFrequencies[insertAt] = list->mFrequencies[previous];
+            list->mFirstChars[insertAt] = list->mFirstChars[previous];
+            insertAt = previous;
         }
-        ++bigramCount;
+        list->mWordIds[insertAt] = wordId;
+        list->mFrequencies[insertAt] = frequency;
+        list->mFirstChars[insertAt] = mTerminalIndex->getFirstChar(wordId);
+        ++list->mCount;
     } while (0 != (UnigramDictionary::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags));
-    return bigramCount;
+    return true;
 }
 
 bool BigramDictionary::checkFirstCharacter(unsigned short *word) {
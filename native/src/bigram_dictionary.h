@@ -17,13 +17,19 @@
 #ifndef LATINIME_BIGRAM_DICTIONARY_H
 #define LATINIME_BIGRAM_DICTIONARY_H
 
+#include <stdint.h>
+
+#include "defines.h"
+
 namespace latinime {
 
 class Dictionary;
+class TerminalIndex;
 class BigramDictionary {
 public:
-    BigramDictionary(const unsigned char *dict, int maxWordLength, int maxAlternatives,
-            const bool isLatestDictVersion, const bool hasBigram, Dictionary *parentDictionary);
+    BigramDictionary(const unsigned char *dict, const int32_t *alphabet, int maxWordLength,
+            int maxAlternatives, const bool isLatestDictVersion, const bool hasBigram,
+            Dictionary *parentDictionary, const TerminalIndex *terminalIndex);
     int getBigrams(unsigned short *word, int length, int *codes, int codesSize,
             unsigned short *outWords, int *frequencies, int maxWordLength, int maxBigrams,
             int maxAlternatives);
@@ -36,19 +42,47 @@ private:
     bool getFirstBitOfByte(int *pos) { return (DICT[*pos] & 0x80) > 0; }
     bool getSecondBitOfByte(int *pos) { return (DICT[*pos] & 0x40) > 0; }
     bool checkFirstCharacter(unsigned short *word);
+    int getAttributeListPosition(int terminalPos);
+
+    // The bigrams of one previous word, decoded to word ids of mTerminalIndex and sorted the
+    // way addWordBigram orders its output, so that a call for the same previous word only
+    // has to filter them against the input.
+    struct BigramList {
+        int mTerminalPos;
+        int mLastUse;
+        // The number of bigrams of the word, which getBigrams returns.
+        int mBigramCount;
+        // The number of them in the arrays below. Bigrams of frequency 0, which addWordBigram
+        // never outputs, are left out.
+        int mCount;
+        int mWordIds[BIGRAM_CACHE_MAX_BIGRAMS];
+        int mFrequencies[BIGRAM_CACHE_MAX_BIGRAMS];
+        unsigned short mFirstChars[BIGRAM_CACHE_MAX_BIGRAMS];
+    };
+    const BigramList *getBigramList(int terminalPos);
+    bool readBigramList(int terminalPos, BigramList *list);
 
     const unsigned char *DICT;
+    const int32_t *ALPHABET;
     const int MAX_WORD_LENGTH;
     const int MAX_ALTERNATIVES;
     const bool IS_LATEST_DICT_VERSION;
     const bool HAS_BIGRAM;
+    // Whether the dictionary guarantees that the bigram lists are sorted by frequency, so that
+    // a list can be cut off at the first bigram too infrequent to be output.
+    const bool BIGRAMS_SORTED_BY_FREQUENCY;
 
     Dictionary *mParentDictionary;
+    const TerminalIndex *const mTerminalIndex;
     int *mBigramFreq;
     int mMaxBigrams;
     unsigned short *mBigramChars;
     int *mInputCodes;
     int mInputLength;
+
+    // Least recently used cache of the bigram lists of the last previous words.
+    BigramList mBigramLists[BIGRAM_CACHE_SIZE];
+    int mUseCount;
 };
 
 } // namespace latinime
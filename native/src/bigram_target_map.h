@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_BIGRAM_TARGET_MAP_H
+#define LATINIME_BIGRAM_TARGET_MAP_H
+
+#include <string.h>
+
+#include "defines.h"
+
+namespace latinime {
+
+// A small open addressing hash map from the terminal positions of the bigram targets of the
+// previous word to their bigram frequencies, so that the traversal can tell in constant time
+// whether the terminal it reached is one of them.
+class BigramTargetMap {
+public:
+    static const int NOT_A_BIGRAM = -1;
+
+    BigramTargetMap() : mCount(0) {
+        memset(mPositions, 0xFF, sizeof(mPositions));
+    }
+
+    void clear() {
+        if (mCount > 0) {
+            memset(mPositions, 0xFF, sizeof(mPositions));
+            mCount = 0;
+        }
+    }
+
+    bool isEmpty() const { return mCount <= 0; }
+
+    // Returns false if the map is full. A position that is already there keeps its first
+    // frequency.
+    bool put(const int position, const int bigramFreq) {
+        if (mCount >= MAX_BIGRAM_TARGETS) return false;
+        int slot = getFirstSlot(position);
+        while (mPositions[slot] != NOT_A_POSITION) {
+            if (mPositions[slot] == position) return true;
+            slot = (slot + 1) & SLOT_MASK;
+        }
+        mPositions[slot] = position;
+        mBigramFreqs[slot] = bigramFreq;
+        ++mCount;
+        return true;
+    }
+
+    int getBigramFreq(const int position) const {
+        if (mCount <= 0) return NOT_A_BIGRAM;
+        int slot = getFirstSlot(position);
+        while (mPositions[slot] != NOT_A_POSITION) {
+            if (mPositions[slot] == position) return mBigramFreqs[slot];
+            slot = (slot + 1) & SLOT_MASK;
+        }
+        return NOT_A_BIGRAM;
+    }
+
+private:
+    static const int NOT_A_POSITION = -1;
+    // Twice as many slots as targets keeps the probe sequences short.
+    static const int SLOT_COUNT = MAX_BIGRAM_TARGETS * 2;
+    static const int SLOT_MASK = SLOT_COUNT - 1;
+
+    static int getFirstSlot(const int position) {
+        // Fibonacci hashing: the positions of nearby words differ in their low bits only.
+        return (static_cast<unsigned int>(position) * 2654435761U >> 16) & SLOT_MASK;
+    }
+
+    int mCount;
+    int mPositions[SLOT_COUNT];
+    int mBigramFreqs[SLOT_COUNT];
+};
+
+} // namespace latinime
+
+#endif // LATINIME_BIGRAM_TARGET_MAP_H
@@ -27,15 +27,38 @@ private:
     const static int32_t CHARACTER_ARRAY_TERMINATOR = 0x1F;
     const static int MULTIPLE_BYTE_CHARACTER_ADDITIONAL_SIZE = 2;
 
+    static int getFoldingOverridesPosition(const uint8_t* const dict);
+
 public:
     const static int UNKNOWN_FORMAT = -1;
     const static int FORMAT_VERSION_1 = 1;
     const static uint16_t FORMAT_VERSION_1_MAGIC_NUMBER = 0x78B1;
+    // Header option: the bigrams of each word are in order of decreasing frequency.
+    const static int OPTION_BIGRAMS_SORTED_BY_FREQUENCY = 0x1;
+    // Header option: the dictionary ends with a trigram section; see TrigramDictionary.
+    const static int OPTION_HAS_TRIGRAMS = 0x2;
+    // Header option: the options are followed by an alphabet, a count byte n then n code
+    // points of 3 bytes each. The one-byte chars 0x20 to 0x20 + n - 1 stand for these code
+    // points, in order, instead of their iso-latin-1 values. The other chars are unchanged.
+    const static int OPTION_HAS_ALPHABET = 0x4;
+    // The size of the table readAlphabet fills. It is indexed by the first byte of a char.
+    const static int ALPHABET_TABLE_SIZE = 256;
+    // Header option: the alphabet, if any, is followed by folding overrides for the locale of
+    // the dictionary, a count byte n then n pairs of 2-byte chars: a char, and the base lower
+    // case it has instead of the one of Dictionary::toBaseLowerCase.
+    const static int OPTION_HAS_FOLDING_OVERRIDES = 0x8;
+    const static int MAX_FOLDING_OVERRIDES = 255;
 
     static int detectFormat(const uint8_t* const dict);
+    static int getOptions(const uint8_t* const dict);
+    static int getHeaderSize(const uint8_t* const dict);
+    static void readAlphabet(const uint8_t* const dict, int32_t* alphabet);
+    static int readFoldingOverrides(const uint8_t* const dict, uint16_t* chars,
+            uint16_t* baseLowerChars);
     static int getGroupCountAndForwardPointer(const uint8_t* const dict, int* pos);
     static uint8_t getFlagsAndForwardPointer(const uint8_t* const dict, int* pos);
-    static int32_t getCharCodeAndForwardPointer(const uint8_t* const dict, int* pos);
+    static int32_t getCharCodeAndForwardPointer(const uint8_t* const dict,
+            const int32_t* const alphabet, int* pos);
     static int readFrequencyWithoutMovingPointer(const uint8_t* const dict, const int pos);
     static int skipOtherCharacters(const uint8_t* const dict, const int pos);
     static int skipAttributes(const uint8_t* const dict, const int pos);
@@ -48,10 +71,29 @@ public:
     static bool hasChildrenInFlags(const uint8_t flags);
     static int getAttributeAddressAndForwardPointer(const uint8_t* const dict, const uint8_t flags,
             int *pos);
-    static int getTerminalPosition(const uint8_t* const root, const uint16_t* const inWord,
-            const int length);
-    static int getWordAtAddress(const uint8_t* const root, const int address, const int maxDepth,
-            uint16_t* outWord);
+    // The nodes that the last call to getTerminalPosition entered, so that the next call can
+    // start from the node where the common prefix of both words ends.
+    struct TriePath {
+        TriePath() : mDepth(1) {
+            mNodePositions[0] = 0;
+            mWordPositions[0] = 0;
+        }
+        int mDepth;
+        int mNodePositions[MAX_WORD_LENGTH_INTERNAL];
+        // The number of characters of the word matched before entering the node.
+        int mWordPositions[MAX_WORD_LENGTH_INTERNAL];
+    };
+
+    static int getTerminalPosition(const uint8_t* const root, const int32_t* const alphabet,
+            const uint16_t* const inWord, const int length);
+    // Same as above, but starts from the last node of path whose prefix is at most
+    // prefixLength characters long, and updates path. The first prefixLength characters of
+    // inWord must be the same as in the previous word looked up with this path.
+    static int getTerminalPosition(const uint8_t* const root, const int32_t* const alphabet,
+            const uint16_t* const inWord, const int length, const int prefixLength,
+            TriePath* path);
+    static int getWordAtAddress(const uint8_t* const root, const int32_t* const alphabet,
+            const int address, const int maxDepth, uint16_t* outWord);
 };
 
 inline int BinaryFormat::detectFormat(const uint8_t* const dict) {
@@ -60,6 +102,55 @@ inline int BinaryFormat::detectFormat(const uint8_t* const dict) {
     return UNKNOWN_FORMAT;
 }
 
+inline int BinaryFormat::getOptions(const uint8_t* const dict) {
+    // Magic number (2 bytes), version (1 byte), then the options flags in big endian.
+    return (dict[3] << 8) + dict[4];
+}
+
+// The position of the folding overrides, which is the end of the alphabet.
+inline int BinaryFormat::getFoldingOverridesPosition(const uint8_t* const dict) {
+    if (0 == (getOptions(dict) & OPTION_HAS_ALPHABET)) return NEW_DICTIONARY_HEADER_SIZE;
+    return NEW_DICTIONARY_HEADER_SIZE + 1 + dict[NEW_DICTIONARY_HEADER_SIZE] * 3;
+}
+
+// The size of the header, that is the position of the root of the trie in the dictionary.
+inline int BinaryFormat::getHeaderSize(const uint8_t* const dict) {
+    const int pos = getFoldingOverridesPosition(dict);
+    if (0 == (getOptions(dict) & OPTION_HAS_FOLDING_OVERRIDES)) return pos;
+    return pos + 1 + dict[pos] * 4;
+}
+
+// Fills the table of ALPHABET_TABLE_SIZE code points that getCharCodeAndForwardPointer looks
+// the one-byte chars up in. Without an alphabet, this is iso-latin-1.
+inline void BinaryFormat::readAlphabet(const uint8_t* const dict, int32_t* alphabet) {
+    for (int i = 0; i < ALPHABET_TABLE_SIZE; ++i) {
+        alphabet[i] = i;
+    }
+    if (0 == (getOptions(dict) & OPTION_HAS_ALPHABET)) return;
+    const int count = min(static_cast<int>(dict[NEW_DICTIONARY_HEADER_SIZE]),
+            ALPHABET_TABLE_SIZE - MINIMAL_ONE_BYTE_CHARACTER_VALUE);
+    const uint8_t* const codePoints = dict + NEW_DICTIONARY_HEADER_SIZE + 1;
+    for (int i = 0; i < count; ++i) {
+        alphabet[MINIMAL_ONE_BYTE_CHARACTER_VALUE + i] = (codePoints[i * 3] << 16)
+                + (codePoints[i * 3 + 1] << 8) + codePoints[i * 3 + 2];
+    }
+}
+
+// Reads the folding overrides into chars and baseLowerChars, which must hold
+// MAX_FOLDING_OVERRIDES chars. Returns their count, 0 without the option.
+inline int BinaryFormat::readFoldingOverrides(const uint8_t* const dict, uint16_t* chars,
+        uint16_t* baseLowerChars) {
+    if (0 == (getOptions(dict) & OPTION_HAS_FOLDING_OVERRIDES)) return 0;
+    const int pos = getFoldingOverridesPosition(dict);
+    const int count = dict[pos];
+    const uint8_t* const pairs = dict + pos + 1;
+    for (int i = 0; i < count; ++i) {
+        chars[i] = (pairs[i * 4] << 8) + pairs[i * 4 + 1];
+        baseLowerChars[i] = (pairs[i * 4 + 2] << 8) + pairs[i * 4 + 3];
+    }
+    return count;
+}
+
 inline int BinaryFormat::getGroupCountAndForwardPointer(const uint8_t* const dict, int* pos) {
     return dict[(*pos)++];
 }
@@ -68,7 +159,8 @@ inline uint8_t BinaryFormat::getFlagsAndForwardPointer(const uint8_t* const dict
     return dict[(*pos)++];
 }
 
-inline int32_t BinaryFormat::getCharCodeAndForwardPointer(const uint8_t* const dict, int* pos) {
+inline int32_t BinaryFormat::getCharCodeAndForwardPointer(const uint8_t* const dict,
+        const int32_t* const alphabet, int* pos) {
     const int origin = *pos;
     const int32_t character = dict[origin];
     if (character < MINIMAL_ONE_BYTE_CHARACTER_VALUE) {
@@ -83,7 +175,7 @@ inline int32_t BinaryFormat::getCharCodeAndForwardPointer(const uint8_t* const d
         }
     } else {
         *pos = origin + 1;
-        return character;
+        return alphabet[character];
     }
 }
 
@@ -224,9 +316,22 @@ inline int BinaryFormat::getAttributeAddressAndForwardPointer(const uint8_t* con
 // This function gets the byte position of the last chargroup of the exact matching word in the
 // dictionary. If no match is found, it returns NOT_VALID_WORD.
 inline int BinaryFormat::getTerminalPosition(const uint8_t* const root,
-        const uint16_t* const inWord, const int length) {
-    int pos = 0;
-    int wordPos = 0;
+        const int32_t* const alphabet, const uint16_t* const inWord, const int length) {
+    TriePath path;
+    return getTerminalPosition(root, alphabet, inWord, length, 0, &path);
+}
+
+inline int BinaryFormat::getTerminalPosition(const uint8_t* const root,
+        const int32_t* const alphabet, const uint16_t* const inWord, const int length,
+        const int prefixLength, TriePath* path) {
+    // Resuming from the node entered after the last character of the word would read past the
+    // word, so at most length - 1 characters are reused.
+    const int reusableLength = min(prefixLength, length - 1);
+    while (path->mDepth > 1 && path->mWordPositions[path->mDepth - 1] > reusableLength) {
+        --path->mDepth;
+    }
+    int pos = path->mNodePositions[path->mDepth - 1];
+    int wordPos = path->mWordPositions[path->mDepth - 1];
 
     while (true) {
         // If we already traversed the tree further than the word is long, there means
@@ -240,14 +345,14 @@ inline int BinaryFormat::getTerminalPosition(const uint8_t* const root,
             if (0 >= charGroupCount) return NOT_VALID_WORD;
             const int charGroupPos = pos;
             const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
-            int32_t character = BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
+            int32_t character = BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
             if (character == wChar) {
                 // This is the correct node. Only one character group may start with the same
                 // char within a node, so either we found our match in this node, or there is
                 // no match and we can return NOT_VALID_WORD. So we will check all the characters
                 // in this character group indeed does match.
                 if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags) {
-                    character = BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
+                    character = BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
                     while (NOT_A_CHARACTER != character) {
                         ++wordPos;
                         // If we shoot the length of the word we search for, or if we find a single
@@ -256,7 +361,8 @@ inline int BinaryFormat::getTerminalPosition(const uint8_t* const root,
                         // match the word on the first character, but not matching the whole word).
                         if (wordPos > length) return NOT_VALID_WORD;
                         if (inWord[wordPos] != character) return NOT_VALID_WORD;
-                        character = BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
+                        character =
+                                BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
                     }
                 }
                 // If we come here we know that so far, we do match. Either we are on a terminal
@@ -278,6 +384,11 @@ inline int BinaryFormat::getTerminalPosition(const uint8_t* const root,
                 // we need to traverse children. Put the pointer on the children position, and
                 // break
                 pos = BinaryFormat::readChildrenPosition(root, flags, pos);
+                if (path->mDepth < MAX_WORD_LENGTH_INTERNAL) {
+                    path->mNodePositions[path->mDepth] = pos;
+                    path->mWordPositions[path->mDepth] = wordPos;
+                    ++path->mDepth;
+                }
                 break;
             } else {
                 // This chargroup does not match, so skip the remaining part and go to the next.
@@ -304,13 +415,14 @@ inline int BinaryFormat::getTerminalPosition(const uint8_t* const root,
 // than the address we look for, and we have to descend the z node).
 /* Parameters :
  * root: the dictionary buffer
+ * alphabet: the table filled by readAlphabet
  * address: the byte position of the last chargroup of the word we are searching for (this is
  *   what is stored as the "bigram address" in each bigram)
  * outword: an array to write the found word, with MAX_WORD_LENGTH size.
  * Return value : the length of the word, of 0 if the word was not found.
  */
-inline int BinaryFormat::getWordAtAddress(const uint8_t* const root, const int address,
-        const int maxDepth, uint16_t* outWord) {
+inline int BinaryFormat::getWordAtAddress(const uint8_t* const root,
+        const int32_t* const alphabet, const int address, const int maxDepth, uint16_t* outWord) {
     int pos = 0;
     int wordPos = 0;
 
@@ -328,19 +440,19 @@ inline int BinaryFormat::getWordAtAddress(const uint8_t* const root, const int a
                  --charGroupCount) {
             const int startPos = pos;
             const uint8_t flags = getFlagsAndForwardPointer(root, &pos);
-            const int32_t character = getCharCodeAndForwardPointer(root, &pos);
+            const int32_t character = getCharCodeAndForwardPointer(root, alphabet, &pos);
             if (address == startPos) {
                 // We found the address. Copy the rest of the word in the buffer and return
                 // the length.
                 outWord[wordPos] = character;
                 if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags) {
-                    int32_t nextChar = getCharCodeAndForwardPointer(root, &pos);
+                    int32_t nextChar = getCharCodeAndForwardPointer(root, alphabet, &pos);
                     // We count chars in order to avoid infinite loops if the file is broken or
                     // if there is some other bug
                     int charCount = maxDepth;
                     while (-1 != nextChar && --charCount > 0) {
                         outWord[++wordPos] = nextChar;
-                        nextChar = getCharCodeAndForwardPointer(root, &pos);
+                        nextChar = getCharCodeAndForwardPointer(root, alphabet, &pos);
                     }
                 }
                 return ++wordPos;
@@ -392,17 +504,18 @@ inline int BinaryFormat::getWordAtAddress(const uint8_t* const root, const int a
                 if (0 != lastCandidateGroupPos) {
                     const uint8_t lastFlags =
                             getFlagsAndForwardPointer(root, &lastCandidateGroupPos);
-                    const int32_t lastChar =
-                            getCharCodeAndForwardPointer(root, &lastCandidateGroupPos);
+                    const int32_t lastChar = getCharCodeAndForwardPointer(root, alphabet,
+                            &lastCandidateGroupPos);
                     // We copy all the characters in this group to the buffer
                     outWord[wordPos] = lastChar;
                     if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & lastFlags) {
-                        int32_t nextChar =
-                                getCharCodeAndForwardPointer(root, &lastCandidateGroupPos);
+                        int32_t nextChar = getCharCodeAndForwardPointer(root, alphabet,
+                                &lastCandidateGroupPos);
                         int charCount = maxDepth;
                         while (-1 != nextChar && --charCount > 0) {
                             outWord[++wordPos] = nextChar;
-                            nextChar = getCharCodeAndForwardPointer(root, &lastCandidateGroupPos);
+                            nextChar = getCharCodeAndForwardPointer(root, alphabet,
+                                    &lastCandidateGroupPos);
                         }
                     }
                     ++wordPos;
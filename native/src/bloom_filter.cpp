@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#define LOG_TAG "LatinIME: bloom_filter.cpp"
+
+#include "binary_format.h"
+#include "bloom_filter.h"
+#include "defines.h"
+
+namespace latinime {
+
+BloomFilter::BloomFilter(const uint8_t *const root, const int32_t *const alphabet,
+        const int bitsPerWord)
+        : mRoot(root), mAlphabet(alphabet), mHashCount(0), mBlockCount(0), mBits(NULL) {
+    const int wordCount = visitWords(false);
+    if (wordCount <= 0 || bitsPerWord <= 0) return;
+    // The false positive rate is the lowest with bitsPerWord * ln 2 hash functions.
+    mHashCount = max(1, min(MAX_HASH_COUNT, (bitsPerWord * 693 + 500) / 1000));
+    const int64_t bitCount = static_cast<int64_t>(wordCount) * bitsPerWord;
+    mBlockCount = static_cast<uint32_t>((bitCount + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK);
+    mBits = new uint32_t[mBlockCount * INTS_PER_BLOCK];
+    memset(mBits, 0, sizeof(mBits[0]) * mBlockCount * INTS_PER_BLOCK);
+    visitWords(true);
+    if (DEBUG_DICT) {
+        LOGI("BloomFilter: %d words, %d blocks, %d hashes", wordCount, mBlockCount, mHashCount);
+    }
+}
+
+BloomFilter::~BloomFilter() {
+    delete[] mBits;
+}
+
+// Walks the whole trie depth first, hashing the words as it goes. When fill is false, this only
+// counts the words; when it is true, it also sets their bits. Returns the word count, or 0 if
+// the trie is too deep to be walked, in which case the filter must stay empty.
+int BloomFilter::visitWords(const bool fill) {
+    int positions[MAX_WORD_LENGTH_INTERNAL];
+    int remainingGroupCounts[MAX_WORD_LENGTH_INTERNAL];
+    uint32_t prefixHashes[MAX_WORD_LENGTH_INTERNAL];
+    int wordCount = 0;
+
+    int pos = 0;
+    remainingGroupCounts[0] = BinaryFormat::getGroupCountAndForwardPointer(mRoot, &pos);
+    positions[0] = pos;
+    prefixHashes[0] = FNV_OFFSET_BASIS;
+    int depth = 0;
+    while (depth >= 0) {
+        if (remainingGroupCounts[depth] <= 0) {
+            --depth;
+            continue;
+        }
+        --remainingGroupCounts[depth];
+        pos = positions[depth];
+        const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(mRoot, &pos);
+        int32_t character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+        uint32_t hash = hashFnvStep(prefixHashes[depth], character);
+        if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags) {
+            character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+            while (NOT_A_CHARACTER != character) {
+                hash = hashFnvStep(hash, character);
+                character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+            }
+        }
+        if (UnigramDictionary::FLAG_IS_TERMINAL & flags) {
+            if (fill) setOrTestBits(hash, true);
+            ++wordCount;
+        }
+        pos = BinaryFormat::skipFrequency(flags, pos);
+        const int childrenPos = BinaryFormat::readChildrenPosition(mRoot, flags, pos);
+        positions[depth] = BinaryFormat::skipChildrenPosAndAttributes(mRoot, flags, pos);
+        if (childrenPos >= 0) {
+            if (depth + 1 >= MAX_WORD_LENGTH_INTERNAL) return 0;
+            ++depth;
+            pos = childrenPos;
+            remainingGroupCounts[depth] = BinaryFormat::getGroupCountAndForwardPointer(mRoot,
+                    &pos);
+            positions[depth] = pos;
+            prefixHashes[depth] = hash;
+        }
+    }
+    return wordCount;
+}
+
+} // namespace latinime
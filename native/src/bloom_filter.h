@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_BLOOM_FILTER_H
+#define LATINIME_BLOOM_FILTER_H
+
+#include <stdint.h>
+
+#include "hash_utils.h"
+
+namespace latinime {
+
+// A blocked Bloom filter over all the words of the dictionary, so that isValidWord can reject
+// most of the words that are not in the dictionary without walking down the trie. All the bits
+// of a word are in the same block of 64 bytes, so testing a word reads one cache line.
+// The filter is built when the dictionary is opened. It never rejects a word of the dictionary;
+// if it can't guarantee that (the trie is deeper than MAX_WORD_LENGTH_INTERNAL), it stays empty.
+class BloomFilter {
+public:
+    BloomFilter(const uint8_t *const root, const int32_t *const alphabet, const int bitsPerWord);
+    ~BloomFilter();
+    bool isEmpty() const { return mBlockCount <= 0; }
+    // Returns false only if the word is certainly not in the dictionary.
+    bool mayContain(const uint16_t *word, const int length) const;
+
+private:
+    static const int BITS_PER_BLOCK = 512;
+    static const int INTS_PER_BLOCK = BITS_PER_BLOCK / 32;
+    static const int MAX_HASH_COUNT = 16;
+
+    int visitWords(const bool fill);
+    uint32_t *getBlock(const uint32_t hash) const;
+    bool setOrTestBits(const uint32_t prefixHash, const bool set) const;
+
+    const uint8_t *const mRoot;
+    const int32_t *const mAlphabet;
+    int mHashCount;
+    uint32_t mBlockCount;
+    uint32_t *mBits;
+};
+
+inline uint32_t *BloomFilter::getBlock(const uint32_t hash) const {
+    // Scales the hash to the block count without a division.
+    const uint32_t block = static_cast<uint32_t>(
+            (static_cast<uint64_t>(hash) * mBlockCount) >> 32);
+    return mBits + block * INTS_PER_BLOCK;
+}
+
+// Sets the bits of a word if set is true, else returns whether they are all set. prefixHash is
+// the FNV-1a hash of the chars of the word. Filling and testing both derive the bits here: if
+// they derived them differently, the filter would reject words of the dictionary.
+inline bool BloomFilter::setOrTestBits(const uint32_t prefixHash, const bool set) const {
+    const uint32_t hash = finalizeHash(prefixHash);
+    uint32_t *const block = getBlock(hash);
+    // The block was picked with the high bits of the hash; the bits in the block come from
+    // a linear congruential sequence seeded with it.
+    uint32_t bits = hash * GOLDEN_RATIO_MULTIPLIER;
+    for (int i = 0; i < mHashCount; ++i) {
+        const uint32_t bit = bits >> 23;
+        const uint32_t mask = 1U << (bit & 31);
+        if (set) {
+            block[bit >> 5] |= mask;
+        } else if (!(block[bit >> 5] & mask)) {
+            return false;
+        }
+        bits = bits * 1664525U + 1013904223U;
+    }
+    return true;
+}
+
+inline bool BloomFilter::mayContain(const uint16_t *word, const int length) const {
+    if (mBlockCount <= 0) return true;
+    // FNV-1a on the characters, like visitWords hashes the prefixes of the trie.
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (int i = 0; i < length; ++i) {
+        hash = hashFnvStep(hash, word[i]);
+    }
+    return setOrTestBits(hash, false);
+}
+
+} // namespace latinime
+
+#endif // LATINIME_BLOOM_FILTER_H
@@ -17,10 +17,48 @@
 #ifndef LATINIME_CHAR_UTILS_H
 #define LATINIME_CHAR_UTILS_H
 
+#include <stdint.h>
+
 namespace latinime {
 
 unsigned short latin_tolower(unsigned short c);
 
+// See Dictionary::toBaseLowerCase.
+extern const uint8_t BASE_LOWER_CASE_BLOCKS[256];
+extern const uint16_t BASE_LOWER_CASE_DELTAS[];
+
+// The base lower case of the chars of one dictionary: the one of Dictionary::toBaseLowerCase,
+// where the dictionary may override some chars for its locale, like the dotless i of Turkish.
+// The overrides go into copies of the blocks they change, so a look up is the same two loads
+// and add with or without them.
+class BaseLowerCaseTable {
+public:
+    BaseLowerCaseTable();
+    ~BaseLowerCaseTable();
+    // Makes each of the count chars fold to the base lower case at the same index. Returns
+    // false, and keeps the default, if they change more blocks than the table can index.
+    bool setOverrides(const uint16_t *chars, const uint16_t *baseLowerChars, const int count);
+    unsigned short toBaseLowerCase(const unsigned short c) const {
+        return c + mDeltas[(mBlocks[c >> 8] << 8) | (c & 0xFF)];
+    }
+    // Writes the base lower case of the length chars of word to outWord, which may be word.
+    void toBaseLowerCase(const unsigned short *word, const int length,
+            unsigned short *outWord) const;
+
+private:
+    static const int BLOCK_COUNT = 256;
+    static const int BLOCK_SIZE = 256;
+    // The number of blocks of BASE_LOWER_CASE_DELTAS.
+    static const int DEFAULT_BLOCK_COUNT = 16;
+
+    uint8_t mBlocks[BLOCK_COUNT];
+    const uint16_t *mDeltas;
+    // The copy of the default deltas with the overridden blocks after them, or NULL.
+    uint16_t *mOverriddenDeltas;
+    // Whether only 'A' to 'Z' change in the ASCII range, as by default.
+    bool mHasDefaultAscii;
+};
+
 } // namespace latinime
 
 #endif // LATINIME_CHAR_UTILS_H
@@ -16,13 +16,16 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
 #define LOG_TAG "LatinIME: correction.cpp"
 
+#include "basechars.h"
 #include "correction.h"
 #include "dictionary.h"
+#include "input_context.h"
 #include "proximity_info.h"
 
 namespace latinime {
@@ -79,6 +82,7 @@ inline static void initEditDistance(int *editDistanceTable) {
     }
 }
 
+// The input and the output are in base lower case already.
 inline static void calcEditDistanceOneStep(int *editDistanceTable, const unsigned short *input,
         const int inputLength, const unsigned short *output, const int outputLength) {
     // Let dp[i][j] be editDistanceTable[i * (inputLength + 1) + j].
@@ -89,22 +93,20 @@ inline static void calcEditDistanceOneStep(int *editDistanceTable, const unsigne
     const int *const prevprev =
             outputLength >= 2 ? editDistanceTable + (outputLength - 2) * (inputLength + 1) : NULL;
     current[0] = outputLength;
-    const uint32_t co = Dictionary::toBaseLowerCase(output[outputLength - 1]);
-    const uint32_t prevCO =
-            outputLength >= 2 ? Dictionary::toBaseLowerCase(output[outputLength - 2]) : 0;
+    const uint32_t co = output[outputLength - 1];
+    const uint32_t prevCO = outputLength >= 2 ? output[outputLength - 2] : 0;
     for (int i = 1; i <= inputLength; ++i) {
-        const uint32_t ci = Dictionary::toBaseLowerCase(input[i - 1]);
+        const uint32_t ci = input[i - 1];
         const uint16_t cost = (ci == co) ? 0 : 1;
         current[i] = min(current[i - 1] + 1, min(prev[i] + 1, prev[i - 1] + cost));
-        if (i >= 2 && prevprev && ci == prevCO
-                && co == Dictionary::toBaseLowerCase(input[i - 2])) {
+        if (i >= 2 && prevprev && ci == prevCO && co == input[i - 2]) {
             current[i] = min(current[i], prevprev[i - 2] + 1);
         }
     }
 }
 
 inline static int getCurrentEditDistance(
-        int *editDistanceTable, const int inputLength, const int outputLength) {
+        const int *editDistanceTable, const int inputLength, const int outputLength) {
     return editDistanceTable[(inputLength + 1) * (outputLength + 1) - 1];
 }
 
@@ -114,7 +116,7 @@ inline static int getCurrentEditDistance(
 static const char QUOTE = '\'';
 
 inline bool Correction::isQuote(const unsigned short c) {
-    const unsigned short userTypedChar = mProximityInfo->getPrimaryCharAt(mInputIndex);
+    const unsigned short userTypedChar = mInputContext->getPrimaryCharAt(mInputIndex);
     return (c == QUOTE && userTypedChar != QUOTE);
 }
 
@@ -122,14 +124,16 @@ inline bool Correction::isQuote(const unsigned short c) {
 // Correction //
 ////////////////
 
-Correction::Correction(const int typedLetterMultiplier, const int fullWordMultiplier)
-        : TYPED_LETTER_MULTIPLIER(typedLetterMultiplier), FULL_WORD_MULTIPLIER(fullWordMultiplier) {
+Correction::Correction(const int typedLetterMultiplier, const int fullWordMultiplier,
+        const RankingParams *rankingParams)
+        : TYPED_LETTER_MULTIPLIER(typedLetterMultiplier), FULL_WORD_MULTIPLIER(fullWordMultiplier),
+          mRankingParams(rankingParams) {
     initEditDistance(mEditDistanceTable);
 }
 
-void Correction::initCorrection(const ProximityInfo *pi, const int inputLength,
+void Correction::initCorrection(const InputContext *inputContext, const int inputLength,
         const int maxDepth) {
-    mProximityInfo = pi;
+    mInputContext = inputContext;
     mInputLength = inputLength;
     mMaxDepth = maxDepth;
     mMaxEditDistance = mInputLength < 5 ? 2 : mInputLength / 2;
@@ -145,8 +149,7 @@ void Correction::initCorrectionState(
 }
 
 void Correction::setCorrectionParams(const int skipPos, const int excessivePos,
-        const int transposedPos, const int spaceProximityPos, const int missingSpacePos,
-        const bool useFullEditDistance) {
+        const int transposedPos, const int spaceProximityPos, const int missingSpacePos) {
     // TODO: remove
     mTransposedPos = transposedPos;
     mExcessivePos = excessivePos;
@@ -158,7 +161,6 @@ void Correction::setCorrectionParams(const int skipPos, const int excessivePos,
 
     mSpaceProximityPos = spaceProximityPos;
     mMissingSpacePos = missingSpacePos;
-    mUseFullEditDistance = useFullEditDistance;
 }
 
 void Correction::checkState() {
@@ -178,17 +180,115 @@ int Correction::getFreqForSplitTwoWords(const int firstFreq, const int secondFre
             firstFreq, secondFreq, this, word);
 }
 
+template <typename Policy>
 int Correction::getFinalFreq(const int freq, unsigned short **word, int *wordLength) {
     const int outputIndex = mTerminalOutputIndex;
     const int inputIndex = mTerminalInputIndex;
     *wordLength = outputIndex + 1;
-    if (mProximityInfo->sameAsTyped(mWord, outputIndex + 1) || outputIndex < MIN_SUGGEST_DEPTH) {
+    if (mInputContext->sameAsTyped(mWord, outputIndex + 1) || outputIndex < MIN_SUGGEST_DEPTH) {
         return -1;
     }
 
     *word = mWord;
-    return Correction::RankingAlgorithm::calculateFinalFreq(
-            inputIndex, outputIndex, freq, mEditDistanceTable, this);
+    return Correction::RankingAlgorithm::calculateFinalFreq<Policy>(inputIndex, outputIndex, freq,
+            getCurrentEditDistance(mEditDistanceTable, mInputLength, outputIndex + 1), this);
+}
+
+// Must be called on a terminal for which getFinalFreq() did not return -1.
+void Correction::saveTerminalState(const int freq, TerminalState *state) const {
+    const int outputLength = mTerminalOutputIndex + 1;
+    state->mFreq = freq;
+    state->mInputIndex = mTerminalInputIndex;
+    state->mOutputIndex = mTerminalOutputIndex;
+    state->mEditDistance = getCurrentEditDistance(mEditDistanceTable, mInputLength, outputLength);
+    state->mSkippedCount = mSkippedCount;
+    state->mTransposedCount = mTransposedCount;
+    state->mExcessiveCount = mExcessiveCount;
+    state->mProximityCount = mProximityCount;
+    state->mExcessivePos = mExcessivePos;
+    state->mLastCharExceeded = mLastCharExceeded;
+    memcpy(state->mWord, mWord, outputLength * sizeof(mWord[0]));
+    memcpy(state->mTouchIndices, mTouchIndices, outputLength * sizeof(mTouchIndices[0]));
+}
+
+// Scores a terminal saved by saveTerminalState() again. This overwrites the current state, so
+// it may only be called after the traversal.
+template <typename Policy>
+int Correction::getFinalFreq(const TerminalState *state, unsigned short **word, int *wordLength) {
+    const int outputLength = state->mOutputIndex + 1;
+    mTerminalInputIndex = state->mInputIndex;
+    mTerminalOutputIndex = state->mOutputIndex;
+    mSkippedCount = state->mSkippedCount;
+    mTransposedCount = state->mTransposedCount;
+    mExcessiveCount = state->mExcessiveCount;
+    mProximityCount = state->mProximityCount;
+    mExcessivePos = state->mExcessivePos;
+    mLastCharExceeded = state->mLastCharExceeded;
+    memcpy(mWord, state->mWord, outputLength * sizeof(mWord[0]));
+    memcpy(mTouchIndices, state->mTouchIndices, outputLength * sizeof(mTouchIndices[0]));
+
+    *wordLength = outputLength;
+    *word = mWord;
+    return Correction::RankingAlgorithm::calculateFinalFreq<Policy>(state->mInputIndex,
+            state->mOutputIndex, state->mFreq, state->mEditDistance, this);
+}
+
+// Same as getFinalFreq, but scores with the log-domain model. Returns the cost, or -1 if the
+// word should not be suggested.
+template <typename Policy>
+int Correction::getFinalLogCost(const int freq, unsigned short **word, int *wordLength) {
+    const int outputIndex = mTerminalOutputIndex;
+    const int inputIndex = mTerminalInputIndex;
+    *wordLength = outputIndex + 1;
+    if (mInputContext->sameAsTyped(mWord, outputIndex + 1) || outputIndex < MIN_SUGGEST_DEPTH) {
+        return -1;
+    }
+
+    *word = mWord;
+    return Correction::RankingAlgorithm::calculateLogCost<Policy>(
+            inputIndex, outputIndex, freq, this);
+}
+
+// A lower bound of the log cost of any word under the current node. Only the costs that no
+// later correction can take back are counted: a provisional last excessive char or the first
+// half of a transposition may still turn out to be something else, and a proximity char may
+// cost nothing with the touch position correction.
+int Correction::getLogCostLowerBound() const {
+    const int editCorrectionCount = mSkippedCount + mTransposedCount / 2
+            + max(0, mExcessiveCount - (mLastCharExceeded ? 1 : 0));
+    const int minEditCorrectionCost = min(mRankingParams->mLogCostMissingCharacter,
+            min(mRankingParams->mLogCostExcessiveCharacter,
+                    mRankingParams->mLogCostTransposedCharacters));
+    int cost = editCorrectionCount * minEditCorrectionCost;
+    if (editCorrectionCount > 0 || mProximityCount > 0) {
+        cost += mRankingParams->mLogCostNotExactMatch;
+    }
+    return cost;
+}
+
+// The score calculateFinalFreq gives to an exact match of the most frequent word
+double Correction::getPerfectFreq() const {
+    double perfectFreq = (double)MAX_FREQ * MAX_FREQ * FULL_WORD_MULTIPLIER
+            * mRankingParams->mFullMatchedWordsPromotionRate / 100;
+    for (int i = 0; i < mInputLength; ++i) {
+        perfectFreq *= TYPED_LETTER_MULTIPLIER;
+    }
+    return perfectFreq;
+}
+
+// The adapter to the scale of calculateFinalFreq: a cost of 0 maps to getPerfectFreq(), and
+// every LOG_COST_ONE_BIT of cost halves it.
+int Correction::logCostToFreq(const int cost) const {
+    const double freq = getPerfectFreq() * pow(2.0, -(double)cost / LOG_COST_ONE_BIT);
+    return freq >= S_INT_MAX ? S_INT_MAX : (int)freq;
+}
+
+// The inverse of logCostToFreq, rounded down.
+int Correction::freqToLogCost(const int freq) const {
+    if (freq <= 0) {
+        return S_INT_MAX;
+    }
+    return max(0, (int)(log(getPerfectFreq() / freq) / log(2.0) * LOG_COST_ONE_BIT));
 }
 
 bool Correction::initProcessState(const int outputIndex) {
@@ -283,17 +383,18 @@ bool Correction::needsToPrune() const {
     return mOutputIndex - 1 >= mMaxDepth || mProximityCount > mMaxEditDistance;
 }
 
-void Correction::addCharToCurrentWord(const int32_t c) {
+void Correction::addCharToCurrentWord(const int32_t c, const unsigned short baseLowerC) {
     mWord[mOutputIndex] = c;
-    const unsigned short *primaryInputWord = mProximityInfo->getPrimaryInputWord();
-    calcEditDistanceOneStep(mEditDistanceTable, primaryInputWord, mInputLength,
-            mWord, mOutputIndex + 1);
+    mBaseLowerWord[mOutputIndex] = baseLowerC;
+    calcEditDistanceOneStep(mEditDistanceTable, mInputContext->getBaseLowerPrimaryInputWord(),
+            mInputLength, mBaseLowerWord, mOutputIndex + 1);
 }
 
 // TODO: inline?
-Correction::CorrectionType Correction::processSkipChar(
-        const int32_t c, const bool isTerminal, const bool inputIndexIncremented) {
-    addCharToCurrentWord(c);
+Correction::CorrectionType Correction::processSkipChar(const int32_t c,
+        const unsigned short baseLowerC, const bool isTerminal,
+        const bool inputIndexIncremented) {
+    addCharToCurrentWord(c, baseLowerC);
     if (needsToTraverseAllNodes() && isTerminal) {
         mTerminalInputIndex = mInputIndex - (inputIndexIncremented ? 1 : 0);
         mTerminalOutputIndex = mOutputIndex;
@@ -309,6 +410,9 @@ inline bool isEquivalentChar(ProximityInfo::ProximityType type) {
     return type == ProximityInfo::EQUIVALENT_CHAR;
 }
 
+// The touch indices are only read by the touch position correction, so the policy lets us skip
+// recording them altogether when it is off.
+template <typename Policy>
 Correction::CorrectionType Correction::processCharAndCalcState(
         const int32_t c, const bool isTerminal) {
     const int correctionCount = (mSkippedCount + mExcessiveCount + mTransposedCount);
@@ -316,30 +420,38 @@ Correction::CorrectionType Correction::processCharAndCalcState(
     const bool noCorrectionsHappenedSoFar = correctionCount == 0;
     const bool canTryCorrection = noCorrectionsHappenedSoFar;
     int proximityIndex = 0;
-    mDistances[mOutputIndex] = NOT_A_DISTANCE;
+    if (Policy::TOUCH_POSITION_CORRECTION) {
+        mTouchIndices[mOutputIndex] = NOT_A_INDEX;
+    }
+    // The char may be matched against several input indices below; fold it only once.
+    const unsigned short baseLowerC = mInputContext->getBaseLowerCase()->toBaseLowerCase(c);
 
     if (mNeedsToTraverseAllNodes || isQuote(c)) {
         bool incremented = false;
         if (mLastCharExceeded && mInputIndex == mInputLength - 1) {
             // TODO: Do not check the proximity if EditDistance exceeds the threshold
             const ProximityInfo::ProximityType matchId =
-                    mProximityInfo->getMatchedProximityId(mInputIndex, c, true, &proximityIndex);
+                    mInputContext->getMatchedProximityId(
+                            mInputIndex, c, baseLowerC, true, &proximityIndex);
             if (isEquivalentChar(matchId)) {
                 mLastCharExceeded = false;
                 --mExcessiveCount;
-                mDistances[mOutputIndex] =
-                        mProximityInfo->getNormalizedSquaredDistance(mInputIndex, 0);
+                if (Policy::TOUCH_POSITION_CORRECTION) {
+                    mTouchIndices[mOutputIndex] = mInputContext->getTouchIndex(mInputIndex, 0);
+                }
             } else if (matchId == ProximityInfo::NEAR_PROXIMITY_CHAR) {
                 mLastCharExceeded = false;
                 --mExcessiveCount;
                 ++mProximityCount;
-                mDistances[mOutputIndex] =
-                        mProximityInfo->getNormalizedSquaredDistance(mInputIndex, proximityIndex);
+                if (Policy::TOUCH_POSITION_CORRECTION) {
+                    mTouchIndices[mOutputIndex] =
+                            mInputContext->getTouchIndex(mInputIndex, proximityIndex);
+                }
             }
             incrementInputIndex();
             incremented = true;
         }
-        return processSkipChar(c, isTerminal, incremented);
+        return processSkipChar(c, baseLowerC, isTerminal, incremented);
     }
 
     if (mExcessivePos >= 0) {
@@ -372,7 +484,8 @@ Correction::CorrectionType Correction::processCharAndCalcState(
 
     bool secondTransposing = false;
     if (mTransposedCount % 2 == 1) {
-        if (isEquivalentChar(mProximityInfo->getMatchedProximityId(mInputIndex - 1, c, false))) {
+        if (isEquivalentChar(
+                mInputContext->getMatchedProximityId(mInputIndex - 1, c, baseLowerC, false))) {
             ++mTransposedCount;
             secondTransposing = true;
         } else if (mCorrectionStates[mOutputIndex].mExceeding) {
@@ -395,15 +508,15 @@ Correction::CorrectionType Correction::processCharAndCalcState(
     const bool checkProximityChars = noCorrectionsHappenedSoFar ||  mProximityCount == 0;
     ProximityInfo::ProximityType matchedProximityCharId = secondTransposing
             ? ProximityInfo::EQUIVALENT_CHAR
-            : mProximityInfo->getMatchedProximityId(
-                    mInputIndex, c, checkProximityChars, &proximityIndex);
+            : mInputContext->getMatchedProximityId(
+                    mInputIndex, c, baseLowerC, checkProximityChars, &proximityIndex);
 
     if (ProximityInfo::UNRELATED_CHAR == matchedProximityCharId) {
         if (canTryCorrection && mOutputIndex > 0
                 && mCorrectionStates[mOutputIndex].mProximityMatching
                 && mCorrectionStates[mOutputIndex].mExceeding
-                && isEquivalentChar(mProximityInfo->getMatchedProximityId(
-                        mInputIndex, mWord[mOutputIndex - 1], false))) {
+                && isEquivalentChar(mInputContext->getMatchedProximityId(mInputIndex,
+                        mWord[mOutputIndex - 1], mBaseLowerWord[mOutputIndex - 1], false))) {
             if (DEBUG_CORRECTION) {
                 LOGI("CONVERSION p->e %c", mWord[mOutputIndex - 1]);
             }
@@ -418,8 +531,8 @@ Correction::CorrectionType Correction::processCharAndCalcState(
             // Here, we are doing something equivalent to matchedProximityCharId,
             // but we already know that "excessive char correction" just happened
             // so that we just need to check "mProximityCount == 0".
-            matchedProximityCharId = mProximityInfo->getMatchedProximityId(
-                    mInputIndex, c, mProximityCount == 0, &proximityIndex);
+            matchedProximityCharId = mInputContext->getMatchedProximityId(
+                    mInputIndex, c, baseLowerC, mProximityCount == 0, &proximityIndex);
         }
     }
 
@@ -431,10 +544,10 @@ Correction::CorrectionType Correction::processCharAndCalcState(
         if (mInputIndex < mInputLength - 1 && mOutputIndex > 0 && mTransposedCount > 0
                 && !mCorrectionStates[mOutputIndex].mTransposing
                 && mCorrectionStates[mOutputIndex - 1].mTransposing
-                && isEquivalentChar(mProximityInfo->getMatchedProximityId(
-                        mInputIndex, mWord[mOutputIndex - 1], false))
-                && isEquivalentChar(
-                        mProximityInfo->getMatchedProximityId(mInputIndex + 1, c, false))) {
+                && isEquivalentChar(mInputContext->getMatchedProximityId(mInputIndex,
+                        mWord[mOutputIndex - 1], mBaseLowerWord[mOutputIndex - 1], false))
+                && isEquivalentChar(mInputContext->getMatchedProximityId(
+                        mInputIndex + 1, c, baseLowerC, false))) {
             // Conversion t->e
             // Example:
             // occaisional -> occa   sional
@@ -445,8 +558,8 @@ Correction::CorrectionType Correction::processCharAndCalcState(
         } else if (mOutputIndex > 0 && mInputIndex > 0 && mTransposedCount > 0
                 && !mCorrectionStates[mOutputIndex].mTransposing
                 && mCorrectionStates[mOutputIndex - 1].mTransposing
-                && isEquivalentChar(
-                        mProximityInfo->getMatchedProximityId(mInputIndex - 1, c, false))) {
+                && isEquivalentChar(mInputContext->getMatchedProximityId(
+                        mInputIndex - 1, c, baseLowerC, false))) {
             // Conversion t->s
             // Example:
             // chcolate -> chocolate
@@ -457,17 +570,17 @@ Correction::CorrectionType Correction::processCharAndCalcState(
         } else if (canTryCorrection && mInputIndex > 0
                 && mCorrectionStates[mOutputIndex].mProximityMatching
                 && mCorrectionStates[mOutputIndex].mSkipping
-                && isEquivalentChar(
-                        mProximityInfo->getMatchedProximityId(mInputIndex - 1, c, false))) {
+                && isEquivalentChar(mInputContext->getMatchedProximityId(
+                        mInputIndex - 1, c, baseLowerC, false))) {
             // Conversion p->s
             // Note: This logic tries saving cases like contrst --> contrast -- "a" is one of
             // proximity chars of "s", but it should rather be handled as a skipped char.
             ++mSkippedCount;
             --mProximityCount;
-            return processSkipChar(c, isTerminal, false);
+            return processSkipChar(c, baseLowerC, isTerminal, false);
         } else if ((mExceeding || mTransposing) && mInputIndex - 1 < mInputLength
-                && isEquivalentChar(
-                        mProximityInfo->getMatchedProximityId(mInputIndex + 1, c, false))) {
+                && isEquivalentChar(mInputContext->getMatchedProximityId(
+                        mInputIndex + 1, c, baseLowerC, false))) {
             // 1.2. Excessive or transpose correction
             if (mTransposing) {
                 ++mTransposedCount;
@@ -478,7 +591,7 @@ Correction::CorrectionType Correction::processCharAndCalcState(
         } else if (mSkipping) {
             // 3. Skip correction
             ++mSkippedCount;
-            return processSkipChar(c, isTerminal, false);
+            return processSkipChar(c, baseLowerC, isTerminal, false);
         } else {
             if (DEBUG_CORRECTION) {
                 DUMP_WORD(mWord, mOutputIndex);
@@ -494,15 +607,19 @@ Correction::CorrectionType Correction::processCharAndCalcState(
     } else if (isEquivalentChar(matchedProximityCharId)) {
         mMatching = true;
         ++mEquivalentCharCount;
-        mDistances[mOutputIndex] = mProximityInfo->getNormalizedSquaredDistance(mInputIndex, 0);
+        if (Policy::TOUCH_POSITION_CORRECTION) {
+            mTouchIndices[mOutputIndex] = mInputContext->getTouchIndex(mInputIndex, 0);
+        }
     } else if (ProximityInfo::NEAR_PROXIMITY_CHAR == matchedProximityCharId) {
         mProximityMatching = true;
         ++mProximityCount;
-        mDistances[mOutputIndex] =
-                mProximityInfo->getNormalizedSquaredDistance(mInputIndex, proximityIndex);
+        if (Policy::TOUCH_POSITION_CORRECTION) {
+            mTouchIndices[mOutputIndex] =
+                    mInputContext->getTouchIndex(mInputIndex, proximityIndex);
+        }
     }
 
-    addCharToCurrentWord(c);
+    addCharToCurrentWord(c, baseLowerC);
 
     // 4. Last char excessive correction
     mLastCharExceeded = mExcessiveCount == 0 && mSkippedCount == 0 && mTransposedCount == 0
@@ -621,19 +738,20 @@ inline static bool isUpperCase(unsigned short c) {
 //////////////////////
 
 /* static */
+template <typename Policy>
 int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const int outputIndex,
-        const int freq, int* editDistanceTable, const Correction* correction) {
+        const int freq, const int editDistance, const Correction* correction) {
+    const RankingParams *params = correction->mRankingParams;
     const int excessivePos = correction->getExcessivePos();
     const int inputLength = correction->mInputLength;
     const int typedLetterMultiplier = correction->TYPED_LETTER_MULTIPLIER;
     const int fullWordMultiplier = correction->FULL_WORD_MULTIPLIER;
-    const ProximityInfo *proximityInfo = correction->mProximityInfo;
+    const InputContext *inputContext = correction->mInputContext;
     const int skippedCount = correction->mSkippedCount;
     const int transposedCount = correction->mTransposedCount / 2;
     const int excessiveCount = correction->mExcessiveCount + correction->mTransposedCount % 2;
     const int proximityMatchedCount = correction->mProximityCount;
     const bool lastCharExceeded = correction->mLastCharExceeded;
-    const bool useFullEditDistance = correction->mUseFullEditDistance;
     const int outputLength = outputIndex + 1;
     if (skippedCount >= inputLength || inputLength == 0) {
         return -1;
@@ -650,7 +768,7 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
     const bool skipped = skippedCount > 0;
 
     const int quoteDiffCount = max(0, getQuoteCount(word, outputIndex + 1)
-            - getQuoteCount(proximityInfo->getPrimaryInputWord(), inputLength));
+            - getQuoteCount(inputContext->getPrimaryInputWord(), inputLength));
 
     // TODO: Calculate edit distance for transposed and excessive
     int ed = 0;
@@ -661,14 +779,14 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
     // TODO: Optimize this.
     // TODO: Ignoring edit distance for transposed char, for now
     if (transposedCount == 0 && (proximityMatchedCount > 0 || skipped || excessiveCount > 0)) {
-        ed = getCurrentEditDistance(editDistanceTable, inputLength, outputIndex + 1);
+        ed = editDistance;
         const int matchWeight = powerIntCapped(typedLetterMultiplier,
                 max(inputLength, outputIndex + 1) - ed);
         multiplyIntCapped(matchWeight, &finalFreq);
 
         // TODO: Demote further if there are two or more excessive chars with longer user input?
         if (inputLength > outputIndex + 1) {
-            multiplyRate(INPUT_EXCEEDS_OUTPUT_DEMOTION_RATE, &finalFreq);
+            multiplyRate(params->mInputExceedsOutputDemotionRate, &finalFreq);
         }
 
         ed = max(0, ed - quoteDiffCount);
@@ -676,7 +794,7 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
         if (ed == 1 && (inputLength == outputIndex || inputLength == outputIndex + 2)) {
             // Promote a word with just one skipped or excessive char
             if (sameLength) {
-                multiplyRate(WORDS_WITH_JUST_ONE_CORRECTION_PROMOTION_RATE, &finalFreq);
+                multiplyRate(params->mWordsWithJustOneCorrectionPromotionRate, &finalFreq);
             } else {
                 multiplyIntCapped(typedLetterMultiplier, &finalFreq);
             }
@@ -692,9 +810,10 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
         multiplyIntCapped(matchWeight, &finalFreq);
     }
 
-    if (proximityInfo->getMatchedProximityId(0, word[0], true)
+    if (inputContext->getMatchedProximityId(0, word[0],
+            inputContext->getBaseLowerCase()->toBaseLowerCase(word[0]), true)
             == ProximityInfo::UNRELATED_CHAR) {
-        multiplyRate(FIRST_CHAR_DIFFERENT_DEMOTION_RATE, &finalFreq);
+        multiplyRate(params->mFirstCharDifferentDemotionRate, &finalFreq);
     }
 
     ///////////////////////////////////////////////
@@ -702,10 +821,10 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
 
     // Demotion for a word with missing character
     if (skipped) {
-        const int demotionRate = WORDS_WITH_MISSING_CHARACTER_DEMOTION_RATE
-                * (10 * inputLength - WORDS_WITH_MISSING_CHARACTER_DEMOTION_START_POS_10X)
+        const int demotionRate = params->mWordsWithMissingCharacterDemotionRate
+                * (10 * inputLength - params->mWordsWithMissingCharacterDemotionStartPos10x)
                 / (10 * inputLength
-                        - WORDS_WITH_MISSING_CHARACTER_DEMOTION_START_POS_10X + 10);
+                        - params->mWordsWithMissingCharacterDemotionStartPos10x + 10);
         if (DEBUG_DICT_FULL) {
             LOGI("Demotion rate for missing character is %d.", demotionRate);
         }
@@ -714,56 +833,40 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
 
     // Demotion for a word with transposed character
     if (transposedCount > 0) multiplyRate(
-            WORDS_WITH_TRANSPOSED_CHARACTERS_DEMOTION_RATE, &finalFreq);
+            params->mWordsWithTransposedCharactersDemotionRate, &finalFreq);
 
     // Demotion for a word with excessive character
     if (excessiveCount > 0) {
-        multiplyRate(WORDS_WITH_EXCESSIVE_CHARACTER_DEMOTION_RATE, &finalFreq);
-        if (!lastCharExceeded && !proximityInfo->existsAdjacentProximityChars(excessivePos)) {
+        multiplyRate(params->mWordsWithExcessiveCharacterDemotionRate, &finalFreq);
+        if (!lastCharExceeded && !inputContext->existsAdjacentProximityChars(excessivePos)) {
             if (DEBUG_CORRECTION_FREQ) {
                 LOGI("Double excessive demotion");
             }
             // If an excessive character is not adjacent to the left char or the right char,
             // we will demote this word.
-            multiplyRate(WORDS_WITH_EXCESSIVE_CHARACTER_OUT_OF_PROXIMITY_DEMOTION_RATE, &finalFreq);
+            multiplyRate(params->mWordsWithExcessiveCharacterOutOfProximityDemotionRate,
+                    &finalFreq);
         }
     }
 
     // Score calibration by touch coordinates is being done only for pure-fat finger typing error
     // cases.
     // TODO: Remove this constraint.
-    if (CALIBRATE_SCORE_BY_TOUCH_COORDINATES && proximityInfo->touchPositionCorrectionEnabled()
+    if (Policy::TOUCH_POSITION_CORRECTION
             && skippedCount == 0 && excessiveCount == 0 && transposedCount == 0) {
         for (int i = 0; i < outputLength; ++i) {
-            const int squaredDistance = correction->mDistances[i];
+            const int touchIndex = correction->mTouchIndices[i];
             if (i < adjustedProximityMatchedCount) {
                 multiplyIntCapped(typedLetterMultiplier, &finalFreq);
             }
-            if (squaredDistance >= 0) {
-                // Promote or demote the score according to the distance from the sweet spot
-                static const float A = ZERO_DISTANCE_PROMOTION_RATE / 100.0f;
-                static const float B = 1.0f;
-                static const float C = 0.5f;
-                static const float R1 = NEUTRAL_SCORE_SQUARED_RADIUS;
-                static const float R2 = HALF_SCORE_SQUARED_RADIUS;
-                const float x = (float)squaredDistance
-                        / ProximityInfo::NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR;
-                const float factor = (x < R1)
-                    ? (A * (R1 - x) + B * x) / R1
-                    : (B * (R2 - x) + C * (x - R1)) / (R2 - R1);
-                // factor is piecewise linear function like:
-                // A -_                  .
-                //     ^-_               .
-                // B      \              .
-                //         \             .
-                // C        \            .
-                //   0   R1 R2
-                if (factor <= 0) {
-                    return -1;
-                }
-                multiplyRate((int)(factor * 100), &finalFreq);
-            } else if (squaredDistance == PROXIMITY_CHAR_WITHOUT_DISTANCE_INFO) {
-                multiplyRate(WORDS_WITH_PROXIMITY_CHARACTER_DEMOTION_RATE, &finalFreq);
+            if (NOT_A_INDEX == touchIndex) continue;
+            // Promote or demote the score according to the distance from the sweet spot
+            const int touchRate = inputContext->getTouchRate(touchIndex);
+            if (touchRate == InputContext::OUT_OF_REACH_TOUCH_RATE) {
+                return -1;
+            }
+            if (touchRate != InputContext::NO_TOUCH_RATE) {
+                multiplyRate(touchRate, &finalFreq);
             }
         }
     } else {
@@ -774,15 +877,15 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
                 LOGI("Found a proximity correction.");
             }
             multiplyIntCapped(typedLetterMultiplier, &finalFreq);
-            multiplyRate(WORDS_WITH_PROXIMITY_CHARACTER_DEMOTION_RATE, &finalFreq);
+            multiplyRate(params->mWordsWithProximityCharacterDemotionRate, &finalFreq);
         }
     }
 
     const int errorCount = adjustedProximityMatchedCount > 0
             ? adjustedProximityMatchedCount
             : (proximityMatchedCount + transposedCount);
-    multiplyRate(
-            100 - CORRECTION_COUNT_RATE_DEMOTION_RATE_BASE * errorCount / inputLength, &finalFreq);
+    multiplyRate(100 - params->mCorrectionCountRateDemotionRateBase * errorCount / inputLength,
+            &finalFreq);
 
     // Promotion for an exactly matched word
     if (ed == 0) {
@@ -794,7 +897,7 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
 
     // Promote a word with no correction
     if (proximityMatchedCount == 0 && transposedCount == 0 && !skipped && excessiveCount == 0) {
-        multiplyRate(FULL_MATCHED_WORDS_PROMOTION_RATE, &finalFreq);
+        multiplyRate(params->mFullMatchedWordsPromotionRate, &finalFreq);
     }
 
     // TODO: Check excessive count and transposed count
@@ -817,7 +920,7 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
      */
     if (matchCount == inputLength && matchCount >= 2 && !skipped
             && word[matchCount] == word[matchCount - 1]) {
-        multiplyRate(WORDS_WITH_MATCH_SKIP_PROMOTION_RATE, &finalFreq);
+        multiplyRate(params->mWordsWithMatchSkipPromotionRate, &finalFreq);
     }
 
     // TODO: Do not use sameLength?
@@ -825,7 +928,7 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
         multiplyIntCapped(fullWordMultiplier, &finalFreq);
     }
 
-    if (useFullEditDistance && outputLength > inputLength + 1) {
+    if (Policy::USE_FULL_EDIT_DISTANCE && outputLength > inputLength + 1) {
         const int diff = outputLength - inputLength - 1;
         const int divider = diff < 31 ? 1 << diff : S_INT_MAX;
         finalFreq = divider > finalFreq ? 1 : finalFreq / divider;
@@ -845,10 +948,80 @@ int Correction::RankingAlgorithm::calculateFinalFreq(const int inputIndex, const
     return finalFreq;
 }
 
+/* static */
+template <typename Policy>
+int Correction::RankingAlgorithm::calculateLogCost(const int inputIndex, const int outputIndex,
+        const int freq, const Correction* correction) {
+    const RankingParams *params = correction->mRankingParams;
+    const int excessivePos = correction->getExcessivePos();
+    const int inputLength = correction->mInputLength;
+    const InputContext *inputContext = correction->mInputContext;
+    const int skippedCount = correction->mSkippedCount;
+    const int transposedCount = correction->mTransposedCount / 2;
+    const int excessiveCount = correction->mExcessiveCount + correction->mTransposedCount % 2;
+    const int proximityMatchedCount = correction->mProximityCount;
+    const bool lastCharExceeded = correction->mLastCharExceeded;
+    const int outputLength = outputIndex + 1;
+    if (skippedCount >= inputLength || inputLength == 0 || freq <= 0) {
+        return -1;
+    }
+    const bool sameLength = lastCharExceeded ? (inputLength == inputIndex + 2)
+            : (inputLength == inputIndex + 1);
+    const bool hasEditCorrections = skippedCount > 0 || transposedCount > 0 || excessiveCount > 0;
+
+    // The frequency term: log2(MAX_FREQ / freq)
+    int cost = (int)(log((double)MAX_FREQ / freq) / log(2.0) * LOG_COST_ONE_BIT);
+
+    if (hasEditCorrections || proximityMatchedCount > 0 || !sameLength) {
+        cost += params->mLogCostNotExactMatch;
+    }
+    if (!sameLength) {
+        cost += params->mLogCostIncompleteWord;
+    }
+    cost += skippedCount * params->mLogCostMissingCharacter;
+    cost += transposedCount * params->mLogCostTransposedCharacters;
+    if (excessiveCount > 0) {
+        cost += excessiveCount * params->mLogCostExcessiveCharacter;
+        if (!lastCharExceeded && !inputContext->existsAdjacentProximityChars(excessivePos)) {
+            cost += params->mLogCostExcessiveCharacterOutOfProximity;
+        }
+    }
+    if (inputLength > outputLength) {
+        cost += params->mLogCostInputExceedsOutput;
+    }
+    const unsigned short firstChar = correction->mWord[0];
+    if (inputContext->getMatchedProximityId(
+            0, firstChar, inputContext->getBaseLowerCase()->toBaseLowerCase(firstChar), true)
+            == ProximityInfo::UNRELATED_CHAR) {
+        cost += params->mLogCostFirstCharDifferent;
+    }
+
+    if (Policy::TOUCH_POSITION_CORRECTION && !hasEditCorrections) {
+        for (int i = 0; i < outputLength; ++i) {
+            const int touchIndex = correction->mTouchIndices[i];
+            if (NOT_A_INDEX != touchIndex) cost += inputContext->getTouchLogCost(touchIndex);
+        }
+    } else {
+        cost += proximityMatchedCount * params->mLogCostProximityCharacter;
+    }
+
+    if (Policy::USE_FULL_EDIT_DISTANCE && outputLength > inputLength + 1) {
+        cost += (outputLength - inputLength - 1) * LOG_COST_ONE_BIT;
+    }
+
+    if (DEBUG_CORRECTION_FREQ) {
+        DUMP_WORD(correction->mWord, outputLength);
+        LOGI("LogCost: [P%d, S%d, T%d, E%d] %d, %d, %d", proximityMatchedCount, skippedCount,
+                transposedCount, excessiveCount, lastCharExceeded, sameLength, cost);
+    }
+    return cost;
+}
+
 /* static */
 int Correction::RankingAlgorithm::calcFreqForSplitTwoWords(
         const int firstFreq, const int secondFreq, const Correction* correction,
         const unsigned short *word) {
+    const RankingParams *params = correction->mRankingParams;
     const int spaceProximityPos = correction->mSpaceProximityPos;
     const int missingSpacePos = correction->mMissingSpacePos;
     if (DEBUG_DICT) {
@@ -926,16 +1099,50 @@ int Correction::RankingAlgorithm::calcFreqForSplitTwoWords(
             LOGI("Found a word pair with space proximity correction.");
         }
         multiplyIntCapped(typedLetterMultiplier, &totalFreq);
-        multiplyRate(WORDS_WITH_PROXIMITY_CHARACTER_DEMOTION_RATE, &totalFreq);
+        multiplyRate(params->mWordsWithProximityCharacterDemotionRate, &totalFreq);
     }
 
-    multiplyRate(WORDS_WITH_MISSING_SPACE_CHARACTER_DEMOTION_RATE, &totalFreq);
+    multiplyRate(params->mWordsWithMissingSpaceCharacterDemotionRate, &totalFreq);
 
     if (capitalizedWordDemotion) {
-        multiplyRate(TWO_WORDS_CAPITALIZED_DEMOTION_RATE, &totalFreq);
+        multiplyRate(params->mTwoWordsCapitalizedDemotionRate, &totalFreq);
     }
 
     return totalFreq;
 }
 
+// Explicit instantiations for the policies UnigramDictionary dispatches to.
+template Correction::CorrectionType
+Correction::processCharAndCalcState<TraversalPolicy<false, false> >(const int32_t, const bool);
+template Correction::CorrectionType
+Correction::processCharAndCalcState<TraversalPolicy<false, true> >(const int32_t, const bool);
+template Correction::CorrectionType
+Correction::processCharAndCalcState<TraversalPolicy<true, false> >(const int32_t, const bool);
+template Correction::CorrectionType
+Correction::processCharAndCalcState<TraversalPolicy<true, true> >(const int32_t, const bool);
+template int Correction::getFinalFreq<TraversalPolicy<false, false> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<false, true> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<true, false> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<true, true> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalLogCost<TraversalPolicy<false, false> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalLogCost<TraversalPolicy<false, true> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalLogCost<TraversalPolicy<true, false> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalLogCost<TraversalPolicy<true, true> >(
+        const int, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<false, false> >(
+        const TerminalState *, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<false, true> >(
+        const TerminalState *, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<true, false> >(
+        const TerminalState *, unsigned short **, int *);
+template int Correction::getFinalFreq<TraversalPolicy<true, true> >(
+        const TerminalState *, unsigned short **, int *);
+
 } // namespace latinime
@@ -21,10 +21,23 @@
 #include "correction_state.h"
 
 #include "defines.h"
+#include "ranking_params.h"
 
 namespace latinime {
 
-class ProximityInfo;
+class InputContext;
+
+// Per-query options that the traversal and the ranking code depend on. UnigramDictionary
+// resolves them once per query and runs the matching instantiation, so that the inner loops
+// do not have to check them for every character.
+template <bool UseFullEditDistance, bool TouchPositionCorrection>
+struct TraversalPolicy {
+    static const bool USE_FULL_EDIT_DISTANCE = UseFullEditDistance;
+    static const bool TOUCH_POSITION_CORRECTION =
+            TouchPositionCorrection && CALIBRATE_SCORE_BY_TOUCH_COORDINATES;
+    // The policy to rank the candidates with in the retrieval stage of the two-stage ranking
+    typedef TraversalPolicy<UseFullEditDistance, false> RetrievalPolicy;
+};
 
 class Correction {
 
@@ -37,14 +50,32 @@ public:
         NOT_ON_TERMINAL
     } CorrectionType;
 
-    Correction(const int typedLetterMultiplier, const int fullWordMultiplier);
+    // The part of the correction state at a terminal that the final frequency depends on.
+    // A candidate keeps it so that it can be scored again after the traversal.
+    struct TerminalState {
+        int mFreq;
+        int mInputIndex;
+        int mOutputIndex;
+        int mEditDistance;
+        int mSkippedCount;
+        int mTransposedCount;
+        int mExcessiveCount;
+        int mProximityCount;
+        int mExcessivePos;
+        bool mLastCharExceeded;
+        unsigned short mWord[MAX_WORD_LENGTH_INTERNAL];
+        int mTouchIndices[MAX_WORD_LENGTH_INTERNAL];
+    };
+
+    Correction(const int typedLetterMultiplier, const int fullWordMultiplier,
+            const RankingParams *rankingParams);
     void initCorrection(
-            const ProximityInfo *pi, const int inputLength, const int maxWordLength);
+            const InputContext *inputContext, const int inputLength, const int maxWordLength);
     void initCorrectionState(const int rootPos, const int childCount, const bool traverseAll);
 
     // TODO: remove
     void setCorrectionParams(const int skipPos, const int excessivePos, const int transposedPos,
-            const int spaceProximityPos, const int missingSpacePos, const bool useFullEditDistance);
+            const int spaceProximityPos, const int missingSpacePos);
     void checkState();
     bool initProcessState(const int index);
 
@@ -75,8 +106,20 @@ public:
 
     int getFreqForSplitTwoWords(
             const int firstFreq, const int secondFreq, const unsigned short *word);
+    template <typename Policy>
     int getFinalFreq(const int freq, unsigned short **word, int* wordLength);
-
+    void saveTerminalState(const int freq, TerminalState *state) const;
+    template <typename Policy>
+    int getFinalFreq(const TerminalState *state, unsigned short **word, int* wordLength);
+
+    // Log-domain scoring
+    template <typename Policy>
+    int getFinalLogCost(const int freq, unsigned short **word, int* wordLength);
+    int getLogCostLowerBound() const;
+    int logCostToFreq(const int cost) const;
+    int freqToLogCost(const int freq) const;
+
+    template <typename Policy>
     CorrectionType processCharAndCalcState(const int32_t c, const bool isTerminal);
 
     /////////////////////////
@@ -100,15 +143,16 @@ private:
     inline bool needsToTraverseAllNodes();
     inline void startToTraverseAllNodes();
     inline bool isQuote(const unsigned short c);
-    inline CorrectionType processSkipChar(
-            const int32_t c, const bool isTerminal, const bool inputIndexIncremented);
-    inline void addCharToCurrentWord(const int32_t c);
+    inline CorrectionType processSkipChar(const int32_t c, const unsigned short baseLowerC,
+            const bool isTerminal, const bool inputIndexIncremented);
+    inline void addCharToCurrentWord(const int32_t c, const unsigned short baseLowerC);
+    double getPerfectFreq() const;
 
     const int TYPED_LETTER_MULTIPLIER;
     const int FULL_WORD_MULTIPLIER;
-    const ProximityInfo *mProximityInfo;
+    const RankingParams *mRankingParams;
+    const InputContext *mInputContext;
 
-    bool mUseFullEditDistance;
     int mMaxEditDistance;
     int mMaxDepth;
     int mInputLength;
@@ -119,7 +163,9 @@ private:
 
     // The following arrays are state buffer.
     unsigned short mWord[MAX_WORD_LENGTH_INTERNAL];
-    int mDistances[MAX_WORD_LENGTH_INTERNAL];
+    // mWord in base lower case, so that each char of the trie is folded only once.
+    unsigned short mBaseLowerWord[MAX_WORD_LENGTH_INTERNAL];
+    int mTouchIndices[MAX_WORD_LENGTH_INTERNAL];
 
     // Edit distance calculation requires a buffer with (N+1)^2 length for the input length N.
     // Caveat: Do not create multiple tables per thread as this table eats up RAM a lot.
@@ -152,10 +198,14 @@ private:
 
     class RankingAlgorithm {
     public:
+        template <typename Policy>
         static int calculateFinalFreq(const int inputIndex, const int depth,
-                const int freq, int *editDistanceTable, const Correction* correction);
+                const int freq, const int editDistance, const Correction* correction);
         static int calcFreqForSplitTwoWords(const int firstFreq, const int secondFreq,
                 const Correction* correction, const unsigned short *word);
+        template <typename Policy>
+        static int calculateLogCost(const int inputIndex, const int outputIndex,
+                const int freq, const Correction* correction);
     };
 };
 } // namespace latinime
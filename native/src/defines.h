@@ -161,10 +161,9 @@ static void dumpWord(const unsigned short* word, const int length) {
 #define DICTIONARY_HEADER_SIZE 2
 #define NEW_DICTIONARY_HEADER_SIZE 5
 #define NOT_VALID_WORD -99
+#define NOT_A_FREQUENCY -1
+#define MAX_FREQ 255
 #define NOT_A_CHARACTER -1
-#define NOT_A_DISTANCE -1
-#define EQUIVALENT_CHAR_WITHOUT_DISTANCE_INFO -2
-#define PROXIMITY_CHAR_WITHOUT_DISTANCE_INFO -3
 #define NOT_A_INDEX -1
 
 #define KEYCODE_SPACE ' '
@@ -178,6 +177,8 @@ static void dumpWord(const unsigned short* word, const int length) {
 #define SUGGEST_WORDS_WITH_SPACE_PROXIMITY true
 
 // The following "rate"s are used as a multiplier before dividing by 100, so they are in percent.
+// These and the other ranking constants below are only the defaults of RankingParams, which
+// can be changed at run time.
 #define WORDS_WITH_MISSING_CHARACTER_DEMOTION_RATE 80
 #define WORDS_WITH_MISSING_CHARACTER_DEMOTION_START_POS_10X 12
 #define WORDS_WITH_MISSING_SPACE_CHARACTER_DEMOTION_RATE 67
@@ -196,6 +197,26 @@ static void dumpWord(const unsigned short* word, const int length) {
 #define NEUTRAL_SCORE_SQUARED_RADIUS 8.0f
 #define HALF_SCORE_SQUARED_RADIUS 32.0f
 
+// The costs of the log-domain scoring, in 1/LOG_COST_ONE_BIT bits: a cost of LOG_COST_ONE_BIT
+// halves the score. They are all positive, so that the cost never goes down along a path.
+#define LOG_COST_ONE_BIT 256
+// log2(255): what an exact match gets over a corrected one
+#define LOG_COST_NOT_EXACT_MATCH 2047
+// log2(FULL_WORD_MULTIPLIER)
+#define LOG_COST_INCOMPLETE_WORD 256
+// -log2(rate / 100) for the corresponding rates above
+#define LOG_COST_MISSING_CHARACTER 165
+#define LOG_COST_EXCESSIVE_CHARACTER 106
+#define LOG_COST_EXCESSIVE_CHARACTER_OUT_OF_PROXIMITY 106
+#define LOG_COST_TRANSPOSED_CHARACTERS 189
+#define LOG_COST_PROXIMITY_CHARACTER 39
+#define LOG_COST_INPUT_EXCEEDS_OUTPUT 132
+#define LOG_COST_FIRST_CHAR_DIFFERENT 15
+// The log-domain scoring models a touch as a Gaussian around the sweet spot of the key, with a
+// variance of TOUCH_SQUARED_SIGMA squared sweet spot radii. This one costs about as much as the
+// piecewise linear factor at HALF_SCORE_SQUARED_RADIUS.
+#define TOUCH_SQUARED_SIGMA 20.0f
+
 // This should be greater than or equal to MAX_WORD_LENGTH defined in BinaryDictionary.java
 // This is only used for the size of array. Not to be used in c functions.
 #define MAX_WORD_LENGTH_INTERNAL 48
@@ -211,6 +232,55 @@ static void dumpWord(const unsigned short* word, const int length) {
 #define MIN_USER_TYPED_LENGTH_FOR_MISSING_SPACE_SUGGESTION 3
 #define MIN_USER_TYPED_LENGTH_FOR_EXCESSIVE_CHARACTER_SUGGESTION 3
 
+// Tiered correction stops escalating once this many suggestions score at least the margin, in
+// percent of the score the most frequent word would get for an exact match of the whole input.
+#define TIERED_CORRECTION_CONFIDENT_SUGGESTION_COUNT 3
+#define TIERED_CORRECTION_SCORE_MARGIN 20
+
+// The number of candidates the retrieval stage of the two-stage ranking passes to the rerank
+#define TWO_STAGE_RANKING_CANDIDATE_COUNT 36
+
+// The words that follow the previous word in a bigram get their score multiplied by a factor
+// from BIGRAM_MULTIPLIER_MIN to BIGRAM_MULTIPLIER_MAX, depending on the bigram frequency.
+// These must match the constants of the same name in Suggest.java.
+#define BIGRAM_MULTIPLIER_MIN 1.2f
+#define BIGRAM_MULTIPLIER_MAX 1.5f
+#define MAXIMUM_BIGRAM_FREQUENCY 127
+// The number of bigrams of the previous word that are looked up during the traversal. This must
+// be a power of 2.
+#define MAX_BIGRAM_TARGETS 128
+
+// The number of previous words whose bigram lists are cached, and the longest list that is
+// cached. Longer lists are decoded again on each call.
+#define BIGRAM_CACHE_SIZE 4
+#define BIGRAM_CACHE_MAX_BIGRAMS 256
+
+// The size of the Bloom filter that rejects the words isValidWord can't find in the WordIndex.
+// With k = bits * ln 2 hash functions, the false positive rate is about 0.62 ^ bits: 8 bits per
+// word give about 2%, 10 bits about 1% and 16 bits about 0.05%. 0 disables the filter.
+#define BLOOM_FILTER_DEFAULT_BITS_PER_WORD 10
+#define BLOOM_FILTER_MAX_BITS_PER_WORD 32
+
+// The gesture decoding. The path is resampled every GESTURE_SAMPLING_STEP times the key width,
+// into MAX_GESTURE_SAMPLES points at most; a longer path is resampled with a longer step.
+#define GESTURE_SAMPLING_STEP 0.25f
+#define MAX_GESTURE_SAMPLES 128
+// The costs are squared distances in key widths, in nats: a cost of 1 divides the score by e.
+// Each sample costs its squared distance to its segment times GESTURE_SEGMENT_COST_WEIGHT, and
+// each key its squared distance to the sample where the path turns times
+// GESTURE_KEY_COST_WEIGHT. The frequency f costs GESTURE_FREQUENCY_COST_WEIGHT * ln(255 / f).
+#define GESTURE_SEGMENT_COST_WEIGHT 1.0f
+#define GESTURE_KEY_COST_WEIGHT 1.0f
+#define GESTURE_FREQUENCY_COST_WEIGHT 0.5f
+// The path has to come this close to each key of a word, in key widths.
+#define GESTURE_MAX_KEY_DISTANCE 1.25f
+// The words that cost more than GESTURE_MAX_COST plus GESTURE_MAX_COST_PER_SAMPLE for each
+// sample of the resampled path are not suggested.
+#define GESTURE_MAX_COST 4.0f
+#define GESTURE_MAX_COST_PER_SAMPLE 0.3f
+// The score of a word of cost c is GESTURE_MAX_SCORE * e^-c.
+#define GESTURE_MAX_SCORE 1000000000
+
 #define min(a,b) ((a)<(b)?(a):(b))
 #define max(a,b) ((a)>(b)?(a):(b))
 
@@ -20,6 +20,7 @@
 #define LOG_TAG "LatinIME: dictionary.cpp"
 
 #include "dictionary.h"
+#include "terminal_index.h"
 
 namespace latinime {
 
@@ -38,15 +39,40 @@ Dictionary::Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust,
             LOGI("IN NATIVE SUGGEST Version: %d", (mDict[0] & 0xFF));
         }
     }
-    mUnigramDictionary = new UnigramDictionary(mDict, typedLetterMultiplier, fullWordMultiplier,
-            maxWordLength, maxWords, maxAlternatives, IS_LATEST_DICT_VERSION);
-    mBigramDictionary = new BigramDictionary(mDict, maxWordLength, maxAlternatives,
-            IS_LATEST_DICT_VERSION, hasBigram(), this);
+    BinaryFormat::readAlphabet(mDict, mAlphabet);
+    uint16_t foldedChars[BinaryFormat::MAX_FOLDING_OVERRIDES];
+    uint16_t baseLowerChars[BinaryFormat::MAX_FOLDING_OVERRIDES];
+    const int foldingOverrideCount =
+            BinaryFormat::readFoldingOverrides(mDict, foldedChars, baseLowerChars);
+    if (!mBaseLowerCase.setOverrides(foldedChars, baseLowerChars, foldingOverrideCount)) {
+        LOGE("Too many folding overrides: %d", foldingOverrideCount);
+    }
+    const uint8_t *const root = mDict + BinaryFormat::getHeaderSize(mDict);
+    mUnigramDictionary = new UnigramDictionary(mDict, mAlphabet, &mBaseLowerCase,
+            typedLetterMultiplier, fullWordMultiplier, maxWordLength, maxWords, maxAlternatives,
+            IS_LATEST_DICT_VERSION);
+    mTerminalIndex = new TerminalIndex(root, mAlphabet, maxWordLength,
+            TrigramDictionary::hasTrigramSection(mDict, dictSize));
+    mBigramDictionary = new BigramDictionary(mDict, mAlphabet, maxWordLength, maxAlternatives,
+            IS_LATEST_DICT_VERSION, hasBigram(), this, mTerminalIndex);
+    mTrigramDictionary = new TrigramDictionary(mDict, mAlphabet, dictSize, mTerminalIndex,
+            maxAlternatives);
+    mGestureDecoder = new GestureDecoder(root, mAlphabet, maxWordLength, maxWords);
+    mWordIndex = new WordIndex(mTerminalIndex);
+    // The WordIndex rejects words in constant time already. Without it isValidWord walks the trie,
+    // which takes the longest for the words that are not there.
+    mBloomFilter = NULL;
+    if (mWordIndex->isEmpty()) setBloomFilterBitsPerWord(BLOOM_FILTER_DEFAULT_BITS_PER_WORD);
 }
 
 Dictionary::~Dictionary() {
     delete mUnigramDictionary;
     delete mBigramDictionary;
+    delete mTrigramDictionary;
+    delete mGestureDecoder;
+    delete mWordIndex;
+    delete mBloomFilter;
+    delete mTerminalIndex;
 }
 
 bool Dictionary::hasBigram() {
@@ -54,7 +80,71 @@ bool Dictionary::hasBigram() {
 }
 
 bool Dictionary::isValidWord(unsigned short *word, int length) {
+    if (mBloomFilter && !mBloomFilter->mayContain(word, length)) return false;
+    if (mWordIndex->canLookUp(length)) {
+        return TerminalIndex::NOT_A_WORD_ID != mWordIndex->getWordId(word, length);
+    }
     return mUnigramDictionary->isValidWord(word, length);
 }
 
+int Dictionary::getFrequency(const unsigned short *word, int length) {
+    if (mBloomFilter && !mBloomFilter->mayContain(word, length)) return NOT_A_FREQUENCY;
+    if (mWordIndex->canLookUp(length)) {
+        const int wordId = mWordIndex->getWordId(word, length);
+        if (TerminalIndex::NOT_A_WORD_ID == wordId) return NOT_A_FREQUENCY;
+        return mTerminalIndex->getFrequency(wordId);
+    }
+    return mUnigramDictionary->getFrequency(word, length);
+}
+
+int Dictionary::getFrequencies(const unsigned short *chars, const int *offsets, int wordCount,
+        int *outFrequencies) {
+    // The words the hash can't look up are looked up together in the trie.
+    int *const trieWordIndices = new int[wordCount];
+    int trieWordCount = 0;
+    for (int i = 0; i < wordCount; ++i) {
+        const unsigned short *const word = chars + offsets[i];
+        const int length = offsets[i + 1] - offsets[i];
+        if (mBloomFilter && !mBloomFilter->mayContain(word, length)) {
+            outFrequencies[i] = NOT_A_FREQUENCY;
+        } else if (mWordIndex->canLookUp(length)) {
+            const int wordId = mWordIndex->getWordId(word, length);
+            outFrequencies[i] = TerminalIndex::NOT_A_WORD_ID == wordId
+                    ? NOT_A_FREQUENCY : mTerminalIndex->getFrequency(wordId);
+        } else {
+            trieWordIndices[trieWordCount++] = i;
+        }
+    }
+    if (trieWordCount > 0) {
+        mUnigramDictionary->getFrequencies(chars, offsets, trieWordIndices, trieWordCount,
+                outFrequencies);
+    }
+    delete[] trieWordIndices;
+    int validWordCount = 0;
+    for (int i = 0; i < wordCount; ++i) {
+        if (NOT_A_FREQUENCY != outFrequencies[i]) ++validWordCount;
+    }
+    return validWordCount;
+}
+
+bool Dictionary::setBloomFilterBitsPerWord(int bitsPerWord) {
+    // The lookups read mBloomFilter, so the callers must not run them while it is replaced:
+    // BinaryDictionary synchronizes both.
+    if (bitsPerWord <= 0) {
+        delete mBloomFilter;
+        mBloomFilter = NULL;
+        return false;
+    }
+    BloomFilter *bloomFilter = new BloomFilter(mDict + BinaryFormat::getHeaderSize(mDict),
+            mAlphabet, min(bitsPerWord, BLOOM_FILTER_MAX_BITS_PER_WORD));
+    if (bloomFilter->isEmpty()) {
+        // Keep the filter we have, if any, rather than losing it to a failed rebuild.
+        delete bloomFilter;
+        return mBloomFilter != NULL;
+    }
+    delete mBloomFilter;
+    mBloomFilter = bloomFilter;
+    return true;
+}
+
 } // namespace latinime
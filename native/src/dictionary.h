@@ -17,12 +17,16 @@
 #ifndef LATINIME_DICTIONARY_H
 #define LATINIME_DICTIONARY_H
 
-#include "basechars.h"
 #include "bigram_dictionary.h"
+#include "binary_format.h"
+#include "bloom_filter.h"
 #include "char_utils.h"
 #include "defines.h"
+#include "gesture_decoder.h"
 #include "proximity_info.h"
+#include "trigram_dictionary.h"
 #include "unigram_dictionary.h"
+#include "word_index.h"
 
 namespace latinime {
 
@@ -30,10 +34,20 @@ class Dictionary {
 public:
     Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust, int typedLetterMultipler,
             int fullWordMultiplier, int maxWordLength, int maxWords, int maxAlternatives);
+    // prevWord may be NULL. Otherwise the words that follow it in a bigram get boosted.
     int getSuggestions(ProximityInfo *proximityInfo, int *xcoordinates, int *ycoordinates,
-            int *codes, int codesSize, int flags, unsigned short *outWords, int *frequencies) {
+            const int *codes, int codesSize, const unsigned short *prevWord, int prevWordLength,
+            int flags, unsigned short *outWords, int *frequencies) {
         return mUnigramDictionary->getSuggestions(proximityInfo, xcoordinates, ycoordinates, codes,
-                codesSize, flags, outWords, frequencies);
+                codesSize, prevWord, prevWordLength, flags, outWords, frequencies);
+    }
+
+    // Outputs the words that best match the path of a gesture; see GestureDecoder.
+    int getGestureSuggestions(const ProximityInfo *proximityInfo, const int *xCoordinates,
+            const int *yCoordinates, int sampleCount, unsigned short *outWords,
+            int *frequencies) {
+        return mGestureDecoder->getSuggestions(proximityInfo, xCoordinates, yCoordinates,
+                sampleCount, outWords, frequencies);
     }
 
     // TODO: Call mBigramDictionary instead of mUnigramDictionary
@@ -44,7 +58,38 @@ public:
                 maxWordLength, maxBigrams, maxAlternatives);
     }
 
+    // Outputs the words that follow prevPrevWord and prevWord; see TrigramDictionary.
+    int getTrigrams(const unsigned short *prevPrevWord, int prevPrevWordLength,
+            const unsigned short *prevWord, int prevWordLength, const int *codes, int codesSize,
+            unsigned short *outWords, int *frequencies, int maxWordLength, int maxTrigrams) {
+        return mTrigramDictionary->getTrigrams(prevPrevWord, prevPrevWordLength, prevWord,
+                prevWordLength, codes, codesSize, outWords, frequencies, maxWordLength,
+                maxTrigrams);
+    }
+
+    bool setRankingParams(const char *block) {
+        return mUnigramDictionary->setRankingParams(block);
+    }
+
+    UnigramDictionary::CorrectionTier getLastCorrectionTier() const {
+        return mUnigramDictionary->getLastCorrectionTier();
+    }
+
+    int getCorrectionTierCount(const UnigramDictionary::CorrectionTier tier) const {
+        return mUnigramDictionary->getCorrectionTierCount(tier);
+    }
+
     bool isValidWord(unsigned short *word, int length);
+    // Returns the frequency of the word, or NOT_A_FREQUENCY if it is not in the dictionary.
+    int getFrequency(const unsigned short *word, int length);
+    // Looks up wordCount words at once. The word i is chars[offsets[i]..offsets[i + 1]); its
+    // frequency, or NOT_A_FREQUENCY, goes to outFrequencies[i]. Returns the number of words that
+    // are in the dictionary.
+    int getFrequencies(const unsigned short *chars, const int *offsets, int wordCount,
+            int *outFrequencies);
+    // Rebuilds the Bloom filter with this many bits per word, or drops it if bitsPerWord is 0.
+    // Returns whether the dictionary has a filter afterwards.
+    bool setBloomFilterBitsPerWord(int bitsPerWord);
     void *getDict() { return (void *)mDict; }
     int getDictSize() { return mDictSize; }
     int getMmapFd() { return mMmapFd; }
@@ -63,6 +108,8 @@ public:
     static int setDictionaryValues(const unsigned char *dict, const bool isLatestDictVersion,
             const int pos, unsigned short *c, int *childrenPosition,
             bool *terminal, int *freq);
+    // The default base lower case, without the overrides of a dictionary. See
+    // BaseLowerCaseTable.
     static inline unsigned short toBaseLowerCase(unsigned short c);
 
 private:
@@ -77,8 +124,21 @@ private:
     const int mDictBufAdjust;
 
     const bool IS_LATEST_DICT_VERSION;
+    // The code points of the one-byte chars of the trie; see BinaryFormat::readAlphabet.
+    int32_t mAlphabet[BinaryFormat::ALPHABET_TABLE_SIZE];
+    // The base lower case of the chars, with the folding overrides of the header.
+    BaseLowerCaseTable mBaseLowerCase;
     UnigramDictionary *mUnigramDictionary;
     BigramDictionary *mBigramDictionary;
+    TrigramDictionary *mTrigramDictionary;
+    GestureDecoder *mGestureDecoder;
+    // Shared by the bigram and trigram look ups.
+    TerminalIndex *mTerminalIndex;
+    // Finds words without walking the trie, for isValidWord and getFrequency.
+    WordIndex *mWordIndex;
+    // Rejects most of the words that are not in the dictionary before looking them up. May be
+    // NULL.
+    BloomFilter *mBloomFilter;
 };
 
 // public static utility methods
@@ -157,16 +217,9 @@ inline int Dictionary::setDictionaryValues(const unsigned char *dict,
 }
 
 
+// Strips the accents and lower cases c, with two look ups in the tables of char_utils.cpp.
 inline unsigned short Dictionary::toBaseLowerCase(unsigned short c) {
-    if (c < sizeof(BASE_CHARS) / sizeof(BASE_CHARS[0])) {
-        c = BASE_CHARS[c];
-    }
-    if (c >='A' && c <= 'Z') {
-        c |= 32;
-    } else if (c > 127) {
-        c = latin_tolower(c);
-    }
-    return c;
+    return c + BASE_LOWER_CASE_DELTAS[(BASE_LOWER_CASE_BLOCKS[c >> 8] << 8) | (c & 0xFF)];
 }
 
 } // namespace latinime
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#define LOG_TAG "LatinIME: gesture_decoder.cpp"
+
+#include "binary_format.h"
+#include "defines.h"
+#include "gesture_decoder.h"
+#include "proximity_info.h"
+#include "unigram_dictionary.h"
+
+namespace latinime {
+
+// Above any cost that can be kept.
+static const float NOT_A_COST = 1.0e30f;
+
+GestureDecoder::GestureDecoder(const uint8_t *const root, const int32_t *const alphabet,
+        const int maxWordLength, const int maxWords)
+        : mRoot(root), mAlphabet(alphabet),
+          MAX_WORD_LENGTH(min(maxWordLength, MAX_WORD_LENGTH_INTERNAL)),
+          MAX_WORDS(maxWords), mProximityInfo(0), mOutputChars(0), mFrequencies(0),
+          mInverseSquaredKeyWidth(0.0f), mKeyXs(0), mKeyYs(0), mLastNearSamples(0),
+          mCosts(new float[maxWords]), mWordCount(0),
+          mCutoff(GESTURE_MAX_COST), mSampleCount(0) {
+}
+
+GestureDecoder::~GestureDecoder() {
+    delete[] mCosts;
+}
+
+int GestureDecoder::getSuggestions(const ProximityInfo *proximityInfo, const int *xCoordinates,
+        const int *yCoordinates, const int sampleCount, unsigned short *outWords,
+        int *frequencies) {
+    const int keyWidth = proximityInfo->getMostCommonKeyWidth();
+    if (sampleCount <= 0 || keyWidth <= 0 || MAX_WORDS <= 0) return 0;
+    mProximityInfo = proximityInfo;
+    mOutputChars = outWords;
+    mFrequencies = frequencies;
+    mInverseSquaredKeyWidth = 1.0f / (static_cast<float>(keyWidth) * keyWidth);
+    mWordCount = 0;
+    resample(xCoordinates, yCoordinates, sampleCount, static_cast<float>(keyWidth));
+    mCutoff = GESTURE_MAX_COST + GESTURE_MAX_COST_PER_SAMPLE * mSampleCount;
+    const int keyCount = proximityInfo->getKeyCount();
+    float keyXs[keyCount];
+    float keyYs[keyCount];
+    int lastNearSamples[keyCount];
+    initializeKeys(static_cast<float>(keyWidth), keyXs, keyYs, lastNearSamples);
+    mKeyXs = keyXs;
+    mKeyYs = keyYs;
+    mLastNearSamples = lastNearSamples;
+
+    // Before the first char, the path can only start at the first sample.
+    for (int j = 0; j < mSampleCount; ++j) {
+        mRows[j] = NOT_A_COST;
+    }
+    mRows[0] = 0.0f;
+    mRowStarts[0] = 0;
+    mRowEnds[0] = 0;
+    mHasKeyPoints[0] = false;
+
+    // The depth first walk of BloomFilter::visitWords, with the rows along.
+    int positions[MAX_WORD_LENGTH_INTERNAL];
+    int remainingGroupCounts[MAX_WORD_LENGTH_INTERNAL];
+    int charDepths[MAX_WORD_LENGTH_INTERNAL];
+    int pos = 0;
+    remainingGroupCounts[0] = BinaryFormat::getGroupCountAndForwardPointer(mRoot, &pos);
+    positions[0] = pos;
+    charDepths[0] = 0;
+    int depth = 0;
+    while (depth >= 0) {
+        if (remainingGroupCounts[depth] <= 0) {
+            --depth;
+            continue;
+        }
+        --remainingGroupCounts[depth];
+        pos = positions[depth];
+        const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(mRoot, &pos);
+        int charDepth = charDepths[depth];
+        int32_t character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+        bool isAlive = processChar(charDepth++, character);
+        if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags) {
+            character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+            while (NOT_A_CHARACTER != character) {
+                // The remaining chars still have to be read to get past them.
+                if (isAlive) {
+                    isAlive = charDepth < MAX_WORD_LENGTH && processChar(charDepth++, character);
+                }
+                character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+            }
+        }
+        if (isAlive && (UnigramDictionary::FLAG_IS_TERMINAL & flags)) {
+            const float cost = mRows[charDepth * MAX_GESTURE_SAMPLES + mSampleCount - 1];
+            if (cost < mCutoff) {
+                const int frequency = max(1,
+                        BinaryFormat::readFrequencyWithoutMovingPointer(mRoot, pos));
+                addWord(charDepth, cost + GESTURE_FREQUENCY_COST_WEIGHT
+                        * logf(static_cast<float>(MAX_FREQ) / frequency));
+            }
+        }
+        pos = BinaryFormat::skipFrequency(flags, pos);
+        const int childrenPos = BinaryFormat::readChildrenPosition(mRoot, flags, pos);
+        positions[depth] = BinaryFormat::skipChildrenPosAndAttributes(mRoot, flags, pos);
+        if (isAlive && childrenPos >= 0 && charDepth < MAX_WORD_LENGTH
+                && depth + 1 < MAX_WORD_LENGTH_INTERNAL) {
+            ++depth;
+            pos = childrenPos;
+            remainingGroupCounts[depth] = BinaryFormat::getGroupCountAndForwardPointer(mRoot,
+                    &pos);
+            positions[depth] = pos;
+            charDepths[depth] = charDepth;
+        }
+    }
+    if (DEBUG_DICT) {
+        LOGI("Gesture: %d samples, %d words", mSampleCount, mWordCount);
+    }
+    return mWordCount;
+}
+
+// Resamples the path at a fixed step along its length, so that the costs don't depend on the
+// speed of the finger, and the decoding time only depends on the length of the path.
+void GestureDecoder::resample(const int *xCoordinates, const int *yCoordinates,
+        const int sampleCount, const float keyWidth) {
+    float length = 0.0f;
+    for (int i = 1; i < sampleCount; ++i) {
+        const float dx = static_cast<float>(xCoordinates[i] - xCoordinates[i - 1]);
+        const float dy = static_cast<float>(yCoordinates[i] - yCoordinates[i - 1]);
+        length += sqrtf(dx * dx + dy * dy);
+    }
+    const float step = max(keyWidth * GESTURE_SAMPLING_STEP,
+            length / (MAX_GESTURE_SAMPLES - 1));
+    mSampleXs[0] = static_cast<float>(xCoordinates[0]);
+    mSampleYs[0] = static_cast<float>(yCoordinates[0]);
+    int count = 1;
+    // The distance along the path from the last point that was kept.
+    float distance = 0.0f;
+    for (int i = 1; i < sampleCount && count < MAX_GESTURE_SAMPLES; ++i) {
+        const float x = static_cast<float>(xCoordinates[i - 1]);
+        const float y = static_cast<float>(yCoordinates[i - 1]);
+        const float dx = static_cast<float>(xCoordinates[i]) - x;
+        const float dy = static_cast<float>(yCoordinates[i]) - y;
+        const float segmentLength = sqrtf(dx * dx + dy * dy);
+        float position = step - distance;
+        while (position <= segmentLength && count < MAX_GESTURE_SAMPLES) {
+            const float ratio = position / segmentLength;
+            mSampleXs[count] = x + dx * ratio;
+            mSampleYs[count] = y + dy * ratio;
+            ++count;
+            position += step;
+        }
+        distance = segmentLength - (position - step);
+    }
+    // The path always ends where the finger went up.
+    const float lastX = static_cast<float>(xCoordinates[sampleCount - 1]);
+    const float lastY = static_cast<float>(yCoordinates[sampleCount - 1]);
+    if (count < MAX_GESTURE_SAMPLES) {
+        if (mSampleXs[count - 1] != lastX || mSampleYs[count - 1] != lastY) ++count;
+    }
+    mSampleXs[count - 1] = lastX;
+    mSampleYs[count - 1] = lastY;
+    mSampleCount = count;
+}
+
+// The point of a key is its sweet spot if it has one, and its center otherwise. A key that the
+// path never comes close enough to can't be in the word; once past the last sample that is
+// close enough, it can't be either.
+void GestureDecoder::initializeKeys(const float keyWidth, float *keyXs, float *keyYs,
+        int *lastNearSamples) const {
+    const float maxDistance = keyWidth * GESTURE_MAX_KEY_DISTANCE;
+    const float maxSquaredDistance = maxDistance * maxDistance;
+    for (int i = 0; i < mProximityInfo->getKeyCount(); ++i) {
+        const bool hasSweetSpot = mProximityInfo->hasSweetSpotData(i);
+        const float keyX = hasSweetSpot ? mProximityInfo->getSweetSpotCenterXAt(i)
+                : mProximityInfo->getKeyCenterXAt(i);
+        const float keyY = hasSweetSpot ? mProximityInfo->getSweetSpotCenterYAt(i)
+                : mProximityInfo->getKeyCenterYAt(i);
+        keyXs[i] = keyX;
+        keyYs[i] = keyY;
+        int j = mSampleCount - 1;
+        while (j >= 0) {
+            const float dx = mSampleXs[j] - keyX;
+            const float dy = mSampleYs[j] - keyY;
+            if (dx * dx + dy * dy <= maxSquaredDistance) break;
+            --j;
+        }
+        lastNearSamples[i] = j;
+    }
+}
+
+// Computes the row of depth + 1 for the char c. Returns whether a word that starts with the
+// chars so far can still cost less than the cutoff.
+bool GestureDecoder::processChar(const int depth, const int c) {
+    mWord[depth] = c;
+    const float *const previousRow = mRows + depth * MAX_GESTURE_SAMPLES;
+    float *const row = mRows + (depth + 1) * MAX_GESTURE_SAMPLES;
+    const int keyIndex = mProximityInfo->getKeyIndex(c);
+    if (NOT_A_INDEX == keyIndex) {
+        // A char without a key, like an apostrophe, is not gestured: it leaves the row as is.
+        memcpy(row, previousRow, mSampleCount * sizeof(row[0]));
+        mRowStarts[depth + 1] = mRowStarts[depth];
+        mRowEnds[depth + 1] = mRowEnds[depth];
+        mHasKeyPoints[depth + 1] = mHasKeyPoints[depth];
+        mKeyPointXs[depth + 1] = mKeyPointXs[depth];
+        mKeyPointYs[depth + 1] = mKeyPointYs[depth];
+        return true;
+    }
+    const int lastNearSample = mLastNearSamples[keyIndex];
+    if (lastNearSample < mRowStarts[depth]) return false;
+    const float keyX = mKeyXs[keyIndex];
+    const float keyY = mKeyYs[keyIndex];
+    // The segment from the previous key to this one. Before the first key, the path can stay
+    // around the first key for a while.
+    const float startX = mHasKeyPoints[depth] ? mKeyPointXs[depth] : keyX;
+    const float startY = mHasKeyPoints[depth] ? mKeyPointYs[depth] : keyY;
+    const float segmentX = keyX - startX;
+    const float segmentY = keyY - startY;
+    const float segmentSquaredLength = segmentX * segmentX + segmentY * segmentY;
+    const float inverseSegmentSquaredLength =
+            segmentSquaredLength > 0.0f ? 1.0f / segmentSquaredLength : 0.0f;
+    const float segmentWeight = GESTURE_SEGMENT_COST_WEIGHT * mInverseSquaredKeyWidth;
+    const float keyWeight = GESTURE_KEY_COST_WEIGHT * mInverseSquaredKeyWidth;
+    const float maxKeyCost = GESTURE_MAX_KEY_DISTANCE * GESTURE_MAX_KEY_DISTANCE
+            * GESTURE_KEY_COST_WEIGHT;
+    const float cutoff = mCutoff;
+    const int previousEnd = mRowEnds[depth];
+
+    int start = -1;
+    int end = -1;
+    // The cost of the path up to the sample j with the samples from the last turn on this
+    // segment.
+    float segmentCost = NOT_A_COST;
+    int j = mRowStarts[depth];
+    for (; j <= lastNearSample; ++j) {
+        // The path either was on this segment already, or turns at the previous key here.
+        const float previousCost = j <= previousEnd ? previousRow[j] : NOT_A_COST;
+        const float bestCost = min(segmentCost, previousCost);
+        if (bestCost >= cutoff) {
+            // Nothing further can get below the cutoff once the previous row is done.
+            if (j > previousEnd) break;
+            row[j] = NOT_A_COST;
+            segmentCost = NOT_A_COST;
+            continue;
+        }
+        const float x = mSampleXs[j];
+        const float y = mSampleYs[j];
+        const float toSampleX = x - startX;
+        const float toSampleY = y - startY;
+        float t = (toSampleX * segmentX + toSampleY * segmentY) * inverseSegmentSquaredLength;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        const float fromSegmentX = toSampleX - t * segmentX;
+        const float fromSegmentY = toSampleY - t * segmentY;
+        segmentCost = bestCost
+                + (fromSegmentX * fromSegmentX + fromSegmentY * fromSegmentY) * segmentWeight;
+        const float fromKeyX = x - keyX;
+        const float fromKeyY = y - keyY;
+        const float keyCost = (fromKeyX * fromKeyX + fromKeyY * fromKeyY) * keyWeight;
+        if (keyCost > maxKeyCost) {
+            row[j] = NOT_A_COST;
+            continue;
+        }
+        const float cost = segmentCost + keyCost;
+        row[j] = cost;
+        if (cost < cutoff) {
+            if (start < 0) start = j;
+            end = j;
+        }
+    }
+    for (; j < mSampleCount; ++j) {
+        row[j] = NOT_A_COST;
+    }
+    mRowStarts[depth + 1] = start < 0 ? mSampleCount : start;
+    mRowEnds[depth + 1] = end;
+    mHasKeyPoints[depth + 1] = true;
+    mKeyPointXs[depth + 1] = keyX;
+    mKeyPointYs[depth + 1] = keyY;
+    return start >= 0;
+}
+
+// Inserts the word of length chars in mWord in the output, which is sorted by cost.
+void GestureDecoder::addWord(const int length, const float cost) {
+    if (cost >= mCutoff) return;
+    int insertAt = min(mWordCount, MAX_WORDS - 1);
+    while (insertAt > 0 && mCosts[insertAt - 1] > cost) {
+        mCosts[insertAt] = mCosts[insertAt - 1];
+        mFrequencies[insertAt] = mFrequencies[insertAt - 1];
+        memcpy(mOutputChars + insertAt * MAX_WORD_LENGTH,
+                mOutputChars + (insertAt - 1) * MAX_WORD_LENGTH,
+                MAX_WORD_LENGTH * sizeof(mOutputChars[0]));
+        --insertAt;
+    }
+    mCosts[insertAt] = cost;
+    mFrequencies[insertAt] = max(1, static_cast<int>(GESTURE_MAX_SCORE * expf(-cost)));
+    unsigned short *const dest = mOutputChars + insertAt * MAX_WORD_LENGTH;
+    memcpy(dest, mWord, length * sizeof(dest[0]));
+    if (length < MAX_WORD_LENGTH) dest[length] = 0;
+    if (mWordCount < MAX_WORDS) ++mWordCount;
+    if (mWordCount == MAX_WORDS) mCutoff = mCosts[MAX_WORDS - 1];
+}
+
+} // namespace latinime
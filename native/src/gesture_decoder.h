@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_GESTURE_DECODER_H
+#define LATINIME_GESTURE_DECODER_H
+
+#include <stdint.h>
+
+#include "defines.h"
+
+namespace latinime {
+
+class ProximityInfo;
+
+// Decodes a gesture, the path of a finger that slides over the keys of a word, against the
+// words of the trie.
+//
+// The path is resampled at a fixed step along its length. The ideal path of a word is the
+// polyline through the centers of its keys (their sweet spots when the layout has them), and
+// its cost is the sum of the squared distances of the samples to that polyline, with the
+// samples aligned to the segments in order, plus the squared distance of each key to the
+// sample where the path turns to the next segment. The alignment is a dynamic programming row
+// over the samples for each char, so the words that share a prefix share its rows while the
+// trie is walked depth first. The costs only grow along a path, so a prefix whose best
+// alignment already costs more than the last of the words found so far is cut, and so is a
+// prefix whose next key is not close to the rest of the path.
+class GestureDecoder {
+public:
+    GestureDecoder(const uint8_t *const root, const int32_t *const alphabet,
+            const int maxWordLength, const int maxWords);
+    ~GestureDecoder();
+
+    // Outputs the words that best match the path, with the same layout as the suggestions of
+    // UnigramDictionary: maxWords words of maxWordLength chars, and their scores in decreasing
+    // order. Returns the number of words output.
+    int getSuggestions(const ProximityInfo *proximityInfo, const int *xCoordinates,
+            const int *yCoordinates, const int sampleCount, unsigned short *outWords,
+            int *frequencies);
+
+private:
+    void resample(const int *xCoordinates, const int *yCoordinates, const int sampleCount,
+            const float keyWidth);
+    void initializeKeys(const float keyWidth, float *keyXs, float *keyYs,
+            int *lastNearSamples) const;
+    bool processChar(const int depth, const int c);
+    void addWord(const int length, const float cost);
+
+    const uint8_t *const mRoot;
+    const int32_t *const mAlphabet;
+    const int MAX_WORD_LENGTH;
+    const int MAX_WORDS;
+
+    // Only valid during getSuggestions.
+    const ProximityInfo *mProximityInfo;
+    unsigned short *mOutputChars;
+    int *mFrequencies;
+    float mInverseSquaredKeyWidth;
+    // The point of each key, and the last sample that is close enough to it, or -1.
+    const float *mKeyXs;
+    const float *mKeyYs;
+    const int *mLastNearSamples;
+    // The cost of the words that are output, in increasing order.
+    float *mCosts;
+    int mWordCount;
+    // The cost above which a word can't be output.
+    float mCutoff;
+
+    int mSampleCount;
+    float mSampleXs[MAX_GESTURE_SAMPLES];
+    float mSampleYs[MAX_GESTURE_SAMPLES];
+
+    // The row of depth d is the alignment of the first d chars: its sample j holds the cost of
+    // the path up to j with the key of the char d - 1 at j. Only the samples from
+    // mRowStarts[d] to mRowEnds[d] can be below the cutoff. The key point is the one of the last
+    // char that has a key, if mHasKeyPoints[d].
+    float mRows[(MAX_WORD_LENGTH_INTERNAL + 1) * MAX_GESTURE_SAMPLES];
+    int mRowStarts[MAX_WORD_LENGTH_INTERNAL + 1];
+    int mRowEnds[MAX_WORD_LENGTH_INTERNAL + 1];
+    bool mHasKeyPoints[MAX_WORD_LENGTH_INTERNAL + 1];
+    float mKeyPointXs[MAX_WORD_LENGTH_INTERNAL + 1];
+    float mKeyPointYs[MAX_WORD_LENGTH_INTERNAL + 1];
+    unsigned short mWord[MAX_WORD_LENGTH_INTERNAL];
+};
+
+} // namespace latinime
+
+#endif // LATINIME_GESTURE_DECODER_H
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_HASH_UTILS_H
+#define LATINIME_HASH_UTILS_H
+
+#include <stdint.h>
+
+namespace latinime {
+
+// The hash functions shared by the hash tables and the filters of the dictionary.
+
+// The initial value of an FNV-1a hash.
+static const uint32_t FNV_OFFSET_BASIS = 2166136261U;
+// 2^32 / golden ratio: multiplying by it spreads consecutive values over all the bits.
+static const uint32_t GOLDEN_RATIO_MULTIPLIER = 0x9E3779B1U;
+
+// One step of FNV-1a, so that a hash can be computed one value at a time.
+static inline uint32_t hashFnvStep(const uint32_t hash, const uint32_t value) {
+    return (hash ^ value) * 16777619U;
+}
+
+// The multiplications of FNV-1a only carry the low bits upwards: this mixes the high bits back.
+// It is the first half of the murmur3 finalizer, with the first shift as a parameter.
+static inline uint32_t mixHashBits(uint32_t hash, const int firstShift) {
+    hash ^= hash >> firstShift;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// The whole murmur3 finalizer, where every bit of the input changes half of the output bits.
+static inline uint32_t finalizeHash(uint32_t hash) {
+    hash = mixHashBits(hash, 16);
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+} // namespace latinime
+
+#endif // LATINIME_HASH_UTILS_H
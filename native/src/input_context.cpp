@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+#include <string.h>
+
+#define LOG_TAG "LatinIME: input_context.cpp"
+
+#include "dictionary.h"
+#include "input_context.h"
+#include "ranking_params.h"
+
+namespace latinime {
+
+const int InputContext::NO_TOUCH_RATE;
+const int InputContext::OUT_OF_REACH_TOUCH_RATE;
+
+InputContext::InputContext(const ProximityInfo *proximityInfo,
+        const BaseLowerCaseTable *baseLowerCase, const RankingParams *rankingParams,
+        const int *inputCodes, const int inputLength, const int *xCoordinates,
+        const int *yCoordinates)
+        : mProximityInfo(proximityInfo), mBaseLowerCase(baseLowerCase),
+          MAX_PROXIMITY_CHARS_SIZE(proximityInfo->getMaxProximityCharsSize()),
+          mInputCodes(inputCodes), mInputLength(inputLength), mInputXCoordinates(xCoordinates),
+          mInputYCoordinates(yCoordinates),
+          mTouchPositionCorrectionEnabled(proximityInfo->hasTouchPositionCorrectionData()
+                  && xCoordinates && yCoordinates),
+          mTouchRates(0), mTouchLogCosts(0),
+          mHasProximityTable(false), mProximityTableColumnCount(0) {
+    for (int i = 0; i < inputLength; ++i) {
+        mPrimaryInputWord[i] = getPrimaryCharAt(i);
+    }
+    mPrimaryInputWord[inputLength] = 0;
+    mBaseLowerCase->toBaseLowerCase(mPrimaryInputWord, inputLength, mBaseLowerPrimaryInputWord);
+    mBaseLowerPrimaryInputWord[inputLength] = 0;
+    if (mTouchPositionCorrectionEnabled) initializeTouchTables(rankingParams);
+    initializeProximityTable();
+}
+
+InputContext::~InputContext() {
+    delete[] mTouchRates;
+}
+
+// Scores each touch against the keys of its proximity chars once, so that the scoring of a
+// word only looks up its chars. calculateFinalFreq gets the rate of the piecewise linear
+// factor of the normalized squared distance to the sweet spot, and calculateLogCost gets
+// -log2 of a Gaussian around the sweet spot, with a variance proportional to its squared
+// radius. A char whose key has no sweet spot gets the rate and the cost of a proximity char,
+// or nothing for the char that was typed.
+void InputContext::initializeTouchTables(const RankingParams *rankingParams) {
+    const int tableLength = MAX_PROXIMITY_CHARS_SIZE * MAX_WORD_LENGTH_INTERNAL;
+    mTouchRates = new int[tableLength * 2];
+    mTouchLogCosts = mTouchRates + tableLength;
+    for (int i = 0; i < tableLength; ++i) {
+        mTouchRates[i] = NO_TOUCH_RATE;
+        mTouchLogCosts[i] = 0;
+    }
+    const float A = rankingParams->mZeroDistancePromotionRate / 100.0f;
+    static const float B = 1.0f;
+    static const float C = 0.5f;
+    const float R1 = rankingParams->mNeutralScoreSquaredRadius;
+    const float R2 = rankingParams->mHalfScoreSquaredRadius;
+    const float logCostPerNat = LOG_COST_ONE_BIT / logf(2.0f);
+    const float logCostPerSquaredDistance = rankingParams->mTouchSquaredSigma > 0.0f
+            ? logCostPerNat / (2.0f * rankingParams->mTouchSquaredSigma) : 0.0f;
+
+    // The sweet spots of the keys of the proximity chars at one input index, side by side so
+    // that their distances to the touch point are computed together. A radius of 0 means that
+    // there is no sweet spot.
+    float centerXs[MAX_PROXIMITY_CHARS_SIZE];
+    float centerYs[MAX_PROXIMITY_CHARS_SIZE];
+    float radii[MAX_PROXIMITY_CHARS_SIZE];
+    float squaredDistances[MAX_PROXIMITY_CHARS_SIZE];
+    for (int i = 0; i < mInputLength; ++i) {
+        const int *proximityChars = getProximityCharsAt(i);
+        int count = 0;
+        float minRadius = 0.0f;
+        for (; count < MAX_PROXIMITY_CHARS_SIZE && proximityChars[count] > 0; ++count) {
+            const int keyIndex = mProximityInfo->getKeyIndex(proximityChars[count]);
+            if (NOT_A_INDEX != keyIndex && mProximityInfo->hasSweetSpotData(keyIndex)) {
+                centerXs[count] = mProximityInfo->getSweetSpotCenterXAt(keyIndex);
+                centerYs[count] = mProximityInfo->getSweetSpotCenterYAt(keyIndex);
+                radii[count] = mProximityInfo->getSweetSpotRadiusAt(keyIndex);
+                if (minRadius <= 0.0f || radii[count] < minRadius) minRadius = radii[count];
+            } else {
+                centerXs[count] = 0.0f;
+                centerYs[count] = 0.0f;
+                radii[count] = 0.0f;
+            }
+        }
+        ProximityInfo::calculateNormalizedSquaredDistances(centerXs, centerYs, radii, count,
+                (float)mInputXCoordinates[i], (float)mInputYCoordinates[i], squaredDistances);
+        for (int j = 0; j < count; ++j) {
+            const int touchIndex = getTouchIndex(i, j);
+            if (radii[j] > 0.0f) {
+                const int normalizedSquaredDistance = (int)(squaredDistances[j]
+                        * ProximityInfo::NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR);
+                const float x = (float)normalizedSquaredDistance
+                        / ProximityInfo::NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR;
+                const float factor = (x < R1)
+                    ? (A * (R1 - x) + B * x) / R1
+                    : (B * (R2 - x) + C * (x - R1)) / (R2 - R1);
+                // factor is piecewise linear function like:
+                // A -_                  .
+                //     ^-_               .
+                // B      \              .
+                //         \             .
+                // C        \            .
+                //   0   R1 R2
+                mTouchRates[touchIndex] = factor > 0 ? (int)(factor * 100)
+                        : OUT_OF_REACH_TOUCH_RATE;
+                // The density of a wider Gaussian is lower, by the ratio of the squared radii
+                // to the narrowest one here.
+                mTouchLogCosts[touchIndex] = (int)(x * logCostPerSquaredDistance
+                        + 2.0f * logf(radii[j] / minRadius) * logCostPerNat);
+            } else if (j > 0) {
+                mTouchRates[touchIndex] =
+                        rankingParams->mWordsWithProximityCharacterDemotionRate;
+                mTouchLogCosts[touchIndex] = rankingParams->mLogCostProximityCharacter;
+            }
+        }
+    }
+}
+
+inline int InputContext::getProximityTableColumn(const unsigned short c) const {
+    const int mask = PROXIMITY_TABLE_HASH_SIZE - 1;
+    for (int slot = ProximityInfo::hashChar(c, mask); mProximityTableChars[slot];
+            slot = (slot + 1) & mask) {
+        if (mProximityTableChars[slot] == c) return mProximityTableColumns[slot];
+    }
+    return NOT_A_INDEX;
+}
+
+void InputContext::initializeProximityTable() {
+    mHasProximityTable = false;
+    mProximityTableColumnCount = 0;
+    memset(mProximityTableChars, 0, sizeof(mProximityTableChars));
+    if (mInputLength > MAX_WORD_LENGTH_INTERNAL) return;
+    const int mask = PROXIMITY_TABLE_HASH_SIZE - 1;
+    // First give a column to each char.
+    for (int i = 0; i < mInputLength; ++i) {
+        const int *proximityChars = getProximityCharsAt(i);
+        for (int j = 0; j < MAX_PROXIMITY_CHARS_SIZE && proximityChars[j] > 0; ++j) {
+            // The table is keyed by 16 bit chars, where 0 marks an empty slot: a code above
+            // 0xFFFF would alias a char of the BMP or an empty slot, so leave the whole input to
+            // the scan.
+            if (proximityChars[j] > 0xFFFF) return;
+            const unsigned short c = proximityChars[j];
+            int slot = ProximityInfo::hashChar(c, mask);
+            while (mProximityTableChars[slot] && mProximityTableChars[slot] != c) {
+                slot = (slot + 1) & mask;
+            }
+            if (mProximityTableChars[slot]) continue;
+            if (mProximityTableColumnCount >= MAX_PROXIMITY_TABLE_CHARS) return;
+            mProximityTableChars[slot] = c;
+            mProximityTableColumns[slot] = mProximityTableColumnCount++;
+        }
+    }
+    // Then fill in the first position of each char at each index.
+    memset(mProximityTable, NOT_IN_PROXIMITY, mInputLength * mProximityTableColumnCount);
+    for (int i = 0; i < mInputLength; ++i) {
+        const int *proximityChars = getProximityCharsAt(i);
+        uint8_t *const row = mProximityTable + i * mProximityTableColumnCount;
+        for (int j = 0; j < MAX_PROXIMITY_CHARS_SIZE && proximityChars[j] > 0; ++j) {
+            const int column = getProximityTableColumn(proximityChars[j]);
+            if (NOT_A_INDEX != column && NOT_IN_PROXIMITY == row[column]) row[column] = j;
+        }
+    }
+    mHasProximityTable = true;
+}
+
+inline const int* InputContext::getProximityCharsAt(const int index) const {
+    return mInputCodes + (index * MAX_PROXIMITY_CHARS_SIZE);
+}
+
+unsigned short InputContext::getPrimaryCharAt(const int index) const {
+    return getProximityCharsAt(index)[0];
+}
+
+inline bool InputContext::existsCharInProximityAt(const int index, const int c) const {
+    const int *chars = getProximityCharsAt(index);
+    int i = 0;
+    while (chars[i] > 0 && i < MAX_PROXIMITY_CHARS_SIZE) {
+        if (chars[i++] == c) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InputContext::existsAdjacentProximityChars(const int index) const {
+    if (index < 0 || index >= mInputLength) return false;
+    const int currentChar = getPrimaryCharAt(index);
+    const int leftIndex = index - 1;
+    if (leftIndex >= 0 && existsCharInProximityAt(leftIndex, currentChar)) {
+        return true;
+    }
+    const int rightIndex = index + 1;
+    if (rightIndex < mInputLength && existsCharInProximityAt(rightIndex, currentChar)) {
+        return true;
+    }
+    return false;
+}
+
+// In the following function, c is the current character of the dictionary word
+// currently examined.
+// currentChars is an array containing the keys close to the character the
+// user actually typed at the same position. We want to see if c is in it: if so,
+// then the word contains at that position a character close to what the user
+// typed.
+// What the user typed is actually the first character of the array.
+// proximityIndex is a pointer to the variable where getMatchedProximityId returns
+// the index of c in the proximity chars of the input index.
+// Notice : accented characters do not have a proximity list, so they are alone
+// in their list. The non-accented version of the character should be considered
+// "close", but not the other keys close to the non-accented version.
+ProximityInfo::ProximityType InputContext::getMatchedProximityId(const int index,
+        const unsigned short c, const unsigned short baseLowerC, const bool checkProximityChars,
+        int *proximityIndex) const {
+    // The corrections sometimes look one char past the input.
+    if (!mHasProximityTable || index < 0 || index >= mInputLength) {
+        return getMatchedProximityIdByScanning(index, c, baseLowerC, checkProximityChars,
+                proximityIndex);
+    }
+    const uint8_t *const row = mProximityTable + index * mProximityTableColumnCount;
+    const int column = getProximityTableColumn(c);
+    int position = NOT_A_INDEX == column ? NOT_IN_PROXIMITY : row[column];
+    if (baseLowerC != c) {
+        const int baseLowerColumn = getProximityTableColumn(baseLowerC);
+        if (NOT_A_INDEX != baseLowerColumn) position = min(position, row[baseLowerColumn]);
+    }
+    // Position 0 is what the user typed.
+    if (0 == position) return ProximityInfo::EQUIVALENT_CHAR;
+    if (!checkProximityChars) return ProximityInfo::UNRELATED_CHAR;
+    if (mBaseLowerPrimaryInputWord[index] == baseLowerC) return ProximityInfo::NEAR_PROXIMITY_CHAR;
+    if (NOT_IN_PROXIMITY == position) return ProximityInfo::UNRELATED_CHAR;
+    if (proximityIndex) {
+        *proximityIndex = position;
+    }
+    return ProximityInfo::NEAR_PROXIMITY_CHAR;
+}
+
+ProximityInfo::ProximityType InputContext::getMatchedProximityIdByScanning(const int index,
+        const unsigned short c, const unsigned short baseLowerC, const bool checkProximityChars,
+        int *proximityIndex) const {
+    const int *currentChars = getProximityCharsAt(index);
+    const int firstChar = currentChars[0];
+
+    // The first char in the array is what user typed. If it matches right away,
+    // that means the user typed that same char for this pos.
+    if (firstChar == baseLowerC || firstChar == c) {
+        return ProximityInfo::EQUIVALENT_CHAR;
+    }
+
+    if (!checkProximityChars) return ProximityInfo::UNRELATED_CHAR;
+
+    // If the non-accented, lowercased version of that first character matches c,
+    // then we have a non-accented version of the accented character the user
+    // typed. Treat it as a close char.
+    if (mBaseLowerCase->toBaseLowerCase(firstChar) == baseLowerC)
+        return ProximityInfo::NEAR_PROXIMITY_CHAR;
+
+    // Not an exact nor an accent-alike match: search the list of close keys
+    int j = 1;
+    while (j < MAX_PROXIMITY_CHARS_SIZE && currentChars[j] > 0) {
+        const bool matched = (currentChars[j] == baseLowerC || currentChars[j] == c);
+        if (matched) {
+            if (proximityIndex) {
+                *proximityIndex = j;
+            }
+            return ProximityInfo::NEAR_PROXIMITY_CHAR;
+        }
+        ++j;
+    }
+
+    // Was not included, signal this as an unrelated character.
+    return ProximityInfo::UNRELATED_CHAR;
+}
+
+bool InputContext::sameAsTyped(const unsigned short *word, int length) const {
+    if (length != mInputLength) {
+        return false;
+    }
+    const int *inputCodes = mInputCodes;
+    while (length--) {
+        if ((unsigned int) *inputCodes != (unsigned int) *word) {
+            return false;
+        }
+        inputCodes += MAX_PROXIMITY_CHARS_SIZE;
+        word++;
+    }
+    return true;
+}
+
+const int InputContext::MAX_PROXIMITY_TABLE_CHARS;
+const int InputContext::PROXIMITY_TABLE_HASH_SIZE;
+const uint8_t InputContext::NOT_IN_PROXIMITY;
+
+} // namespace latinime
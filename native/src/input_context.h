@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LATINIME_INPUT_CONTEXT_H
+#define LATINIME_INPUT_CONTEXT_H
+
+#include <stdint.h>
+
+#include "defines.h"
+#include "proximity_info.h"
+
+namespace latinime {
+
+class BaseLowerCaseTable;
+struct RankingParams;
+
+// What one query knows about its input: the proximity chars and the touch points of the
+// chars, and what the touch points say about the keys of the ProximityInfo. It only
+// lives as long as the query, on the stack of the caller, so that the ProximityInfo itself
+// never changes and several queries can use it at the same time.
+// The input codes and coordinates are not copied and must outlive the context.
+class InputContext {
+public:
+    // The touch rate of a char that leaves the frequency as is, and the one of a char whose key
+    // is too far from the touch for the word to be suggested.
+    static const int NO_TOUCH_RATE = -1;
+    static const int OUT_OF_REACH_TOUCH_RATE = -2;
+
+    InputContext(const ProximityInfo *proximityInfo, const BaseLowerCaseTable *baseLowerCase,
+            const RankingParams *rankingParams, const int *inputCodes, const int inputLength,
+            const int *xCoordinates, const int *yCoordinates);
+    ~InputContext();
+    const int* getProximityCharsAt(const int index) const;
+    unsigned short getPrimaryCharAt(const int index) const;
+    bool existsCharInProximityAt(const int index, const int c) const;
+    bool existsAdjacentProximityChars(const int index) const;
+    // baseLowerC is getBaseLowerCase()->toBaseLowerCase(c), which the callers fold once per
+    // char.
+    ProximityInfo::ProximityType getMatchedProximityId(const int index, const unsigned short c,
+            const unsigned short baseLowerC, const bool checkProximityChars,
+            int *proximityIndex = NULL) const;
+    // The touch tables are only filled in if touchPositionCorrectionEnabled().
+    int getTouchIndex(const int inputIndex, const int proximityIndex) const {
+        return inputIndex * MAX_PROXIMITY_CHARS_SIZE + proximityIndex;
+    }
+    // The rate calculateFinalFreq multiplies the frequency by for the char at a touch index, or
+    // NO_TOUCH_RATE or OUT_OF_REACH_TOUCH_RATE.
+    int getTouchRate(const int touchIndex) const { return mTouchRates[touchIndex]; }
+    // The cost calculateLogCost adds for the char at a touch index, in LOG_COST_ONE_BIT units.
+    int getTouchLogCost(const int touchIndex) const { return mTouchLogCosts[touchIndex]; }
+    bool sameAsTyped(const unsigned short *word, int length) const;
+    const unsigned short* getPrimaryInputWord() const {
+        return mPrimaryInputWord;
+    }
+    const unsigned short* getBaseLowerPrimaryInputWord() const {
+        return mBaseLowerPrimaryInputWord;
+    }
+    bool touchPositionCorrectionEnabled() const {
+        return mTouchPositionCorrectionEnabled;
+    }
+    int getInputLength() const { return mInputLength; }
+    // The base lower case of the dictionary, that the input and the words are folded with.
+    const BaseLowerCaseTable *getBaseLowerCase() const { return mBaseLowerCase; }
+
+private:
+    // The number of distinct chars the proximity table can hold for one input. With more,
+    // getMatchedProximityId scans the proximity chars instead.
+    static const int MAX_PROXIMITY_TABLE_CHARS = 128;
+    // The size of the open addressing hash from a char to its column in the proximity table.
+    // This must be a power of 2, and larger than MAX_PROXIMITY_TABLE_CHARS.
+    static const int PROXIMITY_TABLE_HASH_SIZE = 256;
+    static const uint8_t NOT_IN_PROXIMITY = 0xFF;
+
+    void initializeTouchTables(const RankingParams *rankingParams);
+    void initializeProximityTable();
+    int getProximityTableColumn(const unsigned short c) const;
+    ProximityInfo::ProximityType getMatchedProximityIdByScanning(const int index,
+            const unsigned short c, const unsigned short baseLowerC,
+            const bool checkProximityChars, int *proximityIndex) const;
+
+    const ProximityInfo *const mProximityInfo;
+    const BaseLowerCaseTable *const mBaseLowerCase;
+    const int MAX_PROXIMITY_CHARS_SIZE;
+    const int *const mInputCodes;
+    const int mInputLength;
+    const int *const mInputXCoordinates;
+    const int *const mInputYCoordinates;
+    const bool mTouchPositionCorrectionEnabled;
+    int *mTouchRates;
+    int *mTouchLogCosts;
+    unsigned short mPrimaryInputWord[MAX_WORD_LENGTH_INTERNAL];
+    // For each input index i and each char that is in some proximity list of the input,
+    // mProximityTable[i * mProximityTableColumnCount + column of the char] is the first
+    // position of the char in the proximity chars at i, or NOT_IN_PROXIMITY. This turns the
+    // scan of getMatchedProximityId into one or two look ups.
+    bool mHasProximityTable;
+    int mProximityTableColumnCount;
+    uint16_t mProximityTableChars[PROXIMITY_TABLE_HASH_SIZE];
+    uint8_t mProximityTableColumns[PROXIMITY_TABLE_HASH_SIZE];
+    uint8_t mProximityTable[MAX_WORD_LENGTH_INTERNAL * MAX_PROXIMITY_TABLE_CHARS];
+    unsigned short mBaseLowerPrimaryInputWord[MAX_WORD_LENGTH_INTERNAL];
+};
+
+} // namespace latinime
+
+#endif // LATINIME_INPUT_CONTEXT_H
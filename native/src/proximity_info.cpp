@@ -18,6 +18,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #define LOG_TAG "LatinIME: proximity_info.cpp"
 
 #include "dictionary.h"
@@ -43,26 +49,27 @@ ProximityInfo::ProximityInfo(const int maxProximityCharsSize, const int keyboard
           KEYBOARD_HEIGHT(keyboardHeight), GRID_WIDTH(gridWidth), GRID_HEIGHT(gridHeight),
           CELL_WIDTH((keyboardWidth + gridWidth - 1) / gridWidth),
           CELL_HEIGHT((keyboardHeight + gridHeight - 1) / gridHeight),
-          KEY_COUNT(min(keyCount, MAX_KEY_COUNT_IN_A_KEYBOARD)),
+          KEY_COUNT(max(keyCount, 0)),
           HAS_TOUCH_POSITION_CORRECTION_DATA(keyCount > 0 && keyXCoordinates && keyYCoordinates
                   && keyWidths && keyHeights && keyCharCodes && sweetSpotCenterXs
-                  && sweetSpotCenterYs && sweetSpotRadii),
-          mInputXCoordinates(NULL), mInputYCoordinates(NULL),
-          mTouchPositionCorrectionEnabled(false) {
+                  && sweetSpotCenterYs && sweetSpotRadii) {
     const int proximityGridLength = GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE;
-    mProximityCharsArray = new uint32_t[proximityGridLength];
+    mProximityChars = new uint16_t[proximityGridLength];
     if (DEBUG_PROXIMITY_INFO) {
         LOGI("Create proximity info array %d", proximityGridLength);
     }
-    memcpy(mProximityCharsArray, proximityCharsArray,
-            proximityGridLength * sizeof(mProximityCharsArray[0]));
-    const int normalizedSquaredDistancesLength =
-            MAX_PROXIMITY_CHARS_SIZE * MAX_WORD_LENGTH_INTERNAL;
-    mNormalizedSquaredDistances = new int[normalizedSquaredDistancesLength];
-    for (int i = 0; i < normalizedSquaredDistancesLength; ++i) {
-        mNormalizedSquaredDistances[i] = NOT_A_DISTANCE;
+    for (int i = 0; i < proximityGridLength; ++i) {
+        mProximityChars[i] = toGridChar(proximityCharsArray[i]);
     }
 
+    mKeyXCoordinates = new int32_t[KEY_COUNT];
+    mKeyYCoordinates = new int32_t[KEY_COUNT];
+    mKeyWidths = new int32_t[KEY_COUNT];
+    mKeyHeights = new int32_t[KEY_COUNT];
+    mKeyCharCodes = new int32_t[KEY_COUNT];
+    mSweetSpotCenterXs = new float[KEY_COUNT];
+    mSweetSpotCenterYs = new float[KEY_COUNT];
+    mSweetSpotRadii = new float[KEY_COUNT];
     copyOrFillZero(mKeyXCoordinates, keyXCoordinates, KEY_COUNT * sizeof(mKeyXCoordinates[0]));
     copyOrFillZero(mKeyYCoordinates, keyYCoordinates, KEY_COUNT * sizeof(mKeyYCoordinates[0]));
     copyOrFillZero(mKeyWidths, keyWidths, KEY_COUNT * sizeof(mKeyWidths[0]));
@@ -75,23 +82,104 @@ ProximityInfo::ProximityInfo(const int maxProximityCharsSize, const int keyboard
     copyOrFillZero(mSweetSpotRadii, sweetSpotRadii, KEY_COUNT * sizeof(mSweetSpotRadii[0]));
 
     initializeCodeToKeyIndex();
+    mMostCommonKeyWidth = computeMostCommonKeyWidth();
+}
+
+// Like the Java Keyboard does, but over the keys that have a char only, so that a wide space
+// bar or function key can't win on a small layout.
+int ProximityInfo::computeMostCommonKeyWidth() const {
+    int mostCommonWidth = 0;
+    int maxCount = 0;
+    for (int i = 0; i < KEY_COUNT; ++i) {
+        if (mKeyCharCodes[i] <= KEYCODE_SPACE || mKeyWidths[i] <= 0) continue;
+        int count = 0;
+        for (int j = 0; j < KEY_COUNT; ++j) {
+            if (mKeyWidths[j] == mKeyWidths[i] && mKeyCharCodes[j] > KEYCODE_SPACE) ++count;
+        }
+        if (count > maxCount) {
+            maxCount = count;
+            mostCommonWidth = mKeyWidths[i];
+        }
+    }
+    return mostCommonWidth;
 }
 
 // Build the reversed look up table from the char code to the index in mKeyXCoordinates,
 // mKeyYCoordinates, mKeyWidths, mKeyHeights, mKeyCharCodes.
 void ProximityInfo::initializeCodeToKeyIndex() {
-    memset(mCodeToKeyIndex, -1, (MAX_CHAR_CODE + 1) * sizeof(mCodeToKeyIndex[0]));
+    int slotCount = 2;
+    while (slotCount < KEY_COUNT * 2) slotCount <<= 1;
+    mCodeToKeyIndexMask = slotCount - 1;
+    mCodeToKeyIndexCodes = new int32_t[slotCount];
+    mCodeToKeyIndex = new int[slotCount];
+    memset(mCodeToKeyIndexCodes, 0, slotCount * sizeof(mCodeToKeyIndexCodes[0]));
     for (int i = 0; i < KEY_COUNT; ++i) {
         const int code = mKeyCharCodes[i];
-        if (0 <= code && code <= MAX_CHAR_CODE) {
-            mCodeToKeyIndex[code] = i;
+        // The function keys have negative codes.
+        if (code <= 0) continue;
+        int slot = hashChar(code, mCodeToKeyIndexMask);
+        while (mCodeToKeyIndexCodes[slot] && mCodeToKeyIndexCodes[slot] != code) {
+            slot = (slot + 1) & mCodeToKeyIndexMask;
         }
+        // If several keys have the same code, the last one wins.
+        mCodeToKeyIndexCodes[slot] = code;
+        mCodeToKeyIndex[slot] = i;
     }
 }
 
+// A missing array was filled with zeros.
+template<typename T>
+static bool isSameArray(const T *array, const T *other, const int length) {
+    if (other) return 0 == memcmp(array, other, length * sizeof(array[0]));
+    for (int i = 0; i < length; ++i) {
+        if (0 != array[i]) return false;
+    }
+    return true;
+}
+
+bool ProximityInfo::hasSameLayout(const int maxProximityCharsSize, const int keyboardWidth,
+        const int keyboardHeight, const int gridWidth, const int gridHeight,
+        const uint32_t *proximityCharsArray, const int keyCount, const int32_t *keyXCoordinates,
+        const int32_t *keyYCoordinates, const int32_t *keyWidths, const int32_t *keyHeights,
+        const int32_t *keyCharCodes, const float *sweetSpotCenterXs, const float *sweetSpotCenterYs,
+        const float *sweetSpotRadii) const {
+    if (maxProximityCharsSize != MAX_PROXIMITY_CHARS_SIZE || keyboardWidth != KEYBOARD_WIDTH
+            || keyboardHeight != KEYBOARD_HEIGHT || gridWidth != GRID_WIDTH
+            || gridHeight != GRID_HEIGHT || max(keyCount, 0) != KEY_COUNT) {
+        return false;
+    }
+    const bool hasTouchPositionCorrectionData = keyCount > 0 && keyXCoordinates
+            && keyYCoordinates && keyWidths && keyHeights && keyCharCodes && sweetSpotCenterXs
+            && sweetSpotCenterYs && sweetSpotRadii;
+    if (hasTouchPositionCorrectionData != HAS_TOUCH_POSITION_CORRECTION_DATA) return false;
+    const int proximityGridLength = GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE;
+    // Without an early exit, this loop is vectorized.
+    int difference = 0;
+    for (int i = 0; i < proximityGridLength; ++i) {
+        difference |= mProximityChars[i] ^ toGridChar(proximityCharsArray[i]);
+    }
+    return 0 == difference && isSameArray(mKeyXCoordinates, keyXCoordinates, KEY_COUNT)
+            && isSameArray(mKeyYCoordinates, keyYCoordinates, KEY_COUNT)
+            && isSameArray(mKeyWidths, keyWidths, KEY_COUNT)
+            && isSameArray(mKeyHeights, keyHeights, KEY_COUNT)
+            && isSameArray(mKeyCharCodes, keyCharCodes, KEY_COUNT)
+            && isSameArray(mSweetSpotCenterXs, sweetSpotCenterXs, KEY_COUNT)
+            && isSameArray(mSweetSpotCenterYs, sweetSpotCenterYs, KEY_COUNT)
+            && isSameArray(mSweetSpotRadii, sweetSpotRadii, KEY_COUNT);
+}
+
 ProximityInfo::~ProximityInfo() {
-    delete[] mNormalizedSquaredDistances;
-    delete[] mProximityCharsArray;
+    delete[] mProximityChars;
+    delete[] mKeyXCoordinates;
+    delete[] mKeyYCoordinates;
+    delete[] mKeyWidths;
+    delete[] mKeyHeights;
+    delete[] mKeyCharCodes;
+    delete[] mSweetSpotCenterXs;
+    delete[] mSweetSpotCenterYs;
+    delete[] mSweetSpotRadii;
+    delete[] mCodeToKeyIndexCodes;
+    delete[] mCodeToKeyIndex;
 }
 
 inline int ProximityInfo::getStartIndexFromCoordinates(const int x, const int y) const {
@@ -106,183 +194,134 @@ bool ProximityInfo::hasSpaceProximity(const int x, const int y) const {
     }
     for (int i = 0; i < MAX_PROXIMITY_CHARS_SIZE; ++i) {
         if (DEBUG_PROXIMITY_INFO) {
-            LOGI("Index: %d", mProximityCharsArray[startIndex + i]);
+            LOGI("Index: %d", mProximityChars[startIndex + i]);
         }
-        if (mProximityCharsArray[startIndex + i] == KEYCODE_SPACE) {
+        if (mProximityChars[startIndex + i] == KEYCODE_SPACE) {
             return true;
         }
     }
     return false;
 }
 
-// TODO: Calculate nearby codes here.
-void ProximityInfo::setInputParams(const int* inputCodes, const int inputLength,
-        const int* xCoordinates, const int* yCoordinates) {
-    mInputCodes = inputCodes;
-    mInputXCoordinates = xCoordinates;
-    mInputYCoordinates = yCoordinates;
-    mTouchPositionCorrectionEnabled =
-            HAS_TOUCH_POSITION_CORRECTION_DATA && xCoordinates && yCoordinates;
-    mInputLength = inputLength;
-    for (int i = 0; i < inputLength; ++i) {
-        mPrimaryInputWord[i] = getPrimaryCharAt(i);
-    }
-    mPrimaryInputWord[inputLength] = 0;
-    for (int i = 0; i < mInputLength; ++i) {
-        const int *proximityChars = getProximityCharsAt(i);
-        for (int j = 0; j < MAX_PROXIMITY_CHARS_SIZE && proximityChars[j] > 0; ++j) {
-            const int currentChar = proximityChars[j];
-            const int keyIndex = getKeyIndex(currentChar);
-            const float squaredDistance = calculateNormalizedSquaredDistance(keyIndex, i);
-            if (squaredDistance >= 0.0f) {
-                mNormalizedSquaredDistances[i * MAX_PROXIMITY_CHARS_SIZE + j] =
-                        (int)(squaredDistance * NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR);
-            } else {
-                mNormalizedSquaredDistances[i * MAX_PROXIMITY_CHARS_SIZE + j] = (j == 0)
-                        ? EQUIVALENT_CHAR_WITHOUT_DISTANCE_INFO
-                        : PROXIMITY_CHAR_WITHOUT_DISTANCE_INFO;
+// Builds the input codes from the primary code and the touch point of each char, so that the
+// caller does not have to send the proximity chars. Like KeyDetector on the Java side, the
+// proximity chars of a touch point are the keys of its grid cell that are closer to it than a
+// key width, nearest edge first. A char without a touch point only has its primary code.
+// outInputCodes must have room for MAX_PROXIMITY_CHARS_SIZE codes per char.
+void ProximityInfo::computeProximityCodes(const int *primaryCodes, const int inputLength,
+        const int *xCoordinates, const int *yCoordinates, int *outInputCodes) const {
+    const int length = min(inputLength, MAX_WORD_LENGTH_INTERNAL);
+    int distances[MAX_PROXIMITY_CHARS_SIZE];
+    for (int i = 0; i < length; ++i) {
+        int *const codes = outInputCodes + i * MAX_PROXIMITY_CHARS_SIZE;
+        const int primaryCode = primaryCodes[i];
+        codes[0] = primaryCode;
+        int count = 1;
+        const int x = xCoordinates ? xCoordinates[i] : NOT_A_INDEX;
+        const int y = yCoordinates ? yCoordinates[i] : NOT_A_INDEX;
+        if (x >= 0 && y >= 0 && x < GRID_WIDTH * CELL_WIDTH && y < GRID_HEIGHT * CELL_HEIGHT) {
+            const int primaryKeyIndex = getKeyIndexOfCode(primaryCode);
+            const int keyWidth = NOT_A_INDEX == primaryKeyIndex ? 0 : mKeyWidths[primaryKeyIndex];
+            const int threshold = keyWidth > 0 ? keyWidth * keyWidth : S_INT_MAX;
+            const uint16_t *const cell = mProximityChars + getStartIndexFromCoordinates(x, y);
+            for (int j = 0; j < MAX_PROXIMITY_CHARS_SIZE && count < MAX_PROXIMITY_CHARS_SIZE;
+                    ++j) {
+                const int c = cell[j];
+                if (NOT_A_GRID_CHAR == c) break;
+                // The primary code is already first, and the function keys are not chars.
+                if (c == primaryCode || c < KEYCODE_SPACE) continue;
+                const int keyIndex = getKeyIndexOfCode(c);
+                // Without the geometry of the key, keep the order of the grid.
+                const int distance = NOT_A_INDEX == keyIndex || mKeyWidths[keyIndex] <= 0
+                        ? S_INT_MAX - 1 : getSquaredDistanceToKeyEdge(keyIndex, x, y);
+                if (distance >= threshold) continue;
+                int position = count++;
+                while (position > 1 && distances[position - 1] > distance) {
+                    codes[position] = codes[position - 1];
+                    distances[position] = distances[position - 1];
+                    --position;
+                }
+                codes[position] = c;
+                distances[position] = distance;
             }
         }
+        for (int j = count; j < MAX_PROXIMITY_CHARS_SIZE; ++j) {
+            codes[j] = NOT_A_CHARACTER;
+        }
     }
 }
 
-inline float square(const float x) { return x * x; }
-
-float ProximityInfo::calculateNormalizedSquaredDistance(
-        const int keyIndex, const int inputIndex) const {
-    static const float NOT_A_DISTANCE_FLOAT = -1.0f;
-    if (keyIndex == NOT_A_INDEX) {
-        return NOT_A_DISTANCE_FLOAT;
-    }
-    if (!hasSweetSpotData(keyIndex)) {
-        return NOT_A_DISTANCE_FLOAT;
-    }
-    const float squaredDistance = calculateSquaredDistanceFromSweetSpotCenter(keyIndex, inputIndex);
-    const float squaredRadius = square(mSweetSpotRadii[keyIndex]);
-    return squaredDistance / squaredRadius;
-}
-
-int ProximityInfo::getKeyIndex(const int c) const {
-    if (KEY_COUNT == 0 || !mInputXCoordinates || !mInputYCoordinates) {
-        // We do not have the coordinate data
-        return NOT_A_INDEX;
-    }
-    const unsigned short baseLowerC = Dictionary::toBaseLowerCase(c);
-    if (baseLowerC > MAX_CHAR_CODE) {
-        return NOT_A_INDEX;
-    }
-    return mCodeToKeyIndex[baseLowerC];
-}
-
-float ProximityInfo::calculateSquaredDistanceFromSweetSpotCenter(
-        const int keyIndex, const int inputIndex) const {
-    const float sweetSpotCenterX = mSweetSpotCenterXs[keyIndex];
-    const float sweetSpotCenterY = mSweetSpotCenterYs[keyIndex];
-    const float inputX = (float)mInputXCoordinates[inputIndex];
-    const float inputY = (float)mInputYCoordinates[inputIndex];
-    return square(inputX - sweetSpotCenterX) + square(inputY - sweetSpotCenterY);
-}
-
-inline const int* ProximityInfo::getProximityCharsAt(const int index) const {
-    return mInputCodes + (index * MAX_PROXIMITY_CHARS_SIZE);
+inline int ProximityInfo::getSquaredDistanceToKeyEdge(const int keyIndex, const int x,
+        const int y) const {
+    const int left = mKeyXCoordinates[keyIndex];
+    const int right = left + mKeyWidths[keyIndex];
+    const int top = mKeyYCoordinates[keyIndex];
+    const int bottom = top + mKeyHeights[keyIndex];
+    const int dx = x < left ? left - x : (x > right ? x - right : 0);
+    const int dy = y < top ? top - y : (y > bottom ? y - bottom : 0);
+    return dx * dx + dy * dy;
 }
 
-unsigned short ProximityInfo::getPrimaryCharAt(const int index) const {
-    return getProximityCharsAt(index)[0];
-}
+inline float square(const float x) { return x * x; }
 
-inline bool ProximityInfo::existsCharInProximityAt(const int index, const int c) const {
-    const int *chars = getProximityCharsAt(index);
+// Computes the squared distances from (x, y) to the sweet spot centers of the keys, divided by
+// the squared radii of the sweet spots, four keys at a time where the CPU allows it. SSE gives
+// the same results as the scalar code; NEON has no division, so its results may differ in the
+// last bit. A key without a sweet spot has a radius of 0 and gets an infinite or NaN distance:
+// check hasSweetSpotData before using it.
+void ProximityInfo::calculateNormalizedSquaredDistances(const float *centerXs,
+        const float *centerYs, const float *radii, const int keyCount, const float x,
+        const float y, float *outDistances) {
     int i = 0;
-    while (chars[i] > 0 && i < MAX_PROXIMITY_CHARS_SIZE) {
-        if (chars[i++] == c) {
-            return true;
-        }
+#if defined(__SSE2__)
+    const __m128 xs = _mm_set1_ps(x);
+    const __m128 ys = _mm_set1_ps(y);
+    for (; i + 4 <= keyCount; i += 4) {
+        const __m128 dx = _mm_sub_ps(xs, _mm_loadu_ps(centerXs + i));
+        const __m128 dy = _mm_sub_ps(ys, _mm_loadu_ps(centerYs + i));
+        const __m128 r = _mm_loadu_ps(radii + i);
+        const __m128 squaredDistances = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        _mm_storeu_ps(outDistances + i, _mm_div_ps(squaredDistances, _mm_mul_ps(r, r)));
     }
-    return false;
-}
-
-bool ProximityInfo::existsAdjacentProximityChars(const int index) const {
-    if (index < 0 || index >= mInputLength) return false;
-    const int currentChar = getPrimaryCharAt(index);
-    const int leftIndex = index - 1;
-    if (leftIndex >= 0 && existsCharInProximityAt(leftIndex, currentChar)) {
-        return true;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t xs = vdupq_n_f32(x);
+    const float32x4_t ys = vdupq_n_f32(y);
+    for (; i + 4 <= keyCount; i += 4) {
+        const float32x4_t dx = vsubq_f32(xs, vld1q_f32(centerXs + i));
+        const float32x4_t dy = vsubq_f32(ys, vld1q_f32(centerYs + i));
+        const float32x4_t r = vld1q_f32(radii + i);
+        const float32x4_t squaredRadii = vmulq_f32(r, r);
+        const float32x4_t squaredDistances = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+        // Two Newton-Raphson steps bring the reciprocal estimate to full precision.
+        float32x4_t inverse = vrecpeq_f32(squaredRadii);
+        inverse = vmulq_f32(vrecpsq_f32(squaredRadii, inverse), inverse);
+        inverse = vmulq_f32(vrecpsq_f32(squaredRadii, inverse), inverse);
+        vst1q_f32(outDistances + i, vmulq_f32(squaredDistances, inverse));
     }
-    const int rightIndex = index + 1;
-    if (rightIndex < mInputLength && existsCharInProximityAt(rightIndex, currentChar)) {
-        return true;
+#endif
+    for (; i < keyCount; ++i) {
+        outDistances[i] = (square(x - centerXs[i]) + square(y - centerYs[i])) / square(radii[i]);
     }
-    return false;
 }
 
-// In the following function, c is the current character of the dictionary word
-// currently examined.
-// currentChars is an array containing the keys close to the character the
-// user actually typed at the same position. We want to see if c is in it: if so,
-// then the word contains at that position a character close to what the user
-// typed.
-// What the user typed is actually the first character of the array.
-// proximityIndex is a pointer to the variable where getMatchedProximityId returns
-// the index of c in the proximity chars of the input index.
-// Notice : accented characters do not have a proximity list, so they are alone
-// in their list. The non-accented version of the character should be considered
-// "close", but not the other keys close to the non-accented version.
-ProximityInfo::ProximityType ProximityInfo::getMatchedProximityId(const int index,
-        const unsigned short c, const bool checkProximityChars, int *proximityIndex) const {
-    const int *currentChars = getProximityCharsAt(index);
-    const int firstChar = currentChars[0];
-    const unsigned short baseLowerC = Dictionary::toBaseLowerCase(c);
-
-    // The first char in the array is what user typed. If it matches right away,
-    // that means the user typed that same char for this pos.
-    if (firstChar == baseLowerC || firstChar == c) {
-        return EQUIVALENT_CHAR;
-    }
-
-    if (!checkProximityChars) return UNRELATED_CHAR;
-
-    // If the non-accented, lowercased version of that first character matches c,
-    // then we have a non-accented version of the accented character the user
-    // typed. Treat it as a close char.
-    if (Dictionary::toBaseLowerCase(firstChar) == baseLowerC)
-        return NEAR_PROXIMITY_CHAR;
-
-    // Not an exact nor an accent-alike match: search the list of close keys
-    int j = 1;
-    while (j < MAX_PROXIMITY_CHARS_SIZE && currentChars[j] > 0) {
-        const bool matched = (currentChars[j] == baseLowerC || currentChars[j] == c);
-        if (matched) {
-            if (proximityIndex) {
-                *proximityIndex = j;
-            }
-            return NEAR_PROXIMITY_CHAR;
-        }
-        ++j;
+inline int ProximityInfo::getKeyIndexOfCode(const int code) const {
+    for (int slot = hashChar(code, mCodeToKeyIndexMask); mCodeToKeyIndexCodes[slot];
+            slot = (slot + 1) & mCodeToKeyIndexMask) {
+        if (mCodeToKeyIndexCodes[slot] == code) return mCodeToKeyIndex[slot];
     }
-
-    // Was not included, signal this as an unrelated character.
-    return UNRELATED_CHAR;
+    return NOT_A_INDEX;
 }
 
-bool ProximityInfo::sameAsTyped(const unsigned short *word, int length) const {
-    if (length != mInputLength) {
-        return false;
-    }
-    const int *inputCodes = mInputCodes;
-    while (length--) {
-        if ((unsigned int) *inputCodes != (unsigned int) *word) {
-            return false;
-        }
-        inputCodes += MAX_PROXIMITY_CHARS_SIZE;
-        word++;
-    }
-    return true;
+int ProximityInfo::getKeyIndex(const int c) const {
+    if (KEY_COUNT == 0) return NOT_A_INDEX;
+    // A char with a key of its own, like an accented letter on some layouts, uses that key;
+    // the others use the key of their base lower case.
+    const int keyIndex = getKeyIndexOfCode(c);
+    if (NOT_A_INDEX != keyIndex) return keyIndex;
+    return getKeyIndexOfCode(Dictionary::toBaseLowerCase(c));
 }
 
 const int ProximityInfo::NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR_LOG_2;
 const int ProximityInfo::NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR;
-const int ProximityInfo::MAX_KEY_COUNT_IN_A_KEYBOARD;
-const int ProximityInfo::MAX_CHAR_CODE;
 
 } // namespace latinime
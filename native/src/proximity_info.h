@@ -25,6 +25,9 @@ namespace latinime {
 
 class Correction;
 
+// The layout of a keyboard: its proximity grid and the geometry of its keys. It does not change
+// once built, so the suggestions of several dictionaries can share it, even from several
+// threads. What depends on the input is in InputContext.
 class ProximityInfo {
 public:
     static const int NORMALIZED_SQUARED_DISTANCE_SCALING_FACTOR_LOG_2 = 10;
@@ -49,42 +52,61 @@ public:
             const float *sweetSpotCenterYs, const float *sweetSpotRadii);
     ~ProximityInfo();
     bool hasSpaceProximity(const int x, const int y) const;
-    void setInputParams(const int* inputCodes, const int inputLength,
-            const int *xCoordinates, const int *yCoordinates);
-    const int* getProximityCharsAt(const int index) const;
-    unsigned short getPrimaryCharAt(const int index) const;
-    bool existsCharInProximityAt(const int index, const int c) const;
-    bool existsAdjacentProximityChars(const int index) const;
-    ProximityType getMatchedProximityId(const int index, const unsigned short c,
-            const bool checkProximityChars, int *proximityIndex = NULL) const;
-    int getNormalizedSquaredDistance(const int inputIndex, const int proximityIndex) const {
-        return mNormalizedSquaredDistances[inputIndex * MAX_PROXIMITY_CHARS_SIZE + proximityIndex];
+    void computeProximityCodes(const int *primaryCodes, const int inputLength,
+            const int *xCoordinates, const int *yCoordinates, int *outInputCodes) const;
+    int getMaxProximityCharsSize() const { return MAX_PROXIMITY_CHARS_SIZE; }
+    int getKeyCount() const { return KEY_COUNT; }
+    bool hasTouchPositionCorrectionData() const { return HAS_TOUCH_POSITION_CORRECTION_DATA; }
+    int getKeyIndex(const int c) const;
+    bool hasSweetSpotData(const int keyIndex) const {
+        // When there are no calibration data for a key,
+        // the radius of the key is assigned to zero.
+        return mSweetSpotRadii[keyIndex] > 0.0;
     }
-    bool sameAsTyped(const unsigned short *word, int length) const;
-    const unsigned short* getPrimaryInputWord() const {
-        return mPrimaryInputWord;
+    float getSweetSpotCenterXAt(const int keyIndex) const {
+        return mSweetSpotCenterXs[keyIndex];
     }
-    bool touchPositionCorrectionEnabled() const {
-        return mTouchPositionCorrectionEnabled;
+    float getSweetSpotCenterYAt(const int keyIndex) const {
+        return mSweetSpotCenterYs[keyIndex];
+    }
+    float getSweetSpotRadiusAt(const int keyIndex) const { return mSweetSpotRadii[keyIndex]; }
+    float getKeyCenterXAt(const int keyIndex) const {
+        return mKeyXCoordinates[keyIndex] + mKeyWidths[keyIndex] * 0.5f;
+    }
+    float getKeyCenterYAt(const int keyIndex) const {
+        return mKeyYCoordinates[keyIndex] + mKeyHeights[keyIndex] * 0.5f;
+    }
+    // The width of most of the letter keys, or 0 without key geometry.
+    int getMostCommonKeyWidth() const { return mMostCommonKeyWidth; }
+    // Whether this was built from the same parameters, which ProximityInfoCache uses to tell
+    // apart the layouts that have the same hash.
+    bool hasSameLayout(const int maxProximityCharsSize, const int keyboardWidth,
+            const int keyboardHeight, const int gridWidth, const int gridHeight,
+            const uint32_t *proximityCharsArray, const int keyCount, const int32_t *keyXCoordinates,
+            const int32_t *keyYCoordinates, const int32_t *keyWidths, const int32_t *keyHeights,
+            const int32_t *keyCharCodes, const float *sweetSpotCenterXs,
+            const float *sweetSpotCenterYs, const float *sweetSpotRadii) const;
+    static void calculateNormalizedSquaredDistances(const float *centerXs,
+            const float *centerYs, const float *radii, const int keyCount, const float x,
+            const float y, float *outDistances);
+    // The chars are mostly consecutive letters: spread them with a Fibonacci hash.
+    static int hashChar(const unsigned int c, const int mask) {
+        return (c * 40503U >> 8) & mask;
     }
 
 private:
-    // The max number of the keys in one keyboard layout
-    static const int MAX_KEY_COUNT_IN_A_KEYBOARD = 64;
-    // The upper limit of the char code in mCodeToKeyIndex
-    static const int MAX_CHAR_CODE = 127;
+    static const uint16_t NOT_A_GRID_CHAR = 0;
 
+    // The grid keeps the codes in 16 bits like the dictionary does. The other codes, including
+    // the function keys, can't be part of a word and are stored as NOT_A_GRID_CHAR.
+    static uint16_t toGridChar(const uint32_t code) {
+        return code <= 0xFFFF ? static_cast<uint16_t>(code) : NOT_A_GRID_CHAR;
+    }
     int getStartIndexFromCoordinates(const int x, const int y) const;
     void initializeCodeToKeyIndex();
-    float calculateNormalizedSquaredDistance(const int keyIndex, const int inputIndex) const;
-    float calculateSquaredDistanceFromSweetSpotCenter(
-            const int keyIndex, const int inputIndex) const;
-    int getKeyIndex(const int c) const;
-    bool hasSweetSpotData(const int keyIndex) const {
-        // When there are no calibration data for a key,
-        // the radius of the key is assigned to zero.
-        return mSweetSpotRadii[keyIndex] > 0.0;
-    }
+    int getKeyIndexOfCode(const int code) const;
+    int getSquaredDistanceToKeyEdge(const int keyIndex, const int x, const int y) const;
+    int computeMostCommonKeyWidth() const;
 
     const int MAX_PROXIMITY_CHARS_SIZE;
     const int KEYBOARD_WIDTH;
@@ -95,23 +117,24 @@ private:
     const int CELL_HEIGHT;
     const int KEY_COUNT;
     const bool HAS_TOUCH_POSITION_CORRECTION_DATA;
-    const int *mInputCodes;
-    const int *mInputXCoordinates;
-    const int *mInputYCoordinates;
-    bool mTouchPositionCorrectionEnabled;
-    uint32_t *mProximityCharsArray;
-    int *mNormalizedSquaredDistances;
-    int32_t mKeyXCoordinates[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    int32_t mKeyYCoordinates[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    int32_t mKeyWidths[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    int32_t mKeyHeights[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    int32_t mKeyCharCodes[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    float mSweetSpotCenterXs[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    float mSweetSpotCenterYs[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    float mSweetSpotRadii[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    int mInputLength;
-    unsigned short mPrimaryInputWord[MAX_WORD_LENGTH_INTERNAL];
-    int mCodeToKeyIndex[MAX_CHAR_CODE + 1];
+    int mMostCommonKeyWidth;
+    // MAX_PROXIMITY_CHARS_SIZE chars for each cell of the grid.
+    uint16_t *mProximityChars;
+    // The key arrays have KEY_COUNT entries.
+    int32_t *mKeyXCoordinates;
+    int32_t *mKeyYCoordinates;
+    int32_t *mKeyWidths;
+    int32_t *mKeyHeights;
+    int32_t *mKeyCharCodes;
+    float *mSweetSpotCenterXs;
+    float *mSweetSpotCenterYs;
+    float *mSweetSpotRadii;
+    // An open addressing hash from the char code of each key to its index in the key arrays,
+    // with at least twice as many slots as keys so that the probes stay short. Empty slots
+    // have the code 0.
+    int mCodeToKeyIndexMask;
+    int32_t *mCodeToKeyIndexCodes;
+    int *mCodeToKeyIndex;
 };
 
 } // namespace latinime
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#define LOG_TAG "LatinIME: proximity_info_cache.cpp"
+
+#include "defines.h"
+#include "hash_utils.h"
+#include "proximity_info.h"
+#include "proximity_info_cache.h"
+
+namespace latinime {
+
+ProximityInfoCache::Entry *ProximityInfoCache::sEntries = 0;
+
+// The keyboards are built on the UI thread, but released by the finalizer.
+static pthread_mutex_t sCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// A missing array hashes as zeros, like ProximityInfo fills it.
+static uint32_t hashInts(uint32_t hash, const int32_t *values, const int length) {
+    for (int i = 0; i < length; ++i) {
+        hash = hashFnvStep(hash, values ? values[i] : 0);
+    }
+    return hash;
+}
+
+static uint32_t hashFloats(uint32_t hash, const float *values, const int length) {
+    for (int i = 0; i < length; ++i) {
+        uint32_t bits = 0;
+        if (values) memcpy(&bits, &values[i], sizeof(bits));
+        hash = hashFnvStep(hash, bits);
+    }
+    return hash;
+}
+
+uint32_t ProximityInfoCache::hashLayout(const int maxProximityCharsSize,
+        const int keyboardWidth, const int keyboardHeight, const int gridWidth,
+        const int gridHeight, const int keyCount, const int32_t *keyXCoordinates,
+        const int32_t *keyYCoordinates, const int32_t *keyWidths, const int32_t *keyHeights,
+        const int32_t *keyCharCodes, const float *sweetSpotCenterXs,
+        const float *sweetSpotCenterYs, const float *sweetSpotRadii) {
+    uint32_t hash = FNV_OFFSET_BASIS;
+    hash = hashFnvStep(hash, maxProximityCharsSize);
+    hash = hashFnvStep(hash, keyboardWidth);
+    hash = hashFnvStep(hash, keyboardHeight);
+    hash = hashFnvStep(hash, gridWidth);
+    hash = hashFnvStep(hash, gridHeight);
+    hash = hashFnvStep(hash, keyCount);
+    // The grid is not hashed: it is computed from the keys, and it is by far the largest part.
+    // ProximityInfo::hasSameLayout still compares it.
+    const int count = max(keyCount, 0);
+    hash = hashInts(hash, keyXCoordinates, count);
+    hash = hashInts(hash, keyYCoordinates, count);
+    hash = hashInts(hash, keyWidths, count);
+    hash = hashInts(hash, keyHeights, count);
+    hash = hashInts(hash, keyCharCodes, count);
+    hash = hashFloats(hash, sweetSpotCenterXs, count);
+    hash = hashFloats(hash, sweetSpotCenterYs, count);
+    hash = hashFloats(hash, sweetSpotRadii, count);
+    return hash;
+}
+
+ProximityInfo *ProximityInfoCache::acquire(const int maxProximityCharsSize,
+        const int keyboardWidth, const int keyboardHeight, const int gridWidth,
+        const int gridHeight, const uint32_t *proximityCharsArray, const int keyCount,
+        const int32_t *keyXCoordinates, const int32_t *keyYCoordinates, const int32_t *keyWidths,
+        const int32_t *keyHeights, const int32_t *keyCharCodes, const float *sweetSpotCenterXs,
+        const float *sweetSpotCenterYs, const float *sweetSpotRadii) {
+    const uint32_t layoutHash = hashLayout(maxProximityCharsSize, keyboardWidth, keyboardHeight,
+            gridWidth, gridHeight, keyCount, keyXCoordinates, keyYCoordinates, keyWidths,
+            keyHeights, keyCharCodes, sweetSpotCenterXs, sweetSpotCenterYs, sweetSpotRadii);
+    pthread_mutex_lock(&sCacheMutex);
+    for (Entry *entry = sEntries; entry; entry = entry->mNext) {
+        if (entry->mLayoutHash == layoutHash && entry->mProximityInfo->hasSameLayout(
+                maxProximityCharsSize, keyboardWidth, keyboardHeight, gridWidth, gridHeight,
+                proximityCharsArray, keyCount, keyXCoordinates, keyYCoordinates, keyWidths,
+                keyHeights, keyCharCodes, sweetSpotCenterXs, sweetSpotCenterYs,
+                sweetSpotRadii)) {
+            ++entry->mRefCount;
+            pthread_mutex_unlock(&sCacheMutex);
+            if (DEBUG_PROXIMITY_INFO) {
+                LOGI("Reuse proximity info %08x", layoutHash);
+            }
+            return entry->mProximityInfo;
+        }
+    }
+    // Building takes a while, but it is rare enough that the lock can be held meanwhile; that
+    // also keeps two threads from building the same layout.
+    Entry *entry = new Entry;
+    entry->mLayoutHash = layoutHash;
+    entry->mRefCount = 1;
+    entry->mProximityInfo = new ProximityInfo(maxProximityCharsSize, keyboardWidth,
+            keyboardHeight, gridWidth, gridHeight, proximityCharsArray, keyCount,
+            keyXCoordinates, keyYCoordinates, keyWidths, keyHeights, keyCharCodes,
+            sweetSpotCenterXs, sweetSpotCenterYs, sweetSpotRadii);
+    entry->mNext = sEntries;
+    sEntries = entry;
+    pthread_mutex_unlock(&sCacheMutex);
+    return entry->mProximityInfo;
+}
+
+void ProximityInfoCache::release(ProximityInfo *proximityInfo) {
+    if (!proximityInfo) return;
+    pthread_mutex_lock(&sCacheMutex);
+    for (Entry **link = &sEntries; *link; link = &(*link)->mNext) {
+        Entry *entry = *link;
+        if (entry->mProximityInfo != proximityInfo) continue;
+        if (--entry->mRefCount <= 0) {
+            *link = entry->mNext;
+            delete entry->mProximityInfo;
+            delete entry;
+        }
+        pthread_mutex_unlock(&sCacheMutex);
+        return;
+    }
+    pthread_mutex_unlock(&sCacheMutex);
+    LOGE("Released a proximity info that is not in the cache");
+}
+
+} // namespace latinime
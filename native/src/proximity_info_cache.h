@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_PROXIMITY_INFO_CACHE_H
+#define LATINIME_PROXIMITY_INFO_CACHE_H
+
+#include <stdint.h>
+
+namespace latinime {
+
+class ProximityInfo;
+
+// Keeps one ProximityInfo for each distinct keyboard layout. Each switch of keyboard (shift,
+// symbols, language) builds a new one on the Java side, mostly with a layout that was already
+// seen; acquire() then returns the instance that exists instead of copying the grid and the
+// keys again. The instances are reference counted, and deleted when the last user releases
+// them. ProximityInfo is immutable, so the users can share it freely.
+class ProximityInfoCache {
+public:
+    static ProximityInfo *acquire(const int maxProximityCharsSize, const int keyboardWidth,
+            const int keyboardHeight, const int gridWidth, const int gridHeight,
+            const uint32_t *proximityCharsArray, const int keyCount, const int32_t *keyXCoordinates,
+            const int32_t *keyYCoordinates, const int32_t *keyWidths, const int32_t *keyHeights,
+            const int32_t *keyCharCodes, const float *sweetSpotCenterXs,
+            const float *sweetSpotCenterYs, const float *sweetSpotRadii);
+    static void release(ProximityInfo *proximityInfo);
+
+private:
+    ProximityInfoCache();
+
+    struct Entry {
+        uint32_t mLayoutHash;
+        int mRefCount;
+        ProximityInfo *mProximityInfo;
+        Entry *mNext;
+    };
+
+    static uint32_t hashLayout(const int maxProximityCharsSize, const int keyboardWidth,
+            const int keyboardHeight, const int gridWidth, const int gridHeight,
+            const int keyCount, const int32_t *keyXCoordinates, const int32_t *keyYCoordinates,
+            const int32_t *keyWidths, const int32_t *keyHeights, const int32_t *keyCharCodes,
+            const float *sweetSpotCenterXs, const float *sweetSpotCenterYs,
+            const float *sweetSpotRadii);
+
+    // There are only a few layouts alive at a time, so a list is enough.
+    static Entry *sEntries;
+};
+
+} // namespace latinime
+
+#endif // LATINIME_PROXIMITY_INFO_CACHE_H
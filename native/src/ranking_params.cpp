@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "LatinIME: ranking_params.cpp"
+
+#include "ranking_params.h"
+
+namespace latinime {
+
+// The bounds of the parameters, which keep the scores from overflowing or going negative: a
+// demotion rate or a rate base is at most 100 percent, and a promotion rate at most 10 times.
+// The cost of 32 bits is more than the whole range of the scores. The missing character
+// demotion rate is proportional to (10 * inputLength - startPos10x)
+// / (10 * inputLength - startPos10x + 10): startPos10x below 20 keeps the divisor positive, and
+// as a char can only be skipped from an input of 2 chars or more, the rate too. The search depth
+// is the input length times the multiplier, capped at MAX_WORD_LENGTH.
+static const int MAX_PROMOTION_RATE = 1000;
+static const int MAX_LOG_COST = 32 * LOG_COST_ONE_BIT;
+
+static const struct IntParam {
+    const char *mName;
+    int RankingParams::*mField;
+    int mMin;
+    int mMax;
+} INT_PARAMS[] = {
+    { "WORDS_WITH_MISSING_CHARACTER_DEMOTION_RATE",
+            &RankingParams::mWordsWithMissingCharacterDemotionRate, 0, 100 },
+    { "WORDS_WITH_MISSING_CHARACTER_DEMOTION_START_POS_10X",
+            &RankingParams::mWordsWithMissingCharacterDemotionStartPos10x, 0, 19 },
+    { "WORDS_WITH_MISSING_SPACE_CHARACTER_DEMOTION_RATE",
+            &RankingParams::mWordsWithMissingSpaceCharacterDemotionRate, 0, 100 },
+    { "WORDS_WITH_EXCESSIVE_CHARACTER_DEMOTION_RATE",
+            &RankingParams::mWordsWithExcessiveCharacterDemotionRate, 0, 100 },
+    { "WORDS_WITH_EXCESSIVE_CHARACTER_OUT_OF_PROXIMITY_DEMOTION_RATE",
+            &RankingParams::mWordsWithExcessiveCharacterOutOfProximityDemotionRate, 0, 100 },
+    { "WORDS_WITH_TRANSPOSED_CHARACTERS_DEMOTION_RATE",
+            &RankingParams::mWordsWithTransposedCharactersDemotionRate, 0, 100 },
+    { "FULL_MATCHED_WORDS_PROMOTION_RATE",
+            &RankingParams::mFullMatchedWordsPromotionRate, 0, MAX_PROMOTION_RATE },
+    { "WORDS_WITH_PROXIMITY_CHARACTER_DEMOTION_RATE",
+            &RankingParams::mWordsWithProximityCharacterDemotionRate, 0, 100 },
+    { "WORDS_WITH_MATCH_SKIP_PROMOTION_RATE",
+            &RankingParams::mWordsWithMatchSkipPromotionRate, 0, MAX_PROMOTION_RATE },
+    { "WORDS_WITH_JUST_ONE_CORRECTION_PROMOTION_RATE",
+            &RankingParams::mWordsWithJustOneCorrectionPromotionRate, 0, MAX_PROMOTION_RATE },
+    { "CORRECTION_COUNT_RATE_DEMOTION_RATE_BASE",
+            &RankingParams::mCorrectionCountRateDemotionRateBase, 0, 100 },
+    { "INPUT_EXCEEDS_OUTPUT_DEMOTION_RATE",
+            &RankingParams::mInputExceedsOutputDemotionRate, 0, 100 },
+    { "FIRST_CHAR_DIFFERENT_DEMOTION_RATE",
+            &RankingParams::mFirstCharDifferentDemotionRate, 0, 100 },
+    { "TWO_WORDS_CAPITALIZED_DEMOTION_RATE",
+            &RankingParams::mTwoWordsCapitalizedDemotionRate, 0, 100 },
+    { "ZERO_DISTANCE_PROMOTION_RATE",
+            &RankingParams::mZeroDistancePromotionRate, 1, MAX_PROMOTION_RATE },
+    { "LOG_COST_NOT_EXACT_MATCH", &RankingParams::mLogCostNotExactMatch, 0, MAX_LOG_COST },
+    { "LOG_COST_INCOMPLETE_WORD", &RankingParams::mLogCostIncompleteWord, 0, MAX_LOG_COST },
+    { "LOG_COST_MISSING_CHARACTER", &RankingParams::mLogCostMissingCharacter, 0, MAX_LOG_COST },
+    { "LOG_COST_EXCESSIVE_CHARACTER", &RankingParams::mLogCostExcessiveCharacter, 0, MAX_LOG_COST },
+    { "LOG_COST_EXCESSIVE_CHARACTER_OUT_OF_PROXIMITY",
+            &RankingParams::mLogCostExcessiveCharacterOutOfProximity, 0, MAX_LOG_COST },
+    { "LOG_COST_TRANSPOSED_CHARACTERS",
+            &RankingParams::mLogCostTransposedCharacters, 0, MAX_LOG_COST },
+    { "LOG_COST_PROXIMITY_CHARACTER", &RankingParams::mLogCostProximityCharacter, 0, MAX_LOG_COST },
+    { "LOG_COST_INPUT_EXCEEDS_OUTPUT",
+            &RankingParams::mLogCostInputExceedsOutput, 0, MAX_LOG_COST },
+    { "LOG_COST_FIRST_CHAR_DIFFERENT",
+            &RankingParams::mLogCostFirstCharDifferent, 0, MAX_LOG_COST },
+    { "MAX_DEPTH_MULTIPLIER", &RankingParams::mMaxDepthMultiplier, 1, MAX_WORD_LENGTH_INTERNAL },
+    { "TIERED_CORRECTION_SCORE_MARGIN", &RankingParams::mTieredCorrectionScoreMargin, 0, 100 },
+};
+
+static const struct FloatParam {
+    const char *mName;
+    float RankingParams::*mField;
+} FLOAT_PARAMS[] = {
+    { "NEUTRAL_SCORE_SQUARED_RADIUS", &RankingParams::mNeutralScoreSquaredRadius },
+    { "HALF_SCORE_SQUARED_RADIUS", &RankingParams::mHalfScoreSquaredRadius },
+    { "TOUCH_SQUARED_SIGMA", &RankingParams::mTouchSquaredSigma },
+};
+
+static const char *const SEPARATORS = " \t\r\n,;";
+
+// Applies one NAME=VALUE entry of length length. Returns false if it can't be parsed or its
+// value is out of the bounds of the parameter.
+static bool parseEntry(const char *entry, const int length, RankingParams *params) {
+    const char *equal = static_cast<const char*>(memchr(entry, '=', length));
+    if (!equal || equal == entry) {
+        return false;
+    }
+    const int nameLength = equal - entry;
+    const char *const value = equal + 1;
+    const char *const end = entry + length;
+    char *parsedEnd;
+    for (size_t i = 0; i < sizeof(INT_PARAMS) / sizeof(INT_PARAMS[0]); ++i) {
+        const char *const name = INT_PARAMS[i].mName;
+        if (static_cast<int>(strlen(name)) == nameLength && !strncmp(name, entry, nameLength)) {
+            const long parsed = strtol(value, &parsedEnd, 10);
+            if (parsedEnd != end || value == end || parsed < INT_PARAMS[i].mMin
+                    || parsed > INT_PARAMS[i].mMax) {
+                return false;
+            }
+            params->*(INT_PARAMS[i].mField) = static_cast<int>(parsed);
+            return true;
+        }
+    }
+    for (size_t i = 0; i < sizeof(FLOAT_PARAMS) / sizeof(FLOAT_PARAMS[0]); ++i) {
+        const char *const name = FLOAT_PARAMS[i].mName;
+        if (static_cast<int>(strlen(name)) == nameLength && !strncmp(name, entry, nameLength)) {
+            const double parsed = strtod(value, &parsedEnd);
+            if (parsedEnd != end || value == end || parsed < 0) {
+                return false;
+            }
+            params->*(FLOAT_PARAMS[i].mField) = static_cast<float>(parsed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseRankingParams(const char *block, RankingParams *params) {
+    RankingParams parsedParams = *params;
+    const char *entry = block + strspn(block, SEPARATORS);
+    while (*entry) {
+        const int length = strcspn(entry, SEPARATORS);
+        if (!parseEntry(entry, length, &parsedParams)) {
+            LOGE("Invalid ranking parameter: %.*s", length, entry);
+            return false;
+        }
+        entry += length;
+        entry += strspn(entry, SEPARATORS);
+    }
+    // The touch position factor is a piecewise linear function between the two radii.
+    if (parsedParams.mHalfScoreSquaredRadius <= parsedParams.mNeutralScoreSquaredRadius) {
+        LOGE("Invalid ranking parameters: the half score radius must exceed the neutral one");
+        return false;
+    }
+    *params = parsedParams;
+    return true;
+}
+
+} // namespace latinime
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_RANKING_PARAMS_H
+#define LATINIME_RANKING_PARAMS_H
+
+#include "defines.h"
+
+namespace latinime {
+
+// The ranking constants that can be changed at run time. Each of them defaults to the define of
+// the same name in defines.h, which is also its name in a parameter block.
+struct RankingParams {
+    int mWordsWithMissingCharacterDemotionRate;
+    int mWordsWithMissingCharacterDemotionStartPos10x;
+    int mWordsWithMissingSpaceCharacterDemotionRate;
+    int mWordsWithExcessiveCharacterDemotionRate;
+    int mWordsWithExcessiveCharacterOutOfProximityDemotionRate;
+    int mWordsWithTransposedCharactersDemotionRate;
+    int mFullMatchedWordsPromotionRate;
+    int mWordsWithProximityCharacterDemotionRate;
+    int mWordsWithMatchSkipPromotionRate;
+    int mWordsWithJustOneCorrectionPromotionRate;
+    int mCorrectionCountRateDemotionRateBase;
+    int mInputExceedsOutputDemotionRate;
+    int mFirstCharDifferentDemotionRate;
+    int mTwoWordsCapitalizedDemotionRate;
+    int mZeroDistancePromotionRate;
+    float mNeutralScoreSquaredRadius;
+    float mHalfScoreSquaredRadius;
+
+    int mLogCostNotExactMatch;
+    int mLogCostIncompleteWord;
+    int mLogCostMissingCharacter;
+    int mLogCostExcessiveCharacter;
+    int mLogCostExcessiveCharacterOutOfProximity;
+    int mLogCostTransposedCharacters;
+    int mLogCostProximityCharacter;
+    int mLogCostInputExceedsOutput;
+    int mLogCostFirstCharDifferent;
+    float mTouchSquaredSigma;
+
+    int mMaxDepthMultiplier;
+    int mTieredCorrectionScoreMargin;
+};
+
+inline static void initRankingParams(RankingParams *params) {
+    params->mWordsWithMissingCharacterDemotionRate = WORDS_WITH_MISSING_CHARACTER_DEMOTION_RATE;
+    params->mWordsWithMissingCharacterDemotionStartPos10x =
+            WORDS_WITH_MISSING_CHARACTER_DEMOTION_START_POS_10X;
+    params->mWordsWithMissingSpaceCharacterDemotionRate =
+            WORDS_WITH_MISSING_SPACE_CHARACTER_DEMOTION_RATE;
+    params->mWordsWithExcessiveCharacterDemotionRate =
+            WORDS_WITH_EXCESSIVE_CHARACTER_DEMOTION_RATE;
+    params->mWordsWithExcessiveCharacterOutOfProximityDemotionRate =
+            WORDS_WITH_EXCESSIVE_CHARACTER_OUT_OF_PROXIMITY_DEMOTION_RATE;
+    params->mWordsWithTransposedCharactersDemotionRate =
+            WORDS_WITH_TRANSPOSED_CHARACTERS_DEMOTION_RATE;
+    params->mFullMatchedWordsPromotionRate = FULL_MATCHED_WORDS_PROMOTION_RATE;
+    params->mWordsWithProximityCharacterDemotionRate =
+            WORDS_WITH_PROXIMITY_CHARACTER_DEMOTION_RATE;
+    params->mWordsWithMatchSkipPromotionRate = WORDS_WITH_MATCH_SKIP_PROMOTION_RATE;
+    params->mWordsWithJustOneCorrectionPromotionRate =
+            WORDS_WITH_JUST_ONE_CORRECTION_PROMOTION_RATE;
+    params->mCorrectionCountRateDemotionRateBase = CORRECTION_COUNT_RATE_DEMOTION_RATE_BASE;
+    params->mInputExceedsOutputDemotionRate = INPUT_EXCEEDS_OUTPUT_DEMOTION_RATE;
+    params->mFirstCharDifferentDemotionRate = FIRST_CHAR_DIFFERENT_DEMOTION_RATE;
+    params->mTwoWordsCapitalizedDemotionRate = TWO_WORDS_CAPITALIZED_DEMOTION_RATE;
+    params->mZeroDistancePromotionRate = ZERO_DISTANCE_PROMOTION_RATE;
+    params->mNeutralScoreSquaredRadius = NEUTRAL_SCORE_SQUARED_RADIUS;
+    params->mHalfScoreSquaredRadius = HALF_SCORE_SQUARED_RADIUS;
+
+    params->mLogCostNotExactMatch = LOG_COST_NOT_EXACT_MATCH;
+    params->mLogCostIncompleteWord = LOG_COST_INCOMPLETE_WORD;
+    params->mLogCostMissingCharacter = LOG_COST_MISSING_CHARACTER;
+    params->mLogCostExcessiveCharacter = LOG_COST_EXCESSIVE_CHARACTER;
+    params->mLogCostExcessiveCharacterOutOfProximity =
+            LOG_COST_EXCESSIVE_CHARACTER_OUT_OF_PROXIMITY;
+    params->mLogCostTransposedCharacters = LOG_COST_TRANSPOSED_CHARACTERS;
+    params->mLogCostProximityCharacter = LOG_COST_PROXIMITY_CHARACTER;
+    params->mLogCostInputExceedsOutput = LOG_COST_INPUT_EXCEEDS_OUTPUT;
+    params->mLogCostFirstCharDifferent = LOG_COST_FIRST_CHAR_DIFFERENT;
+    params->mTouchSquaredSigma = TOUCH_SQUARED_SIGMA;
+
+    params->mMaxDepthMultiplier = MAX_DEPTH_MULTIPLIER;
+    params->mTieredCorrectionScoreMargin = TIERED_CORRECTION_SCORE_MARGIN;
+}
+
+// Applies a parameter block to params. The block is a list of NAME=VALUE entries separated by
+// white spaces, commas or semicolons, where NAME is the name of the define. If an entry can't be
+// parsed or is out of bounds, this returns false and leaves params unchanged.
+bool parseRankingParams(const char *block, RankingParams *params);
+
+} // namespace latinime
+
+#endif // LATINIME_RANKING_PARAMS_H
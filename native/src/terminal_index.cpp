@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#define LOG_TAG "LatinIME: terminal_index.cpp"
+
+#include "binary_format.h"
+#include "defines.h"
+#include "terminal_index.h"
+
+namespace latinime {
+
+TerminalIndex::TerminalIndex(const uint8_t *const root, const int32_t *const alphabet,
+        const int maxWordLength, const bool hasTrigrams)
+        : mRoot(root), mAlphabet(alphabet),
+          MAX_WORD_LENGTH(min(maxWordLength, MAX_WORD_LENGTH_INTERNAL)),
+          mWordCount(0), mAddresses(NULL), mSpellingOffsets(NULL), mSpellings(NULL),
+          mFrequencies(NULL), mBuckets(NULL), mBucketCount(0), mBucketShift(0) {
+    bool hasBigrams = false;
+    const int totalLength = visitTerminals(false, &hasBigrams);
+    // Without bigrams or trigrams nobody looks words up by address, so don't spend the memory.
+    if ((!hasBigrams && !hasTrigrams) || mWordCount <= 0) {
+        mWordCount = 0;
+        return;
+    }
+    mAddresses = new int[mWordCount];
+    mSpellingOffsets = new int[mWordCount + 1];
+    mSpellings = new uint16_t[totalLength];
+    mFrequencies = new uint8_t[mWordCount];
+    visitTerminals(true, &hasBigrams);
+    sortByAddress(totalLength);
+
+    const int maxAddress = mAddresses[mWordCount - 1];
+    while ((maxAddress >> mBucketShift) >= mWordCount) {
+        ++mBucketShift;
+    }
+    mBucketCount = (maxAddress >> mBucketShift) + 1;
+    mBuckets = new int[mBucketCount + 1];
+    int wordId = 0;
+    for (int bucket = 0; bucket <= mBucketCount; ++bucket) {
+        while (wordId < mWordCount && (mAddresses[wordId] >> mBucketShift) < bucket) {
+            ++wordId;
+        }
+        mBuckets[bucket] = wordId;
+    }
+    if (DEBUG_DICT) {
+        LOGI("TerminalIndex: %d words, %d chars, %d buckets", mWordCount, totalLength,
+                mBucketCount);
+    }
+}
+
+TerminalIndex::~TerminalIndex() {
+    delete[] mAddresses;
+    delete[] mSpellingOffsets;
+    delete[] mSpellings;
+    delete[] mFrequencies;
+    delete[] mBuckets;
+}
+
+int TerminalIndex::getWordAtAddress(const int address, const int maxLength,
+        uint16_t *outWord) const {
+    if (mWordCount <= 0) {
+        return BinaryFormat::getWordAtAddress(mRoot, mAlphabet, address, maxLength, outWord);
+    }
+    const int wordId = getWordId(address);
+    if (NOT_A_WORD_ID == wordId) return 0;
+    return getWord(wordId, maxLength, outWord);
+}
+
+// Walks the whole trie depth first. When fill is false, this only counts the words into
+// mWordCount and returns the total length of their spellings; when it is true, it also writes
+// the addresses and the spellings in the order of the walk.
+int TerminalIndex::visitTerminals(const bool fill, bool *hasBigrams) {
+    int positions[MAX_WORD_LENGTH_INTERNAL];
+    int remainingGroupCounts[MAX_WORD_LENGTH_INTERNAL];
+    int wordLengths[MAX_WORD_LENGTH_INTERNAL];
+    uint16_t word[MAX_WORD_LENGTH_INTERNAL];
+    int wordCount = 0;
+    int totalLength = 0;
+
+    int pos = 0;
+    remainingGroupCounts[0] = BinaryFormat::getGroupCountAndForwardPointer(mRoot, &pos);
+    positions[0] = pos;
+    wordLengths[0] = 0;
+    int depth = 0;
+    while (depth >= 0) {
+        if (remainingGroupCounts[depth] <= 0) {
+            --depth;
+            continue;
+        }
+        --remainingGroupCounts[depth];
+        pos = positions[depth];
+        const int startPos = pos;
+        const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(mRoot, &pos);
+        int length = wordLengths[depth];
+        int32_t character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+        if (length < MAX_WORD_LENGTH) word[length++] = character;
+        if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags) {
+            character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+            while (NOT_A_CHARACTER != character) {
+                if (length < MAX_WORD_LENGTH) word[length++] = character;
+                character = BinaryFormat::getCharCodeAndForwardPointer(mRoot, mAlphabet, &pos);
+            }
+        }
+        if (UnigramDictionary::FLAG_IS_TERMINAL & flags) {
+            if (fill) {
+                mAddresses[wordCount] = startPos;
+                mFrequencies[wordCount] = BinaryFormat::readFrequencyWithoutMovingPointer(mRoot,
+                        pos);
+                mSpellingOffsets[wordCount] = totalLength;
+                for (int i = 0; i < length; ++i) {
+                    mSpellings[totalLength + i] = word[i];
+                }
+            }
+            ++wordCount;
+            totalLength += length;
+        }
+        if (UnigramDictionary::FLAG_HAS_BIGRAMS & flags) *hasBigrams = true;
+        pos = BinaryFormat::skipFrequency(flags, pos);
+        const int childrenPos = BinaryFormat::readChildrenPosition(mRoot, flags, pos);
+        positions[depth] = BinaryFormat::skipChildrenPosAndAttributes(mRoot, flags, pos);
+        if (childrenPos >= 0 && depth + 1 < MAX_WORD_LENGTH_INTERNAL) {
+            ++depth;
+            pos = childrenPos;
+            remainingGroupCounts[depth] = BinaryFormat::getGroupCountAndForwardPointer(mRoot,
+                    &pos);
+            positions[depth] = pos;
+            wordLengths[depth] = length;
+        }
+    }
+    if (fill) mSpellingOffsets[wordCount] = totalLength;
+    mWordCount = wordCount;
+    return totalLength;
+}
+
+struct AddressAndWordId {
+    int mAddress;
+    int mWordId;
+};
+
+static int compareAddresses(const void *left, const void *right) {
+    return static_cast<const AddressAndWordId*>(left)->mAddress
+            - static_cast<const AddressAndWordId*>(right)->mAddress;
+}
+
+// The walk is in the order of the characters, which is not necessarily the order of the
+// addresses. Reorder the words so that the word ids follow the addresses.
+void TerminalIndex::sortByAddress(const int totalLength) {
+    AddressAndWordId *order = new AddressAndWordId[mWordCount];
+    for (int i = 0; i < mWordCount; ++i) {
+        order[i].mAddress = mAddresses[i];
+        order[i].mWordId = i;
+    }
+    qsort(order, mWordCount, sizeof(order[0]), compareAddresses);
+    int *const spellingOffsets = new int[mWordCount + 1];
+    uint16_t *const spellings = new uint16_t[totalLength];
+    uint8_t *const frequencies = new uint8_t[mWordCount];
+    int offset = 0;
+    for (int i = 0; i < mWordCount; ++i) {
+        const int wordId = order[i].mWordId;
+        mAddresses[i] = order[i].mAddress;
+        frequencies[i] = mFrequencies[wordId];
+        spellingOffsets[i] = offset;
+        for (int j = mSpellingOffsets[wordId]; j < mSpellingOffsets[wordId + 1]; ++j) {
+            spellings[offset++] = mSpellings[j];
+        }
+    }
+    spellingOffsets[mWordCount] = offset;
+    delete[] order;
+    delete[] mSpellingOffsets;
+    delete[] mSpellings;
+    delete[] mFrequencies;
+    mSpellingOffsets = spellingOffsets;
+    mSpellings = spellings;
+    mFrequencies = frequencies;
+}
+
+} // namespace latinime
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_TERMINAL_INDEX_H
+#define LATINIME_TERMINAL_INDEX_H
+
+#include <stdint.h>
+
+namespace latinime {
+
+// Maps the position of the last char group of each word in the dictionary (what a bigram
+// stores as its target address) to a word id, and keeps the spelling of all the words in one
+// buffer along with their frequencies. This replaces the walk from the root that
+// BinaryFormat::getWordAtAddress has to do for each bigram.
+// The word ids are also the keys of the trigram section.
+// The index is only built for dictionaries that have bigrams or trigrams; otherwise it is empty
+// and getWordAtAddress falls back to BinaryFormat::getWordAtAddress.
+class TerminalIndex {
+public:
+    static const int NOT_A_WORD_ID = -1;
+
+    TerminalIndex(const uint8_t *const root, const int32_t *const alphabet,
+            const int maxWordLength, const bool hasTrigrams);
+    ~TerminalIndex();
+    int getWordId(const int address) const;
+    int getWord(const int wordId, const int maxLength, uint16_t *outWord) const;
+    int getWordLength(const int wordId) const {
+        return mSpellingOffsets[wordId + 1] - mSpellingOffsets[wordId];
+    }
+    uint16_t getFirstChar(const int wordId) const {
+        return mSpellings[mSpellingOffsets[wordId]];
+    }
+    int getFrequency(const int wordId) const { return mFrequencies[wordId]; }
+    bool isWord(const int wordId, const uint16_t *word, const int length) const;
+    // The spellings are cut at this length.
+    int getMaxWordLength() const { return MAX_WORD_LENGTH; }
+    int getWordAtAddress(const int address, const int maxLength, uint16_t *outWord) const;
+    int getWordCount() const { return mWordCount; }
+
+private:
+    int visitTerminals(const bool fill, bool *hasBigrams);
+    void sortByAddress(const int totalLength);
+
+    const uint8_t *const mRoot;
+    const int32_t *const mAlphabet;
+    const int MAX_WORD_LENGTH;
+    int mWordCount;
+    // The terminal addresses in ascending order. The index of an address is its word id.
+    int *mAddresses;
+    // The spelling of the word id i starts at mSpellingOffsets[i] in mSpellings, and ends at
+    // mSpellingOffsets[i + 1].
+    int *mSpellingOffsets;
+    uint16_t *mSpellings;
+    uint8_t *mFrequencies;
+    // The word ids of the addresses from (i << mBucketShift) on start at mBuckets[i]. There is
+    // about one word per bucket, so that a look up scans one or two addresses.
+    int *mBuckets;
+    int mBucketCount;
+    int mBucketShift;
+};
+
+inline int TerminalIndex::getWordId(const int address) const {
+    if (address < 0) return NOT_A_WORD_ID;
+    const int bucket = address >> mBucketShift;
+    if (bucket >= mBucketCount) return NOT_A_WORD_ID;
+    const int end = mBuckets[bucket + 1];
+    for (int wordId = mBuckets[bucket]; wordId < end; ++wordId) {
+        if (mAddresses[wordId] == address) return wordId;
+    }
+    return NOT_A_WORD_ID;
+}
+
+inline bool TerminalIndex::isWord(const int wordId, const uint16_t *word,
+        const int length) const {
+    const int start = mSpellingOffsets[wordId];
+    if (mSpellingOffsets[wordId + 1] - start != length) return false;
+    for (int i = 0; i < length; ++i) {
+        if (mSpellings[start + i] != word[i]) return false;
+    }
+    return true;
+}
+
+inline int TerminalIndex::getWord(const int wordId, const int maxLength,
+        uint16_t *outWord) const {
+    const int start = mSpellingOffsets[wordId];
+    int length = mSpellingOffsets[wordId + 1] - start;
+    if (length > maxLength) length = maxLength;
+    for (int i = 0; i < length; ++i) {
+        outWord[i] = mSpellings[start + i];
+    }
+    return length;
+}
+
+} // namespace latinime
+
+#endif // LATINIME_TERMINAL_INDEX_H
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: trigram_dictionary.cpp"
+
+#include "binary_format.h"
+#include "defines.h"
+#include "terminal_index.h"
+#include "trigram_dictionary.h"
+
+namespace latinime {
+
+static inline int readUInt24(const uint8_t *const p) {
+    return (p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+static inline int readInt32(const uint8_t *const p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+bool TrigramDictionary::hasTrigramSection(const uint8_t *const dict, const int dictSize) {
+    return dictSize >= NEW_DICTIONARY_HEADER_SIZE + 4
+            && 0 != (BinaryFormat::getOptions(dict) & BinaryFormat::OPTION_HAS_TRIGRAMS)
+            && dictSize >= BinaryFormat::getHeaderSize(dict) + 4;
+}
+
+TrigramDictionary::TrigramDictionary(const uint8_t *const dict, const int32_t *const alphabet,
+        const int dictSize, const TerminalIndex *const terminalIndex, const int maxAlternatives)
+        : DICT_ROOT(dict + BinaryFormat::getHeaderSize(dict)), ALPHABET(alphabet),
+          mTerminalIndex(terminalIndex),
+          MAX_ALTERNATIVES(maxAlternatives), mContextCount(0),
+          mBucketMask(0), mBucketsPos(0), mContextsPos(0), mTargetCount(0), mTargetsPos(0) {
+    if (!hasTrigramSection(dict, dictSize) || terminalIndex->getWordCount() <= 0) return;
+    // Everything has to fit between the section position and the position itself at the end.
+    const int end = dictSize - BinaryFormat::getHeaderSize(dict) - 4;
+    const int pos = readInt32(DICT_ROOT + end);
+    if (pos < 0 || pos > end - 8) {
+        LOGE("Bad trigram section position %d", pos);
+        return;
+    }
+    const int contextCount = readInt32(DICT_ROOT + pos);
+    const int bucketCount = readInt32(DICT_ROOT + pos + 4);
+    const int bucketsPos = pos + 8;
+    if (contextCount <= 0 || bucketCount <= 0 || 0 != (bucketCount & (bucketCount - 1))
+            || bucketCount > (end - bucketsPos) / 4 - 1) {
+        LOGE("Bad trigram section: %d contexts, %d buckets", contextCount, bucketCount);
+        return;
+    }
+    const int contextsPos = bucketsPos + (bucketCount + 1) * 4;
+    if (contextCount > (end - contextsPos - 4) / CONTEXT_SIZE) {
+        LOGE("Bad trigram section: %d contexts", contextCount);
+        return;
+    }
+    const int targetCountPos = contextsPos + contextCount * CONTEXT_SIZE;
+    const int targetCount = readInt32(DICT_ROOT + targetCountPos);
+    const int targetsPos = targetCountPos + 4;
+    if (targetCount < 0 || targetCount > (end - targetsPos) / TARGET_SIZE) {
+        LOGE("Bad trigram section: %d targets", targetCount);
+        return;
+    }
+    mContextCount = contextCount;
+    mBucketMask = bucketCount - 1;
+    mBucketsPos = bucketsPos;
+    mContextsPos = contextsPos;
+    mTargetCount = targetCount;
+    mTargetsPos = targetsPos;
+    if (DEBUG_DICT) {
+        LOGI("Trigrams: %d contexts, %d buckets, %d targets", contextCount, bucketCount,
+                targetCount);
+    }
+}
+
+int TrigramDictionary::findTargets(const int firstWordId, const int secondWordId,
+        int *outTargetPos) const {
+    if (mContextCount <= 0) return 0;
+    const int bucket = hashWordIds(firstWordId, secondWordId) & mBucketMask;
+    const uint8_t *const bucketPtr = DICT_ROOT + mBucketsPos + bucket * 4;
+    const int begin = readInt32(bucketPtr);
+    const int end = min(readInt32(bucketPtr + 4), mContextCount);
+    for (int i = max(begin, 0); i < end; ++i) {
+        const uint8_t *const context = DICT_ROOT + mContextsPos + i * CONTEXT_SIZE;
+        if (readUInt24(context) != firstWordId || readUInt24(context + 3) != secondWordId) {
+            continue;
+        }
+        const int firstTarget = readInt32(context + 6);
+        // The targets of a context end where the ones of the next context start.
+        const int endTarget = i + 1 < mContextCount
+                ? readInt32(context + CONTEXT_SIZE + 6) : mTargetCount;
+        if (firstTarget < 0 || endTarget > mTargetCount || firstTarget >= endTarget) return 0;
+        *outTargetPos = mTargetsPos + firstTarget * TARGET_SIZE;
+        return endTarget - firstTarget;
+    }
+    return 0;
+}
+
+int TrigramDictionary::getWordId(const unsigned short *word, const int length) const {
+    const int pos = BinaryFormat::getTerminalPosition(DICT_ROOT, ALPHABET, word, length);
+    if (NOT_VALID_WORD == pos) return TerminalIndex::NOT_A_WORD_ID;
+    return mTerminalIndex->getWordId(pos);
+}
+
+bool TrigramDictionary::checkFirstCharacter(const int *codes, const uint16_t c) const {
+    for (int i = 0; i < MAX_ALTERNATIVES && codes[i] > 0; ++i) {
+        if (static_cast<unsigned int>(codes[i]) == c) return true;
+    }
+    return false;
+}
+
+int TrigramDictionary::getTrigrams(const unsigned short *prevPrevWord,
+        const int prevPrevWordLength, const unsigned short *prevWord, const int prevWordLength,
+        const int *codes, const int codesSize, unsigned short *outWords, int *frequencies,
+        const int maxWordLength, const int maxTrigrams) const {
+    if (mContextCount <= 0) return 0;
+    const int firstWordId = getWordId(prevPrevWord, prevPrevWordLength);
+    if (TerminalIndex::NOT_A_WORD_ID == firstWordId) return 0;
+    const int secondWordId = getWordId(prevWord, prevWordLength);
+    if (TerminalIndex::NOT_A_WORD_ID == secondWordId) return 0;
+    int targetPos = 0;
+    const int targetCount = findTargets(firstWordId, secondWordId, &targetPos);
+
+    const int wordIdCount = mTerminalIndex->getWordCount();
+    int count = 0;
+    for (int i = 0; i < targetCount && count < maxTrigrams; ++i) {
+        const uint8_t *const target = DICT_ROOT + targetPos + i * TARGET_SIZE;
+        const int frequency = target[0];
+        // Sorted by frequency: the rest can't be output either.
+        if (frequency <= 0) break;
+        const int wordId = readUInt24(target + 1);
+        if (wordId >= wordIdCount) continue;
+        if (codesSize > 0 && !checkFirstCharacter(codes, mTerminalIndex->getFirstChar(wordId))) {
+            continue;
+        }
+        unsigned short *const dest = outWords + count * maxWordLength;
+        const int length = mTerminalIndex->getWord(wordId, maxWordLength - 1, dest);
+        dest[length] = 0;
+        frequencies[count] = frequency;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace latinime
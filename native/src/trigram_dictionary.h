@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_TRIGRAM_DICTIONARY_H
+#define LATINIME_TRIGRAM_DICTIONARY_H
+
+#include <stdint.h>
+
+#include "hash_utils.h"
+
+namespace latinime {
+
+class TerminalIndex;
+
+// Looks up the words that follow a pair of words in the trigram section of the dictionary.
+// The section is keyed by the word ids of TerminalIndex, and hashed, so that a look up is one
+// probe in a flat table instead of a walk in the trie.
+//
+// When the header has BinaryFormat::OPTION_HAS_TRIGRAMS, the last 4 bytes of the dictionary
+// are the position of the section from the root. All numbers are big endian.
+//   context count               4 bytes
+//   bucket count                4 bytes, a power of 2
+//   buckets                     (bucket count + 1) * 4 bytes: the index of the first context
+//                               of each bucket; the last one is the context count
+//   contexts                    context count * 10 bytes, sorted by bucket:
+//     first word id             3 bytes
+//     second word id            3 bytes
+//     index of first target     4 bytes
+//   target count                4 bytes
+//   targets                     target count * 4 bytes, by context, each in order of
+//                               decreasing frequency:
+//     frequency                 1 byte, quantized to 0-15 like the bigram frequencies
+//     word id                   3 bytes
+// The bucket of a pair of word ids is hashWordIds(first, second) & (bucket count - 1).
+class TrigramDictionary {
+public:
+    TrigramDictionary(const uint8_t *const dict, const int32_t *const alphabet,
+            const int dictSize, const TerminalIndex *const terminalIndex,
+            const int maxAlternatives);
+    static bool hasTrigramSection(const uint8_t *const dict, const int dictSize);
+
+    // Outputs the words that follow prevPrevWord and prevWord, and start with one of the
+    // alternatives of the first input code if codesSize > 0, in order of decreasing frequency.
+    // Returns the number of words output.
+    int getTrigrams(const unsigned short *prevPrevWord, const int prevPrevWordLength,
+            const unsigned short *prevWord, const int prevWordLength, const int *codes,
+            const int codesSize, unsigned short *outWords, int *frequencies,
+            const int maxWordLength, const int maxTrigrams) const;
+
+    // Finds the trigrams of a pair of word ids. Returns their number, and sets *outTargetPos
+    // to the position of the first target.
+    int findTargets(const int firstWordId, const int secondWordId, int *outTargetPos) const;
+
+    // This must be the same as BinaryDictInputOutput.hashWordIds in makedict.
+    static uint32_t hashWordIds(const uint32_t firstWordId, const uint32_t secondWordId) {
+        return mixHashBits(firstWordId * GOLDEN_RATIO_MULTIPLIER ^ secondWordId, 15);
+    }
+
+private:
+    static const int CONTEXT_SIZE = 10;
+    static const int TARGET_SIZE = 4;
+
+    int getWordId(const unsigned short *word, const int length) const;
+    bool checkFirstCharacter(const int *codes, const uint16_t c) const;
+
+    const uint8_t *const DICT_ROOT;
+    const int32_t *const ALPHABET;
+    const TerminalIndex *const mTerminalIndex;
+    const int MAX_ALTERNATIVES;
+    int mContextCount;
+    int mBucketMask;
+    int mBucketsPos;
+    int mContextsPos;
+    int mTargetCount;
+    int mTargetsPos;
+};
+
+} // namespace latinime
+
+#endif // LATINIME_TRIGRAM_DICTIONARY_H
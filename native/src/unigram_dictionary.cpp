@@ -16,6 +16,7 @@
 */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define LOG_TAG "LatinIME: unigram_dictionary.cpp"
@@ -34,21 +35,38 @@ const UnigramDictionary::digraph_t UnigramDictionary::GERMAN_UMLAUT_DIGRAPHS[] =
         { 'u', 'e' } };
 
 // TODO: check the header
-UnigramDictionary::UnigramDictionary(const uint8_t* const streamStart, int typedLetterMultiplier,
-        int fullWordMultiplier, int maxWordLength, int maxWords, int maxProximityChars,
-        const bool isLatestDictVersion)
-    : DICT_ROOT(streamStart + NEW_DICTIONARY_HEADER_SIZE),
+UnigramDictionary::UnigramDictionary(const uint8_t* const streamStart,
+        const int32_t* const alphabet, const BaseLowerCaseTable* const baseLowerCase,
+        int typedLetterMultiplier, int fullWordMultiplier, int maxWordLength, int maxWords,
+        int maxProximityChars, const bool isLatestDictVersion)
+    : DICT_ROOT(streamStart + BinaryFormat::getHeaderSize(streamStart)), ALPHABET(alphabet),
+    BASE_LOWER_CASE(baseLowerCase),
     MAX_WORD_LENGTH(maxWordLength), MAX_WORDS(maxWords),
     MAX_PROXIMITY_CHARS(maxProximityChars), IS_LATEST_DICT_VERSION(isLatestDictVersion),
     TYPED_LETTER_MULTIPLIER(typedLetterMultiplier), FULL_WORD_MULTIPLIER(fullWordMultiplier),
       // TODO : remove this variable.
     ROOT_POS(0),
     BYTES_IN_ONE_CHAR(MAX_PROXIMITY_CHARS * sizeof(int)),
-    MAX_UMLAUT_SEARCH_DEPTH(DEFAULT_MAX_UMLAUT_SEARCH_DEPTH) {
+    MAX_UMLAUT_SEARCH_DEPTH(DEFAULT_MAX_UMLAUT_SEARCH_DEPTH),
+    mLastCorrectionTier(TIER_SPLIT_WORDS), mUseTwoStageRanking(false), mUseLogScoring(false),
+    mPruningFreq(0), mPruningLogCost(S_INT_MAX), mCandidateCount(0) {
     if (DEBUG_DICT) {
         LOGI("UnigramDictionary - constructor");
     }
-    mCorrection = new Correction(typedLetterMultiplier, fullWordMultiplier);
+    memset(mCorrectionTierCounts, 0, sizeof(mCorrectionTierCounts));
+    initRankingParams(&mRankingParams);
+    mCorrection = new Correction(typedLetterMultiplier, fullWordMultiplier, &mRankingParams);
+}
+
+// Resets the ranking constants to their defaults, then applies the given parameter block. If the
+// block is not valid, the constants are left as they were. The queries read mRankingParams, so
+// the callers must not run them meanwhile: BinaryDictionary synchronizes both.
+bool UnigramDictionary::setRankingParams(const char *block) {
+    RankingParams rankingParams;
+    initRankingParams(&rankingParams);
+    if (block && !parseRankingParams(block, &rankingParams)) return false;
+    mRankingParams = rankingParams;
+    return true;
 }
 
 UnigramDictionary::~UnigramDictionary() {
@@ -137,9 +155,11 @@ void UnigramDictionary::getWordWithDigraphSuggestionsRec(ProximityInfo *proximit
 }
 
 int UnigramDictionary::getSuggestions(ProximityInfo *proximityInfo, const int *xcoordinates,
-        const int *ycoordinates, const int *codes, const int codesSize, const int flags,
+        const int *ycoordinates, const int *codes, const int codesSize,
+        const unsigned short *prevWord, const int prevWordLength, const int flags,
         unsigned short *outWords, int *frequencies) {
 
+    initBigramTargets(prevWord, prevWordLength);
     if (REQUIRES_GERMAN_UMLAUT_PROCESSING & flags)
     { // Incrementally tune the word and try all possibilities
         int codesBuffer[getCodesBufferSize(codes, codesSize, MAX_PROXIMITY_CHARS)];
@@ -180,19 +200,43 @@ void UnigramDictionary::getWordSuggestions(ProximityInfo *proximityInfo,
 
     PROF_OPEN;
     PROF_START(0);
-    initSuggestions(
-            proximityInfo, xcoordinates, ycoordinates, codes, codesSize, outWords, frequencies);
+    // The per-query state lives here rather than in the shared ProximityInfo.
+    const InputContext inputContext(proximityInfo, BASE_LOWER_CASE, &mRankingParams, codes,
+            codesSize, xcoordinates, ycoordinates);
+    initSuggestions(&inputContext, outWords, frequencies);
     if (DEBUG_DICT) assert(codesSize == mInputLength);
 
-    const int maxDepth = min(mInputLength * MAX_DEPTH_MULTIPLIER, MAX_WORD_LENGTH);
-    mCorrection->initCorrection(mProximityInfo, mInputLength, maxDepth);
+    const int maxDepth = min(mInputLength * mRankingParams.mMaxDepthMultiplier, MAX_WORD_LENGTH);
+    mCorrection->initCorrection(mInputContext, mInputLength, maxDepth);
     PROF_END(0);
 
     const bool useFullEditDistance = USE_FULL_EDIT_DISTANCE & flags;
-    // TODO: remove
+    mUseLogScoring = USE_LOG_SCORING & flags;
+    // The log-domain scoring does not need a cheaper first stage
+    mUseTwoStageRanking = (USE_TWO_STAGE_RANKING & flags) && !mUseLogScoring;
+    mPruningFreq = 0;
+    mPruningLogCost = S_INT_MAX;
+    // The umlaut processing accumulates the suggestions of several inputs, so we can't drop the
+    // results of a tier there.
+    const bool useTieredCorrection = (USE_TIERED_CORRECTION & flags)
+            && !(REQUIRES_GERMAN_UMLAUT_PROCESSING & flags);
     PROF_START(1);
-    getSuggestionCandidates(useFullEditDistance);
+    if (useTieredCorrection) {
+        getSuggestionCandidates(useFullEditDistance, false /* withEditCorrections */);
+        if (hasConfidentSuggestions()) {
+            PROF_END(1);
+            endCorrectionTier(TIER_PROXIMITY_ONLY);
+            return;
+        }
+        // The next pass finds these words again, possibly along with corrected versions of them.
+        memset(mFrequencies, 0, MAX_WORDS * sizeof(mFrequencies[0]));
+    }
+    getSuggestionCandidates(useFullEditDistance, true /* withEditCorrections */);
     PROF_END(1);
+    if (useTieredCorrection && hasConfidentSuggestions()) {
+        endCorrectionTier(TIER_EDIT_CORRECTIONS);
+        return;
+    }
 
     PROF_START(2);
     // Note: This line is intentionally left blank
@@ -214,7 +258,7 @@ void UnigramDictionary::getWordSuggestions(ProximityInfo *proximityInfo,
             if (DEBUG_DICT) {
                 LOGI("--- Suggest missing space characters %d", i);
             }
-            getMissingSpaceWords(mInputLength, i, mCorrection, useFullEditDistance);
+            getMissingSpaceWords(mInputLength, i, mCorrection);
         }
     }
     PROF_END(5);
@@ -233,24 +277,69 @@ void UnigramDictionary::getWordSuggestions(ProximityInfo *proximityInfo,
                         i, x, y, proximityInfo->hasSpaceProximity(x, y));
             }
             if (proximityInfo->hasSpaceProximity(x, y)) {
-                getMistypedSpaceWords(mInputLength, i, mCorrection, useFullEditDistance);
+                getMistypedSpaceWords(mInputLength, i, mCorrection);
             }
         }
     }
     PROF_END(6);
+    endCorrectionTier(TIER_SPLIT_WORDS);
+}
+
+// Returns whether the suggestions found so far are good enough to stop the tiered correction.
+bool UnigramDictionary::hasConfidentSuggestions() const {
+    const int confidentCount = min(TIERED_CORRECTION_CONFIDENT_SUGGESTION_COUNT, MAX_WORDS);
+    // The score of an exact match of the whole input for the most frequent word
+    int perfectScore = MAX_FREQ * FULL_WORD_MULTIPLIER;
+    for (int i = 0; i < mInputLength && perfectScore < S_INT_MAX / TYPED_LETTER_MULTIPLIER; ++i) {
+        perfectScore *= TYPED_LETTER_MULTIPLIER;
+    }
+    const int threshold = perfectScore / 100 * mRankingParams.mTieredCorrectionScoreMargin;
+    return mFrequencies[confidentCount - 1] >= max(1, threshold);
 }
 
-void UnigramDictionary::initSuggestions(ProximityInfo *proximityInfo, const int *xCoordinates,
-        const int *yCoordinates, const int *codes, const int codesSize,
+void UnigramDictionary::endCorrectionTier(const CorrectionTier tier) {
+    if (DEBUG_DICT) {
+        LOGI("Correction ended at tier %d", tier);
+    }
+    mLastCorrectionTier = tier;
+    ++mCorrectionTierCounts[tier];
+}
+
+// Resolves the bigrams of the previous word to the positions of their targets once, so that
+// the traversal boosts these words when it reaches them.
+void UnigramDictionary::initBigramTargets(const unsigned short *prevWord,
+        const int prevWordLength) {
+    mBigramTargets.clear();
+    if (!prevWord || prevWordLength <= 0) return;
+    int pos = BinaryFormat::getTerminalPosition(DICT_ROOT, ALPHABET, prevWord, prevWordLength);
+    if (NOT_VALID_WORD == pos) return;
+    const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(DICT_ROOT, &pos);
+    if (0 == (flags & FLAG_HAS_BIGRAMS)) return;
+    if (0 == (flags & FLAG_HAS_MULTIPLE_CHARS)) {
+        BinaryFormat::getCharCodeAndForwardPointer(DICT_ROOT, ALPHABET, &pos);
+    } else {
+        pos = BinaryFormat::skipOtherCharacters(DICT_ROOT, pos);
+    }
+    pos = BinaryFormat::skipChildrenPosition(flags, pos);
+    pos = BinaryFormat::skipFrequency(flags, pos);
+    uint8_t bigramFlags;
+    do {
+        bigramFlags = BinaryFormat::getFlagsAndForwardPointer(DICT_ROOT, &pos);
+        const int bigramPos = BinaryFormat::getAttributeAddressAndForwardPointer(DICT_ROOT,
+                bigramFlags, &pos);
+        if (!mBigramTargets.put(bigramPos, MASK_ATTRIBUTE_FREQUENCY & bigramFlags)) break;
+    } while (0 != (FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags));
+}
+
+void UnigramDictionary::initSuggestions(const InputContext *inputContext,
         unsigned short *outWords, int *frequencies) {
     if (DEBUG_DICT) {
         LOGI("initSuggest");
     }
     mFrequencies = frequencies;
     mOutputChars = outWords;
-    mInputLength = codesSize;
-    proximityInfo->setInputParams(codes, codesSize, xCoordinates, yCoordinates);
-    mProximityInfo = proximityInfo;
+    mInputLength = inputContext->getInputLength();
+    mInputContext = inputContext;
 }
 
 static inline void registerNextLetter(unsigned short c, int *nextLetters, int nextLettersSize) {
@@ -317,14 +406,38 @@ bool UnigramDictionary::addWord(unsigned short *word, int length, int frequency)
 static const char QUOTE = '\'';
 static const char SPACE = ' ';
 
-void UnigramDictionary::getSuggestionCandidates(const bool useFullEditDistance) {
+// Resolves the per-query options once, and runs the traversal instantiated for them.
+void UnigramDictionary::getSuggestionCandidates(const bool useFullEditDistance,
+        const bool withEditCorrections) {
+    const bool touchPositionCorrection = mInputContext->touchPositionCorrectionEnabled();
+    if (useFullEditDistance) {
+        if (touchPositionCorrection) {
+            getSuggestionCandidates<TraversalPolicy<true, true> >(withEditCorrections);
+        } else {
+            getSuggestionCandidates<TraversalPolicy<true, false> >(withEditCorrections);
+        }
+    } else {
+        if (touchPositionCorrection) {
+            getSuggestionCandidates<TraversalPolicy<false, true> >(withEditCorrections);
+        } else {
+            getSuggestionCandidates<TraversalPolicy<false, false> >(withEditCorrections);
+        }
+    }
+}
+
+template <typename Policy>
+void UnigramDictionary::getSuggestionCandidates(const bool withEditCorrections) {
+    // Without edit corrections, only exact and proximity matches are found.
+    const int editCorrectionPos = withEditCorrections ? 0 : -1;
     // TODO: Remove setCorrectionParams
-    mCorrection->setCorrectionParams(0, 0, 0,
-            -1 /* spaceProximityPos */, -1 /* missingSpacePos */, useFullEditDistance);
+    mCorrection->setCorrectionParams(editCorrectionPos /* skipPos */,
+            editCorrectionPos /* excessivePos */, editCorrectionPos /* transposedPos */,
+            -1 /* spaceProximityPos */, -1 /* missingSpacePos */);
     int rootPosition = ROOT_POS;
     // Get the number of children of root, then increment the position
     int childCount = Dictionary::getCount(DICT_ROOT, &rootPosition);
     int outputIndex = 0;
+    mCandidateCount = 0;
 
     mCorrection->initCorrectionState(rootPosition, childCount, (mInputLength <= 0));
 
@@ -334,7 +447,7 @@ void UnigramDictionary::getSuggestionCandidates(const bool useFullEditDistance)
             int siblingPos = mCorrection->getTreeSiblingPos(outputIndex);
             int firstChildPos;
 
-            const bool needsToTraverseChildrenNodes = processCurrentNode(siblingPos,
+            const bool needsToTraverseChildrenNodes = processCurrentNode<Policy>(siblingPos,
                     mCorrection, &childCount, &firstChildPos, &siblingPos);
             // Update next sibling pos
             mCorrection->setTreeSiblingPos(outputIndex, siblingPos);
@@ -348,40 +461,131 @@ void UnigramDictionary::getSuggestionCandidates(const bool useFullEditDistance)
             outputIndex = mCorrection->getTreeParentIndex(outputIndex);
         }
     }
+
+    if (Policy::TOUCH_POSITION_CORRECTION && mUseTwoStageRanking) {
+        rerankCandidates<Policy>();
+    }
 }
 
 void UnigramDictionary::getMissingSpaceWords(
-        const int inputLength, const int missingSpacePos, Correction *correction,
-        const bool useFullEditDistance) {
+        const int inputLength, const int missingSpacePos, Correction *correction) {
     correction->setCorrectionParams(-1 /* skipPos */, -1 /* excessivePos */,
-            -1 /* transposedPos */, -1 /* spaceProximityPos */, missingSpacePos,
-            useFullEditDistance);
+            -1 /* transposedPos */, -1 /* spaceProximityPos */, missingSpacePos);
     getSplitTwoWordsSuggestion(inputLength, correction);
 }
 
 void UnigramDictionary::getMistypedSpaceWords(
-        const int inputLength, const int spaceProximityPos, Correction *correction,
-        const bool useFullEditDistance) {
+        const int inputLength, const int spaceProximityPos, Correction *correction) {
     correction->setCorrectionParams(-1 /* skipPos */, -1 /* excessivePos */,
-            -1 /* transposedPos */, spaceProximityPos, -1 /* missingSpacePos */,
-            useFullEditDistance);
+            -1 /* transposedPos */, spaceProximityPos, -1 /* missingSpacePos */);
     getSplitTwoWordsSuggestion(inputLength, correction);
 }
 
 inline bool UnigramDictionary::needsToSkipCurrentNode(const unsigned short c,
         const int inputIndex, const int skipPos, const int depth) {
-    const unsigned short userTypedChar = mProximityInfo->getPrimaryCharAt(inputIndex);
+    const unsigned short userTypedChar = mInputContext->getPrimaryCharAt(inputIndex);
     // Skip the ' or other letter and continue deeper
     return (c == QUOTE && userTypedChar != QUOTE) || skipPos == depth;
 }
 
-inline void UnigramDictionary::onTerminal(const int freq, Correction *correction) {
+// The same boost as Suggest.addWord applies to the unigrams found in the bigram list.
+static inline int applyBigramMultiplier(const int freq, const int bigramFreq) {
+    if (BigramTargetMap::NOT_A_BIGRAM == bigramFreq) {
+        return freq;
+    }
+    const float multiplier = BIGRAM_MULTIPLIER_MIN + (BIGRAM_MULTIPLIER_MAX
+            - BIGRAM_MULTIPLIER_MIN) * bigramFreq / MAXIMUM_BIGRAM_FREQUENCY;
+    const float boostedFreq = freq * multiplier + 0.5f;
+    return boostedFreq >= S_INT_MAX ? S_INT_MAX : static_cast<int>(boostedFreq);
+}
+
+template <typename Policy>
+inline void UnigramDictionary::onTerminal(const int freq, const int terminalPos,
+        Correction *correction) {
     int wordLength;
     unsigned short* wordPointer;
-    const int finalFreq = correction->getFinalFreq(freq, &wordPointer, &wordLength);
+    const int bigramFreq = mBigramTargets.getBigramFreq(terminalPos);
+    if (mUseLogScoring) {
+        const int cost = correction->getFinalLogCost<Policy>(freq, &wordPointer, &wordLength);
+        if (cost >= 0) {
+            addWord(wordPointer, wordLength,
+                    applyBigramMultiplier(correction->logCostToFreq(cost), bigramFreq));
+        }
+        return;
+    }
+    if (Policy::TOUCH_POSITION_CORRECTION && mUseTwoStageRanking) {
+        // Retrieval stage: keep the best candidates by a score without the touch model, which
+        // is applied to them only in rerankCandidates().
+        const int score = correction->getFinalFreq<typename Policy::RetrievalPolicy>(
+                freq, &wordPointer, &wordLength);
+        if (score >= 0) {
+            addCandidate(applyBigramMultiplier(score, bigramFreq), freq, bigramFreq, correction);
+        }
+        return;
+    }
+    const int finalFreq = correction->getFinalFreq<Policy>(freq, &wordPointer, &wordLength);
     if (finalFreq >= 0) {
-        addWord(wordPointer, wordLength, finalFreq);
+        addWord(wordPointer, wordLength, applyBigramMultiplier(finalFreq, bigramFreq));
+    }
+}
+
+// Branch and bound for the log-domain scoring: the cost only grows along a path, so once the
+// results are full, no word under a node whose lower bound is beyond the cost of the last
+// result can make it into them.
+inline bool UnigramDictionary::needsToPruneByLogCost(const Correction *correction) {
+    const int lastFreq = mFrequencies[MAX_WORDS - 1];
+    if (lastFreq <= 0) {
+        return false;
     }
+    if (lastFreq != mPruningFreq) {
+        mPruningFreq = lastFreq;
+        // A bigram target may still make it with a score lower by up to the largest multiplier
+        const int unboostedFreq = mBigramTargets.isEmpty()
+                ? lastFreq : max(1, static_cast<int>(lastFreq / BIGRAM_MULTIPLIER_MAX));
+        mPruningLogCost = correction->freqToLogCost(unboostedFreq);
+    }
+    // freqToLogCost rounds down, so leave one unit for the rounding of logCostToFreq
+    return correction->getLogCostLowerBound() > mPruningLogCost + 1;
+}
+
+void UnigramDictionary::addCandidate(const int score, const int freq, const int bigramFreq,
+        const Correction *correction) {
+    int insertAt = 0;
+    while (insertAt < mCandidateCount && mCandidateScores[insertAt] >= score) {
+        ++insertAt;
+    }
+    if (insertAt >= TWO_STAGE_RANKING_CANDIDATE_COUNT) {
+        return;
+    }
+    // Reuse the slot of the last candidate if it is pushed out
+    const int slot = mCandidateCount < TWO_STAGE_RANKING_CANDIDATE_COUNT
+            ? mCandidateCount++ : mCandidateSlots[TWO_STAGE_RANKING_CANDIDATE_COUNT - 1];
+    const int moveCount = mCandidateCount - 1 - insertAt;
+    memmove(mCandidateScores + insertAt + 1, mCandidateScores + insertAt,
+            moveCount * sizeof(mCandidateScores[0]));
+    memmove(mCandidateSlots + insertAt + 1, mCandidateSlots + insertAt,
+            moveCount * sizeof(mCandidateSlots[0]));
+    mCandidateScores[insertAt] = score;
+    mCandidateSlots[insertAt] = slot;
+    correction->saveTerminalState(freq, &mCandidates[slot]);
+    mCandidateBigramFreqs[slot] = bigramFreq;
+}
+
+// Second stage of the two-stage ranking: scores the retrieved candidates with the full model.
+template <typename Policy>
+void UnigramDictionary::rerankCandidates() {
+    for (int i = 0; i < mCandidateCount; ++i) {
+        const int slot = mCandidateSlots[i];
+        int wordLength;
+        unsigned short* wordPointer;
+        const int finalFreq = mCorrection->getFinalFreq<Policy>(
+                &mCandidates[slot], &wordPointer, &wordLength);
+        if (finalFreq >= 0) {
+            addWord(wordPointer, wordLength,
+                    applyBigramMultiplier(finalFreq, mCandidateBigramFreqs[slot]));
+        }
+    }
+    mCandidateCount = 0;
 }
 
 void UnigramDictionary::getSplitTwoWordsSuggestion(
@@ -443,17 +647,13 @@ void UnigramDictionary::getSplitTwoWordsSuggestion(
 // interface.
 inline int UnigramDictionary::getMostFrequentWordLike(const int startInputIndex,
         const int inputLength, unsigned short *word) {
-    uint16_t inWord[inputLength];
-
-    for (int i = 0; i < inputLength; ++i) {
-        inWord[i] = (uint16_t)mProximityInfo->getPrimaryCharAt(startInputIndex + i);
-    }
-    return getMostFrequentWordLikeInner(inWord, inputLength, word);
+    return getMostFrequentWordLikeInner(
+            mInputContext->getBaseLowerPrimaryInputWord() + startInputIndex, inputLength, word);
 }
 
 // This function will take the position of a character array within a CharGroup,
 // and check it actually like-matches the word in inWord starting at startInputIndex,
-// that is, it matches it with case and accents squashed.
+// that is, it matches it with case and accents squashed. inWord is in base lower case already.
 // The function returns true if there was a full match, false otherwise.
 // The function will copy on-the-fly the characters in the CharGroup to outNewWord.
 // It will also place the end position of the array in outPos; in outInputIndex,
@@ -464,16 +664,15 @@ inline int UnigramDictionary::getMostFrequentWordLike(const int startInputIndex,
 // In and out parameters may point to the same location. This function takes care
 // not to use any input parameters after it wrote into its outputs.
 static inline bool testCharGroupForContinuedLikeness(const uint8_t flags,
-        const uint8_t* const root, const int startPos,
+        const uint8_t* const root, const int32_t* const alphabet,
+        const BaseLowerCaseTable* const baseLowerCase, const int startPos,
         const uint16_t* const inWord, const int startInputIndex,
         int32_t* outNewWord, int* outInputIndex, int* outPos) {
     const bool hasMultipleChars = (0 != (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags));
     int pos = startPos;
-    int32_t character = BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
-    int32_t baseChar = Dictionary::toBaseLowerCase(character);
-    const uint16_t wChar = Dictionary::toBaseLowerCase(inWord[startInputIndex]);
-
-    if (baseChar != wChar) {
+    int32_t character = BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
+    int32_t baseChar = baseLowerCase->toBaseLowerCase(character);
+    if (baseChar != inWord[startInputIndex]) {
         *outPos = hasMultipleChars ? BinaryFormat::skipOtherCharacters(root, pos) : pos;
         *outInputIndex = startInputIndex;
         return false;
@@ -481,16 +680,16 @@ static inline bool testCharGroupForContinuedLikeness(const uint8_t flags,
     int inputIndex = startInputIndex;
     outNewWord[inputIndex] = character;
     if (hasMultipleChars) {
-        character = BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
+        character = BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
         while (NOT_A_CHARACTER != character) {
-            baseChar = Dictionary::toBaseLowerCase(character);
-            if (Dictionary::toBaseLowerCase(inWord[++inputIndex]) != baseChar) {
+            baseChar = baseLowerCase->toBaseLowerCase(character);
+            if (inWord[++inputIndex] != baseChar) {
                 *outPos = BinaryFormat::skipOtherCharacters(root, pos);
                 *outInputIndex = startInputIndex;
                 return false;
             }
             outNewWord[inputIndex] = character;
-            character = BinaryFormat::getCharCodeAndForwardPointer(root, &pos);
+            character = BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
         }
     }
     *outInputIndex = inputIndex + 1;
@@ -513,7 +712,7 @@ static inline void onTerminalWordLike(const int freq, int32_t* newWord, const in
 }
 
 // Will find the highest frequency of the words like the one passed as an argument,
-// that is, everything that only differs by case/accents.
+// that is, everything that only differs by case/accents. inWord is in base lower case.
 int UnigramDictionary::getMostFrequentWordLikeInner(const uint16_t * const inWord,
         const int length, short unsigned int* outWord) {
     int32_t newWord[MAX_WORD_LENGTH_INTERNAL];
@@ -534,8 +733,8 @@ int UnigramDictionary::getMostFrequentWordLikeInner(const uint16_t * const inWor
             // we want to traverse its children (or if the length match, evaluate its frequency).
             // Note that this function will output the position regardless, but will only write
             // into inputIndex if there is a match.
-            const bool isAlike = testCharGroupForContinuedLikeness(flags, root, pos, inWord,
-                    inputIndex, newWord, &inputIndex, &pos);
+            const bool isAlike = testCharGroupForContinuedLikeness(flags, root, ALPHABET,
+                    BASE_LOWER_CASE, pos, inWord, inputIndex, newWord, &inputIndex, &pos);
             if (isAlike && (FLAG_IS_TERMINAL & flags) && (inputIndex == length)) {
                 const int frequency = BinaryFormat::readFrequencyWithoutMovingPointer(root, pos);
                 onTerminalWordLike(frequency, newWord, inputIndex, outWord, &maxFreq);
@@ -572,7 +771,76 @@ int UnigramDictionary::getMostFrequentWordLikeInner(const uint16_t * const inWor
 }
 
 bool UnigramDictionary::isValidWord(const uint16_t* const inWord, const int length) const {
-    return NOT_VALID_WORD != BinaryFormat::getTerminalPosition(DICT_ROOT, inWord, length);
+    return NOT_VALID_WORD
+            != BinaryFormat::getTerminalPosition(DICT_ROOT, ALPHABET, inWord, length);
+}
+
+static inline int readTerminalFrequency(const uint8_t* const root,
+        const int32_t* const alphabet, int pos) {
+    if (NOT_VALID_WORD == pos) return NOT_A_FREQUENCY;
+    const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+    if (UnigramDictionary::FLAG_HAS_MULTIPLE_CHARS & flags) {
+        pos = BinaryFormat::skipOtherCharacters(root, pos);
+    } else {
+        BinaryFormat::getCharCodeAndForwardPointer(root, alphabet, &pos);
+    }
+    return BinaryFormat::readFrequencyWithoutMovingPointer(root, pos);
+}
+
+int UnigramDictionary::getFrequency(const uint16_t* const inWord, const int length) const {
+    return readTerminalFrequency(DICT_ROOT, ALPHABET,
+            BinaryFormat::getTerminalPosition(DICT_ROOT, ALPHABET, inWord, length));
+}
+
+struct BatchWord {
+    const uint16_t *mChars;
+    int mLength;
+    int mIndex;
+};
+
+static int compareBatchWords(const void *left, const void *right) {
+    const BatchWord *const l = static_cast<const BatchWord*>(left);
+    const BatchWord *const r = static_cast<const BatchWord*>(right);
+    const int length = min(l->mLength, r->mLength);
+    for (int i = 0; i < length; ++i) {
+        if (l->mChars[i] != r->mChars[i]) return l->mChars[i] - r->mChars[i];
+    }
+    return l->mLength - r->mLength;
+}
+
+void UnigramDictionary::getFrequencies(const uint16_t* const chars, const int* const offsets,
+        const int* const wordIndices, const int wordCount, int* outFrequencies) const {
+    BatchWord *const words = new BatchWord[wordCount];
+    for (int i = 0; i < wordCount; ++i) {
+        const int index = wordIndices[i];
+        words[i].mChars = chars + offsets[index];
+        words[i].mLength = offsets[index + 1] - offsets[index];
+        words[i].mIndex = index;
+    }
+    qsort(words, wordCount, sizeof(words[0]), compareBatchWords);
+
+    BinaryFormat::TriePath path;
+    const BatchWord *previous = NULL;
+    for (int i = 0; i < wordCount; ++i) {
+        const BatchWord *const word = words + i;
+        if (word->mLength <= 0) {
+            outFrequencies[word->mIndex] = NOT_A_FREQUENCY;
+            continue;
+        }
+        int prefixLength = 0;
+        if (previous) {
+            const int length = min(previous->mLength, word->mLength);
+            while (prefixLength < length
+                    && previous->mChars[prefixLength] == word->mChars[prefixLength]) {
+                ++prefixLength;
+            }
+        }
+        outFrequencies[word->mIndex] = readTerminalFrequency(DICT_ROOT, ALPHABET,
+                BinaryFormat::getTerminalPosition(DICT_ROOT, ALPHABET, word->mChars,
+                        word->mLength, prefixLength, &path));
+        previous = word;
+    }
+    delete[] words;
 }
 
 // TODO: remove this function.
@@ -595,6 +863,7 @@ int UnigramDictionary::getBigramPosition(int pos, unsigned short *word, int offs
 // there aren't any more nodes at this level, it merely returns the address of the first byte after
 // the current node in nextSiblingPosition. Thus, the caller must keep count of the nodes at any
 // given level, as output into newCount when traversing this level's parent.
+template <typename Policy>
 inline bool UnigramDictionary::processCurrentNode(const int initialPos,
         Correction *correction, int *newCount,
         int *newChildrenPosition, int *nextSiblingPosition) {
@@ -622,7 +891,7 @@ inline bool UnigramDictionary::processCurrentNode(const int initialPos,
     // else if FLAG_IS_TERMINAL: the frequency
     // else if MASK_GROUP_ADDRESS_TYPE is not NONE: the children address
     // Note that you can't have a node that both is not a terminal and has no children.
-    int32_t c = BinaryFormat::getCharCodeAndForwardPointer(DICT_ROOT, &pos);
+    int32_t c = BinaryFormat::getCharCodeAndForwardPointer(DICT_ROOT, ALPHABET, &pos);
     assert(NOT_A_CHARACTER != c);
 
     // We are going to loop through each character and make it look like it's a different
@@ -637,13 +906,14 @@ inline bool UnigramDictionary::processCurrentNode(const int initialPos,
         // NOT_A_CHARACTER in the next char. From this we can decide whether this virtual node
         // should behave as a terminal or not and whether we have children.
         const int32_t nextc = hasMultipleChars
-                ? BinaryFormat::getCharCodeAndForwardPointer(DICT_ROOT, &pos) : NOT_A_CHARACTER;
+                ? BinaryFormat::getCharCodeAndForwardPointer(DICT_ROOT, ALPHABET, &pos)
+                : NOT_A_CHARACTER;
         const bool isLastChar = (NOT_A_CHARACTER == nextc);
         // If there are more chars in this nodes, then this virtual node is not a terminal.
         // If we are on the last char, this virtual node is a terminal if this node is.
         const bool isTerminal = isLastChar && isTerminalNode;
 
-        Correction::CorrectionType stateType = correction->processCharAndCalcState(
+        Correction::CorrectionType stateType = correction->processCharAndCalcState<Policy>(
                 c, isTerminal);
         if (stateType == Correction::TRAVERSE_ALL_ON_TERMINAL
                 || stateType == Correction::ON_TERMINAL) {
@@ -676,7 +946,7 @@ inline bool UnigramDictionary::processCurrentNode(const int initialPos,
             // The frequency should be here, because we come here only if this is actually
             // a terminal node, and we are on its last char.
             const int freq = BinaryFormat::readFrequencyWithoutMovingPointer(DICT_ROOT, pos);
-            onTerminal(freq, mCorrection);
+            onTerminal<Policy>(freq, initialPos, mCorrection);
         }
 
         // If there are more chars in this node, then this virtual node has children.
@@ -708,6 +978,12 @@ inline bool UnigramDictionary::processCurrentNode(const int initialPos,
         }
     }
 
+    if (mUseLogScoring && needsToPruneByLogCost(correction)) {
+        pos = BinaryFormat::skipFrequency(flags, pos);
+        *nextSiblingPosition = BinaryFormat::skipChildrenPosAndAttributes(DICT_ROOT, flags, pos);
+        return false;
+    }
+
     // Now we finished processing this node, and we want to traverse children. If there are no
     // children, we can't come here.
     assert(BinaryFormat::hasChildrenInFlags(flags));
@@ -18,10 +18,14 @@
 #define LATINIME_UNIGRAM_DICTIONARY_H
 
 #include <stdint.h>
+#include "bigram_target_map.h"
+#include "char_utils.h"
 #include "correction.h"
 #include "correction_state.h"
 #include "defines.h"
+#include "input_context.h"
 #include "proximity_info.h"
+#include "ranking_params.h"
 
 #ifndef NULL
 #define NULL 0
@@ -64,14 +68,41 @@ public:
     static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_TWOBYTES = 0x20;
     static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_THREEBYTES = 0x30;
 
-    UnigramDictionary(const uint8_t* const streamStart, int typedLetterMultipler,
+    // Correction tiers of the tiered correction mode, in the order they are tried.
+    typedef enum {
+        TIER_PROXIMITY_ONLY,
+        TIER_EDIT_CORRECTIONS,
+        TIER_SPLIT_WORDS,
+        CORRECTION_TIER_COUNT
+    } CorrectionTier;
+
+    UnigramDictionary(const uint8_t* const streamStart, const int32_t* const alphabet,
+            const BaseLowerCaseTable* const baseLowerCase, int typedLetterMultipler,
             int fullWordMultiplier, int maxWordLength, int maxWords, int maxProximityChars,
             const bool isLatestDictVersion);
     bool isValidWord(const uint16_t* const inWord, const int length) const;
+    // Returns the frequency of the word, or NOT_A_FREQUENCY if it is not in the dictionary.
+    int getFrequency(const uint16_t* const inWord, const int length) const;
+    // Looks up the words wordIndices[0..wordCount) of a batch, where the word i is
+    // chars[offsets[i]..offsets[i + 1]), and writes the frequency of the word i, or
+    // NOT_A_FREQUENCY, to outFrequencies[i]. The words are looked up in lexicographic order so
+    // that each walk down the trie starts where the common prefix with the previous word ends.
+    void getFrequencies(const uint16_t* const chars, const int* const offsets,
+            const int* const wordIndices, const int wordCount, int* outFrequencies) const;
     int getBigramPosition(int pos, unsigned short *word, int offset, int length) const;
     int getSuggestions(ProximityInfo *proximityInfo, const int *xcoordinates,
-            const int *ycoordinates, const int *codes, const int codesSize, const int flags,
+            const int *ycoordinates, const int *codes, const int codesSize,
+            const unsigned short *prevWord, const int prevWordLength, const int flags,
             unsigned short *outWords, int *frequencies);
+    bool setRankingParams(const char *block);
+    // The tier that ended the last query.
+    CorrectionTier getLastCorrectionTier() const {
+        return mLastCorrectionTier;
+    }
+    // The number of queries that ended at the given tier so far.
+    int getCorrectionTierCount(const CorrectionTier tier) const {
+        return mCorrectionTierCounts[tier];
+    }
     virtual ~UnigramDictionary();
 
 private:
@@ -84,20 +115,31 @@ private:
         const int *xcoordinates, const int* ycoordinates, const int *codesBuffer,
         const int codesBufferSize, const int flags, const int* codesSrc, const int codesRemain,
         const int currentDepth, int* codesDest, unsigned short* outWords, int* frequencies);
-    void initSuggestions(ProximityInfo *proximityInfo, const int *xcoordinates,
-            const int *ycoordinates, const int *codes, const int codesSize,
-            unsigned short *outWords, int *frequencies);
-    void getSuggestionCandidates(const bool useFullEditDistance);
+    void initBigramTargets(const unsigned short *prevWord, const int prevWordLength);
+    void initSuggestions(const InputContext *inputContext, unsigned short *outWords,
+            int *frequencies);
+    void getSuggestionCandidates(const bool useFullEditDistance, const bool withEditCorrections);
+    template <typename Policy>
+    void getSuggestionCandidates(const bool withEditCorrections);
+    bool hasConfidentSuggestions() const;
+    void endCorrectionTier(const CorrectionTier tier);
     bool addWord(unsigned short *word, int length, int frequency);
     void getSplitTwoWordsSuggestion(const int inputLength, Correction *correction);
     void getMissingSpaceWords(const int inputLength, const int missingSpacePos,
-            Correction *correction, const bool useFullEditDistance);
+            Correction *correction);
     void getMistypedSpaceWords(const int inputLength, const int spaceProximityPos,
-            Correction *correction, const bool useFullEditDistance);
-    void onTerminal(const int freq, Correction *correction);
+            Correction *correction);
+    template <typename Policy>
+    void onTerminal(const int freq, const int terminalPos, Correction *correction);
+    void addCandidate(const int score, const int freq, const int bigramFreq,
+            const Correction *correction);
+    bool needsToPruneByLogCost(const Correction *correction);
+    template <typename Policy>
+    void rerankCandidates();
     bool needsToSkipCurrentNode(const unsigned short c,
             const int inputIndex, const int skipPos, const int depth);
     // Process a node by considering proximity, missing and excessive character
+    template <typename Policy>
     bool processCurrentNode(const int initialPos,
             Correction *correction, int *newCount,
             int *newChildPosition, int *nextSiblingPosition);
@@ -107,6 +149,8 @@ private:
             short unsigned int* outWord);
 
     const uint8_t* const DICT_ROOT;
+    const int32_t* const ALPHABET;
+    const BaseLowerCaseTable* const BASE_LOWER_CASE;
     const int MAX_WORD_LENGTH;
     const int MAX_WORDS;
     const int MAX_PROXIMITY_CHARS;
@@ -123,15 +167,36 @@ private:
     // Please update both at the same time.
     enum {
         REQUIRES_GERMAN_UMLAUT_PROCESSING = 0x1,
-        USE_FULL_EDIT_DISTANCE = 0x2
+        USE_FULL_EDIT_DISTANCE = 0x2,
+        USE_TIERED_CORRECTION = 0x4,
+        USE_TWO_STAGE_RANKING = 0x8,
+        USE_LOG_SCORING = 0x10
     };
     static const struct digraph_t { int first; int second; } GERMAN_UMLAUT_DIGRAPHS[];
 
     int *mFrequencies;
     unsigned short *mOutputChars;
-    ProximityInfo *mProximityInfo;
+    // Only valid during getWordSuggestions.
+    const InputContext *mInputContext;
     Correction *mCorrection;
     int mInputLength;
+    RankingParams mRankingParams;
+    CorrectionTier mLastCorrectionTier;
+    int mCorrectionTierCounts[CORRECTION_TIER_COUNT];
+    bool mUseTwoStageRanking;
+    bool mUseLogScoring;
+    // The log cost that matches the lowest score in the results, cached for the pruning
+    int mPruningFreq;
+    int mPruningLogCost;
+    // The candidates of the retrieval stage, sorted by their score. mCandidateSlots maps the
+    // rank to the index in mCandidates so that inserting a candidate does not move the states.
+    int mCandidateCount;
+    int mCandidateScores[TWO_STAGE_RANKING_CANDIDATE_COUNT];
+    int mCandidateSlots[TWO_STAGE_RANKING_CANDIDATE_COUNT];
+    Correction::TerminalState mCandidates[TWO_STAGE_RANKING_CANDIDATE_COUNT];
+    int mCandidateBigramFreqs[TWO_STAGE_RANKING_CANDIDATE_COUNT];
+    // The bigram targets of the previous word, if any
+    BigramTargetMap mBigramTargets;
     // MAX_WORD_LENGTH_INTERNAL must be bigger than MAX_WORD_LENGTH
     unsigned short mWord[MAX_WORD_LENGTH_INTERNAL];
 
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_TAG "LatinIME: word_index.cpp"
+
+#include "defines.h"
+#include "terminal_index.h"
+#include "word_index.h"
+
+namespace latinime {
+
+WordIndex::WordIndex(const TerminalIndex *const terminalIndex)
+        : mTerminalIndex(terminalIndex), MAX_LENGTH(terminalIndex->getMaxWordLength()),
+          mWordCount(0), mSeeds(NULL), mWordIds(NULL) {
+    if (terminalIndex->getWordCount() <= 0) return;
+    if (!build()) {
+        LOGE("WordIndex: no perfect hash for %d words", mWordCount);
+        delete[] mSeeds;
+        delete[] mWordIds;
+        mSeeds = NULL;
+        mWordIds = NULL;
+        mWordCount = 0;
+    }
+}
+
+WordIndex::~WordIndex() {
+    delete[] mSeeds;
+    delete[] mWordIds;
+}
+
+int WordIndex::getWordId(const uint16_t *word, const int length) const {
+    const uint32_t slotCount = mWordCount;
+    const int seed = mSeeds[hashWord(0, word, length) % slotCount];
+    const int slot = seed < 0 ? -1 - seed : hashWord(seed, word, length) % slotCount;
+    const int wordId = mWordIds[slot];
+    if (!mTerminalIndex->isWord(wordId, word, length)) return TerminalIndex::NOT_A_WORD_ID;
+    return wordId;
+}
+
+struct BucketSize {
+    int mBucket;
+    int mSize;
+};
+
+static int compareBucketSizes(const void *left, const void *right) {
+    return static_cast<const BucketSize*>(right)->mSize
+            - static_cast<const BucketSize*>(left)->mSize;
+}
+
+bool WordIndex::build() {
+    const int terminalCount = mTerminalIndex->getWordCount();
+    int wordCount = 0;
+    for (int wordId = 0; wordId < terminalCount; ++wordId) {
+        if (mTerminalIndex->getWordLength(wordId) < MAX_LENGTH) ++wordCount;
+    }
+    mWordCount = wordCount;
+    if (wordCount <= 0) return true;
+
+    // Put the words in as many buckets as there are words.
+    uint16_t word[MAX_WORD_LENGTH_INTERNAL];
+    int *const bucketStarts = new int[wordCount + 1];
+    memset(bucketStarts, 0, sizeof(bucketStarts[0]) * (wordCount + 1));
+    int *const bucketOfWords = new int[terminalCount];
+    for (int wordId = 0; wordId < terminalCount; ++wordId) {
+        const int length = mTerminalIndex->getWord(wordId, MAX_LENGTH, word);
+        if (length >= MAX_LENGTH) {
+            bucketOfWords[wordId] = -1;
+            continue;
+        }
+        const int bucket = hashWord(0, word, length) % static_cast<uint32_t>(wordCount);
+        bucketOfWords[wordId] = bucket;
+        ++bucketStarts[bucket + 1];
+    }
+    for (int bucket = 0; bucket < wordCount; ++bucket) {
+        bucketStarts[bucket + 1] += bucketStarts[bucket];
+    }
+    int *const members = new int[wordCount];
+    int *const cursors = new int[wordCount];
+    memcpy(cursors, bucketStarts, sizeof(cursors[0]) * wordCount);
+    for (int wordId = 0; wordId < terminalCount; ++wordId) {
+        if (bucketOfWords[wordId] >= 0) members[cursors[bucketOfWords[wordId]]++] = wordId;
+    }
+    delete[] cursors;
+    delete[] bucketOfWords;
+
+    BucketSize *const order = new BucketSize[wordCount];
+    for (int bucket = 0; bucket < wordCount; ++bucket) {
+        order[bucket].mBucket = bucket;
+        order[bucket].mSize = bucketStarts[bucket + 1] - bucketStarts[bucket];
+    }
+    qsort(order, wordCount, sizeof(order[0]), compareBucketSizes);
+
+    mSeeds = new int[wordCount];
+    memset(mSeeds, 0, sizeof(mSeeds[0]) * wordCount);
+    mWordIds = new int[wordCount];
+    for (int slot = 0; slot < wordCount; ++slot) {
+        mWordIds[slot] = TerminalIndex::NOT_A_WORD_ID;
+    }
+    int *const slots = new int[order[0].mSize];
+    int freeSlot = 0;
+    bool succeeded = true;
+    for (int i = 0; i < wordCount && order[i].mSize > 0; ++i) {
+        const int bucket = order[i].mBucket;
+        const int size = order[i].mSize;
+        const int *const bucketMembers = members + bucketStarts[bucket];
+        if (1 == size) {
+            while (TerminalIndex::NOT_A_WORD_ID != mWordIds[freeSlot]) ++freeSlot;
+            mWordIds[freeSlot] = bucketMembers[0];
+            mSeeds[bucket] = -1 - freeSlot;
+            continue;
+        }
+        int seed = 1;
+        for (; seed < MAX_SEED_COUNT; ++seed) {
+            int placed = 0;
+            for (; placed < size; ++placed) {
+                const int length = mTerminalIndex->getWord(bucketMembers[placed], MAX_LENGTH,
+                        word);
+                const int slot = hashWord(seed, word, length) % static_cast<uint32_t>(wordCount);
+                if (TerminalIndex::NOT_A_WORD_ID != mWordIds[slot]) break;
+                int j = 0;
+                while (j < placed && slots[j] != slot) ++j;
+                if (j < placed) break;
+                slots[placed] = slot;
+            }
+            if (placed == size) break;
+        }
+        if (seed >= MAX_SEED_COUNT) {
+            // Only happens if two words have the same spelling.
+            succeeded = false;
+            break;
+        }
+        for (int j = 0; j < size; ++j) {
+            mWordIds[slots[j]] = bucketMembers[j];
+        }
+        mSeeds[bucket] = seed;
+    }
+    delete[] slots;
+    delete[] order;
+    delete[] members;
+    delete[] bucketStarts;
+    return succeeded;
+}
+
+} // namespace latinime
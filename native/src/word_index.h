@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_WORD_INDEX_H
+#define LATINIME_WORD_INDEX_H
+
+#include <stdint.h>
+
+#include "hash_utils.h"
+
+namespace latinime {
+
+class TerminalIndex;
+
+// A minimal perfect hash from the spellings of the words of a TerminalIndex to their word ids.
+// Looking a word up costs one hash of the word, two reads in the tables and one comparison
+// with the spelling, instead of a walk down the trie that decodes the siblings at each level.
+// The hash is built when the dictionary is opened, by hashing the words into as many buckets
+// as there are words, then searching, from the largest bucket to the smallest, a seed that
+// puts all the words of the bucket into free slots. Buckets of one word take a free slot
+// directly.
+class WordIndex {
+public:
+    WordIndex(const TerminalIndex *const terminalIndex);
+    ~WordIndex();
+    // Whether getWordId can tell if a word of this length is in the dictionary. If not, the
+    // caller has to walk the trie.
+    bool canLookUp(const int length) const { return mWordCount > 0 && length < MAX_LENGTH; }
+    bool isEmpty() const { return mWordCount <= 0; }
+    // Returns the word id of the word, or TerminalIndex::NOT_A_WORD_ID.
+    int getWordId(const uint16_t *word, const int length) const;
+
+private:
+    static const int MAX_SEED_COUNT = 1 << 16;
+
+    static uint32_t hashWord(const uint32_t seed, const uint16_t *word, const int length);
+    bool build();
+
+    const TerminalIndex *const mTerminalIndex;
+    // Longer words may have been cut in the TerminalIndex, so they are not in the hash.
+    const int MAX_LENGTH;
+    int mWordCount;
+    // For each bucket, the seed that places its words, or -1 - slot for a bucket of one word.
+    int *mSeeds;
+    // The word id in each slot.
+    int *mWordIds;
+};
+
+inline uint32_t WordIndex::hashWord(const uint32_t seed, const uint16_t *word, const int length) {
+    // FNV-1a on the characters.
+    uint32_t hash = FNV_OFFSET_BASIS ^ (seed * GOLDEN_RATIO_MULTIPLIER);
+    for (int i = 0; i < length; ++i) {
+        hash = hashFnvStep(hash, word[i]);
+    }
+    return mixHashBits(hash, 16);
+}
+
+} // namespace latinime
+
+#endif // LATINIME_WORD_INDEX_H
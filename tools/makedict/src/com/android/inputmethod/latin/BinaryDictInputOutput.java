@@ -20,12 +20,17 @@ import com.android.inputmethod.latin.FusionDictionary.CharGroup;
 import com.android.inputmethod.latin.FusionDictionary.Node;
 import com.android.inputmethod.latin.FusionDictionary.WeightedString;
 
+import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
 import java.io.FileNotFoundException;
 import java.io.IOException;
 import java.io.OutputStream;
 import java.io.RandomAccessFile;
 import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.HashMap;
 import java.util.Map;
 import java.util.TreeMap;
 
@@ -80,11 +85,30 @@ public class BinaryDictInputOutput {
      * else: if 00011111 (= 0x1F) : this is the terminator. This is a relevant choice because
      *       unicode code points range from 0 to 0x10FFFF, so any 3-byte value starting with
      *       00011111 would be outside unicode.
-     * else: iso-latin-1 code
+     * else: iso-latin-1 code, or with OPTION_HAS_ALPHABET, see below
      * This allows for the whole unicode range to be encoded, including chars outside of
      * the BMP. Also everything in the iso-latin-1 charset is only 1 byte, except control
      * characters which should never happen anyway (and still work, but take 3 bytes).
      *
+     * Header is:
+     * magic number                    2 bytes, = MAGIC_NUMBER
+     * version                         1 byte, = VERSION
+     * options                         2 bytes
+     * IF OPTION_HAS_ALPHABET
+     *   symbol count                  1 byte, = n, at most MAX_ALPHABET_SIZE
+     *   code points                   n * 3 bytes
+     * END
+     * IF OPTION_HAS_FOLDING_OVERRIDES
+     *   override count                1 byte, = n, at most MAX_FOLDING_OVERRIDES
+     *   overrides                     n * (char 2 bytes, base lower case 2 bytes)
+     * END
+     * With an alphabet, the 1-byte chars 0x20 to 0x20 + n - 1 stand for these code points, in
+     * order, and the other 1-byte chars keep their iso-latin-1 value. The writer puts the most
+     * frequent chars of the dictionary in it, so that scripts outside of iso-latin-1 mostly
+     * take 1 byte per char too.
+     * The folding overrides change the base lower case that the native code compares the chars
+     * with, for the locale of the dictionary. See DictionaryOptions.mFoldingOverrides.
+     *
      * bigram and shortcut address list is:
      * <flags> = | hasNext = 1 bit, 1 = yes, 0 = no     : FLAG_ATTRIBUTE_HAS_NEXT
      *           | addressSign = 1 bit,                 : FLAG_ATTRIBUTE_OFFSET_NEGATIVE
@@ -110,8 +134,19 @@ public class BinaryDictInputOutput {
     private static final int MAGIC_NUMBER = 0x78B1;
     private static final int VERSION = 1;
     private static final int MAXIMUM_SUPPORTED_VERSION = VERSION;
-    // No options yet, reserved for future use.
-    private static final int OPTIONS = 0;
+    // The bigrams of each group are written in order of decreasing frequency, so that a reader
+    // looking for the most frequent ones can stop early.
+    private static final int OPTION_BIGRAMS_SORTED_BY_FREQUENCY = 0x1;
+    private static final int OPTIONS = OPTION_BIGRAMS_SORTED_BY_FREQUENCY;
+    // The dictionary ends with a trigram section. See writeTrigramSection for its layout.
+    private static final int OPTION_HAS_TRIGRAMS = 0x2;
+    // The options are followed by an alphabet. See the header layout above.
+    private static final int OPTION_HAS_ALPHABET = 0x4;
+    // The alphabet, if any, is followed by folding overrides. See the header layout above.
+    private static final int OPTION_HAS_FOLDING_OVERRIDES = 0x8;
+    private static final int MAX_FOLDING_OVERRIDES = 0xFF;
+
+    private static final int TRIGRAM_MAX_FREQUENCY = 0x0F;
 
     // TODO: Make this value adaptative to content data, store it in the header, and
     // use it in the reading code.
@@ -155,20 +190,75 @@ public class BinaryDictInputOutput {
 
     private static final int MAX_TERMINAL_FREQUENCY = 255;
 
+    private static final int MINIMAL_ONE_BYTE_CHARACTER_VALUE = 0x20;
+    private static final int MAXIMAL_ONE_BYTE_CHARACTER_VALUE = 0xFF;
+    /* package for tests */ static final int MAX_ALPHABET_SIZE =
+            MAXIMAL_ONE_BYTE_CHARACTER_VALUE - MINIMAL_ONE_BYTE_CHARACTER_VALUE + 1;
+
+    /**
+     * The code points that the 1-byte chars stand for.
+     *
+     * The 1-byte char 0x20 + i is the code point i of the alphabet, and the 1-byte chars after
+     * the alphabet are iso-latin-1. Without OPTION_HAS_ALPHABET, the alphabet is empty.
+     */
+    /* package for tests */ static class Alphabet {
+        public static final Alphabet ISO_LATIN_1 = new Alphabet(new int[0]);
+
+        private final int[] mCodePoints;
+        private final HashMap<Integer, Integer> mSymbols = new HashMap<Integer, Integer>();
+
+        public Alphabet(final int[] codePoints) {
+            if (codePoints.length > MAX_ALPHABET_SIZE) {
+                throw new RuntimeException("An alphabet has more than " + MAX_ALPHABET_SIZE
+                        + " code points (" + codePoints.length + ").");
+            }
+            mCodePoints = codePoints;
+            for (int i = 0; i < codePoints.length; ++i) {
+                mSymbols.put(codePoints[i], MINIMAL_ONE_BYTE_CHARACTER_VALUE + i);
+            }
+        }
+
+        public int size() {
+            return mCodePoints.length;
+        }
+
+        public int getCodePoint(final int index) {
+            return mCodePoints[index];
+        }
+
+        /**
+         * Returns the 1-byte char for a code point, or -1 if it takes 3 bytes.
+         */
+        public int getSymbol(final int character) {
+            final Integer symbol = mSymbols.get(character);
+            if (null != symbol) return symbol;
+            if (character >= MINIMAL_ONE_BYTE_CHARACTER_VALUE + mCodePoints.length
+                    && character <= MAXIMAL_ONE_BYTE_CHARACTER_VALUE) {
+                return character;
+            }
+            return -1;
+        }
+
+        /**
+         * Returns the code point of a 1-byte char.
+         */
+        public int getCharacter(final int symbol) {
+            final int index = symbol - MINIMAL_ONE_BYTE_CHARACTER_VALUE;
+            return index < mCodePoints.length ? mCodePoints[index] : symbol;
+        }
+    }
+
     /**
      * A class grouping utility function for our specific character encoding.
      */
     private static class CharEncoding {
 
-        private static final int MINIMAL_ONE_BYTE_CHARACTER_VALUE = 0x20;
-        private static final int MAXIMAL_ONE_BYTE_CHARACTER_VALUE = 0xFF;
-
         /**
-         * Helper method to find out whether this code fits on one byte
+         * Helper method to find out whether this byte is a whole char
          */
-        private static boolean fitsOnOneByte(int character) {
-            return character >= MINIMAL_ONE_BYTE_CHARACTER_VALUE
-                    && character <= MAXIMAL_ONE_BYTE_CHARACTER_VALUE;
+        private static boolean isOneByteCharacter(int symbol) {
+            return symbol >= MINIMAL_ONE_BYTE_CHARACTER_VALUE
+                    && symbol <= MAXIMAL_ONE_BYTE_CHARACTER_VALUE;
         }
 
         /**
@@ -180,17 +270,18 @@ public class BinaryDictInputOutput {
          * else: if 00011111 (= 0x1F) : this is the terminator. This is a relevant choice because
          *       unicode code points range from 0 to 0x10FFFF, so any 3-byte value starting with
          *       00011111 would be outside unicode.
-         * else: iso-latin-1 code
+         * else: the code point of the alphabet for this byte, or iso-latin-1 code
          * This allows for the whole unicode range to be encoded, including chars outside of
-         * the BMP. Also everything in the iso-latin-1 charset is only 1 byte, except control
+         * the BMP. Also everything in the alphabet is only 1 byte, except control
          * characters which should never happen anyway (and still work, but take 3 bytes).
          *
          * @param character the character code.
+         * @param alphabet the alphabet of the dictionary.
          * @return the size in binary encoded-form, either 1 or 3 bytes.
          */
-        private static int getCharSize(int character) {
+        private static int getCharSize(int character, Alphabet alphabet) {
             // See char encoding in FusionDictionary.java
-            if (fitsOnOneByte(character)) return 1;
+            if (-1 != alphabet.getSymbol(character)) return 1;
             if (INVALID_CHARACTER == character) return 1;
             return 3;
         }
@@ -198,9 +289,9 @@ public class BinaryDictInputOutput {
         /**
          * Compute the byte size of a character array.
          */
-        private static int getCharArraySize(final int[] chars) {
+        private static int getCharArraySize(final int[] chars, final Alphabet alphabet) {
             int size = 0;
-            for (int character : chars) size += getCharSize(character);
+            for (int character : chars) size += getCharSize(character, alphabet);
             return size;
         }
 
@@ -208,14 +299,17 @@ public class BinaryDictInputOutput {
          * Writes a char array to a byte buffer.
          *
          * @param characters the character array to write.
+         * @param alphabet the alphabet of the dictionary.
          * @param buffer the byte buffer to write to.
          * @param index the index in buffer to write the character array to.
          * @return the index after the last character.
          */
-        private static int writeCharArray(int[] characters, byte[] buffer, int index) {
+        private static int writeCharArray(int[] characters, Alphabet alphabet, byte[] buffer,
+                int index) {
             for (int character : characters) {
-                if (1 == getCharSize(character)) {
-                    buffer[index++] = (byte)character;
+                final int symbol = alphabet.getSymbol(character);
+                if (-1 != symbol) {
+                    buffer[index++] = (byte)symbol;
                 } else {
                     buffer[index++] = (byte)(0xFF & (character >> 16));
                     buffer[index++] = (byte)(0xFF & (character >> 8));
@@ -231,16 +325,17 @@ public class BinaryDictInputOutput {
          * This follows the character format documented earlier in this source file.
          *
          * @param source the file, positioned over an encoded character.
+         * @param alphabet the alphabet of the dictionary.
          * @return the character code.
          */
-        private static int readChar(RandomAccessFile source) throws IOException {
+        private static int readChar(RandomAccessFile source, Alphabet alphabet)
+                throws IOException {
             int character = source.readUnsignedByte();
-            if (!fitsOnOneByte(character)) {
-                if (GROUP_CHARACTERS_TERMINATOR == character)
-                    return INVALID_CHARACTER;
-                character <<= 16;
-                character += source.readUnsignedShort();
-            }
+            if (isOneByteCharacter(character)) return alphabet.getCharacter(character);
+            if (GROUP_CHARACTERS_TERMINATOR == character)
+                return INVALID_CHARACTER;
+            character <<= 16;
+            character += source.readUnsignedShort();
             return character;
         }
     }
@@ -252,22 +347,52 @@ public class BinaryDictInputOutput {
      * sizes + 1 byte for the terminator.
      *
      * @param group the group
+     * @param alphabet the alphabet of the dictionary
      * @return the size of the char array, including the terminator if any
      */
-    private static int getGroupCharactersSize(CharGroup group) {
-        int size = CharEncoding.getCharArraySize(group.mChars);
+    private static int getGroupCharactersSize(CharGroup group, Alphabet alphabet) {
+        int size = CharEncoding.getCharArraySize(group.mChars, alphabet);
         if (group.hasSeveralChars()) size += GROUP_TERMINATOR_SIZE;
         return size;
     }
 
+    /**
+     * Compares bigrams by decreasing frequency, as written in the file.
+     */
+    private static final Comparator<WeightedString> BIGRAM_FREQUENCY_COMPARATOR =
+            new Comparator<WeightedString>() {
+        public int compare(WeightedString b1, WeightedString b2) {
+            return (b2.mFrequency & FLAG_ATTRIBUTE_FREQUENCY)
+                    - (b1.mFrequency & FLAG_ATTRIBUTE_FREQUENCY);
+        }
+    };
+
+    /**
+     * Sorts the bigrams of all groups by decreasing frequency, as promised by
+     * OPTION_BIGRAMS_SORTED_BY_FREQUENCY. The sort is stable, so bigrams of the same frequency
+     * keep their order.
+     *
+     * @param flatNodes the list of all the nodes.
+     */
+    /* package for tests */ static void sortBigramsByFrequency(ArrayList<Node> flatNodes) {
+        for (Node n : flatNodes) {
+            for (CharGroup group : n.mData) {
+                if (null != group.mBigrams) {
+                    Collections.sort(group.mBigrams, BIGRAM_FREQUENCY_COMPARATOR);
+                }
+            }
+        }
+    }
+
     /**
      * Compute the maximum size of a CharGroup, assuming 3-byte addresses for everything.
      *
      * @param group the CharGroup to compute the size of.
+     * @param alphabet the alphabet of the dictionary.
      * @return the maximum size of the group.
      */
-    private static int getCharGroupMaximumSize(CharGroup group) {
-        int size = getGroupCharactersSize(group) + GROUP_FLAGS_SIZE;
+    private static int getCharGroupMaximumSize(CharGroup group, Alphabet alphabet) {
+        int size = getGroupCharactersSize(group, alphabet) + GROUP_FLAGS_SIZE;
         // If terminal, one byte for the frequency
         if (group.isTerminal()) size += GROUP_FREQUENCY_SIZE;
         size += GROUP_MAX_ADDRESS_SIZE; // For children address
@@ -284,11 +409,12 @@ public class BinaryDictInputOutput {
      * it in the 'actualSize' member of the node.
      *
      * @param node the node to compute the maximum size of.
+     * @param alphabet the alphabet of the dictionary.
      */
-    private static void setNodeMaximumSize(Node node) {
+    private static void setNodeMaximumSize(Node node, Alphabet alphabet) {
         int size = GROUP_COUNT_SIZE;
         for (CharGroup g : node.mData) {
-            final int groupSize = getCharGroupMaximumSize(g);
+            final int groupSize = getCharGroupMaximumSize(g, alphabet);
             g.mCachedSize = groupSize;
             size += groupSize;
         }
@@ -376,11 +502,13 @@ public class BinaryDictInputOutput {
      *
      * @param node the node to compute the size of.
      * @param dict the dictionary in which the word/attributes are to be found.
+     * @param alphabet the alphabet of the dictionary.
      */
-    private static void computeActualNodeSize(Node node, FusionDictionary dict) {
+    private static void computeActualNodeSize(Node node, FusionDictionary dict,
+            Alphabet alphabet) {
         int size = GROUP_COUNT_SIZE;
         for (CharGroup group : node.mData) {
-            int groupSize = GROUP_FLAGS_SIZE + getGroupCharactersSize(group);
+            int groupSize = GROUP_FLAGS_SIZE + getGroupCharactersSize(group, alphabet);
             if (group.isTerminal()) groupSize += GROUP_FREQUENCY_SIZE;
             if (null != group.mChildren) {
                 final int offsetBasePoint= groupSize + node.mCachedAddress + size;
@@ -437,12 +565,13 @@ public class BinaryDictInputOutput {
      *
      * @param dict the dictionary
      * @param flatNodes the ordered array of nodes
+     * @param alphabet the alphabet of the dictionary
      * @return the same array it was passed. The nodes have been updated for address and size.
      */
     private static ArrayList<Node> computeAddresses(FusionDictionary dict,
-            ArrayList<Node> flatNodes) {
+            ArrayList<Node> flatNodes, Alphabet alphabet) {
         // First get the worst sizes and offsets
-        for (Node n : flatNodes) setNodeMaximumSize(n);
+        for (Node n : flatNodes) setNodeMaximumSize(n, alphabet);
         final int offset = stackNodes(flatNodes);
 
         MakedictLog.i("Compressing the array addresses. Original size : " + offset);
@@ -454,7 +583,7 @@ public class BinaryDictInputOutput {
             changesDone = false;
             for (Node n : flatNodes) {
                 final int oldNodeSize = n.mCachedSize;
-                computeActualNodeSize(n, dict);
+                computeActualNodeSize(n, dict, alphabet);
                 final int newNodeSize = n.mCachedSize;
                 if (oldNodeSize < newNodeSize) throw new RuntimeException("Increased size ?!");
                 if (oldNodeSize != newNodeSize) changesDone = true;
@@ -587,9 +716,11 @@ public class BinaryDictInputOutput {
      * @param dict the dictionary the node is a part of (for relative offsets).
      * @param buffer the memory buffer to write to.
      * @param node the node to write.
+     * @param alphabet the alphabet of the dictionary.
      * @return the address of the END of the node.
      */
-    private static int writePlacedNode(FusionDictionary dict, byte[] buffer, Node node) {
+    private static int writePlacedNode(FusionDictionary dict, byte[] buffer, Node node,
+            Alphabet alphabet) {
         int index = node.mCachedAddress;
 
         final int size = node.mData.size();
@@ -602,7 +733,7 @@ public class BinaryDictInputOutput {
             CharGroup group = node.mData.get(i);
             if (index != group.mCachedAddress) throw new RuntimeException("Bug: write index is not "
                     + "the same as the cached address of the group");
-            groupAddress += GROUP_FLAGS_SIZE + getGroupCharactersSize(group);
+            groupAddress += GROUP_FLAGS_SIZE + getGroupCharactersSize(group, alphabet);
             // Sanity checks.
             if (group.mFrequency > MAX_TERMINAL_FREQUENCY) {
                 throw new RuntimeException("A node has a frequency > " + MAX_TERMINAL_FREQUENCY
@@ -613,7 +744,7 @@ public class BinaryDictInputOutput {
                     ? NO_CHILDREN_ADDRESS : group.mChildren.mCachedAddress - groupAddress;
             byte flags = makeCharGroupFlags(group, groupAddress, childrenOffset);
             buffer[index++] = flags;
-            index = CharEncoding.writeCharArray(group.mChars, buffer, index);
+            index = CharEncoding.writeCharArray(group.mChars, alphabet, buffer, index);
             if (group.hasSeveralChars()) {
                 buffer[index++] = GROUP_CHARACTERS_TERMINATOR;
             }
@@ -704,6 +835,52 @@ public class BinaryDictInputOutput {
         }
     }
 
+    /**
+     * Chooses the alphabet of a dictionary.
+     *
+     * The alphabet holds the most frequent chars of the groups, as long as the bytes they save
+     * pay for the table in the header. It stays empty for the dictionaries that are mostly
+     * iso-latin-1, where every char is already 1 byte.
+     *
+     * @param flatNodes the nodes of the dictionary.
+     * @return the alphabet, possibly empty.
+     */
+    /* package for tests */ static Alphabet computeAlphabet(ArrayList<Node> flatNodes) {
+        final HashMap<Integer, Integer> counts = new HashMap<Integer, Integer>();
+        for (Node n : flatNodes) {
+            for (CharGroup group : n.mData) {
+                for (int character : group.mChars) {
+                    final Integer count = counts.get(character);
+                    counts.put(character, null == count ? 1 : count + 1);
+                }
+            }
+        }
+        final ArrayList<Map.Entry<Integer, Integer>> entries =
+                new ArrayList<Map.Entry<Integer, Integer>>(counts.entrySet());
+        // Ties go to the smallest code point, so that the output does not depend on hashing.
+        Collections.sort(entries, new Comparator<Map.Entry<Integer, Integer>>() {
+            @Override
+            public int compare(Map.Entry<Integer, Integer> a, Map.Entry<Integer, Integer> b) {
+                if (!a.getValue().equals(b.getValue())) return b.getValue() - a.getValue();
+                return a.getKey() - b.getKey();
+            }
+        });
+        final int size = Math.min(entries.size(), MAX_ALPHABET_SIZE);
+        final int[] codePoints = new int[size];
+        for (int i = 0; i < size; ++i) codePoints[i] = entries.get(i).getKey();
+        final Alphabet alphabet = new Alphabet(codePoints);
+
+        // The table costs a count byte and 3 bytes per code point.
+        int savedBytes = -1 - 3 * size;
+        for (Map.Entry<Integer, Integer> entry : entries) {
+            final int character = entry.getKey();
+            savedBytes += entry.getValue()
+                    * (CharEncoding.getCharSize(character, Alphabet.ISO_LATIN_1)
+                            - CharEncoding.getCharSize(character, alphabet));
+        }
+        return savedBytes > 0 ? alphabet : Alphabet.ISO_LATIN_1;
+    }
+
     /**
      * Dumps a FusionDictionary to a file.
      *
@@ -725,49 +902,278 @@ public class BinaryDictInputOutput {
         final byte[] buffer = new byte[1 << 24];
         int index = 0;
 
+        // Leave the choice of the optimal node order to the flattenTree function.
+        MakedictLog.i("Flattening the tree...");
+        ArrayList<Node> flatNodes = flattenTree(dict.mRoot);
+
+        MakedictLog.i("Choosing the alphabet...");
+        final Alphabet alphabet = computeAlphabet(flatNodes);
+
         // Magic number in big-endian order.
         buffer[index++] = (byte) (0xFF & (MAGIC_NUMBER >> 8));
         buffer[index++] = (byte) (0xFF & MAGIC_NUMBER);
         // Dictionary version.
         buffer[index++] = (byte) (0xFF & VERSION);
         // Options flags
-        buffer[index++] = (byte) (0xFF & (OPTIONS >> 8));
-        buffer[index++] = (byte) (0xFF & OPTIONS);
+        final Map<Integer, Integer> foldingOverrides = dict.mOptions.mFoldingOverrides;
+        final int options = OPTIONS | (dict.mTrigrams.isEmpty() ? 0 : OPTION_HAS_TRIGRAMS)
+                | (0 == alphabet.size() ? 0 : OPTION_HAS_ALPHABET)
+                | (foldingOverrides.isEmpty() ? 0 : OPTION_HAS_FOLDING_OVERRIDES);
+        buffer[index++] = (byte) (0xFF & (options >> 8));
+        buffer[index++] = (byte) (0xFF & options);
+        if (0 != alphabet.size()) {
+            buffer[index++] = (byte) (0xFF & alphabet.size());
+            for (int i = 0; i < alphabet.size(); ++i) {
+                final int codePoint = alphabet.getCodePoint(i);
+                buffer[index++] = (byte) (0xFF & (codePoint >> 16));
+                buffer[index++] = (byte) (0xFF & (codePoint >> 8));
+                buffer[index++] = (byte) (0xFF & codePoint);
+            }
+        }
+        if (!foldingOverrides.isEmpty()) {
+            if (foldingOverrides.size() > MAX_FOLDING_OVERRIDES) {
+                throw new RuntimeException("More than " + MAX_FOLDING_OVERRIDES
+                        + " folding overrides (" + foldingOverrides.size() + ").");
+            }
+            buffer[index++] = (byte) (0xFF & foldingOverrides.size());
+            for (Map.Entry<Integer, Integer> override : foldingOverrides.entrySet()) {
+                final int character = override.getKey();
+                final int baseLowerCase = override.getValue();
+                if (character > 0xFFFF || baseLowerCase > 0xFFFF) {
+                    throw new RuntimeException("A folding override is outside of the BMP: "
+                            + character + " to " + baseLowerCase);
+                }
+                buffer[index++] = (byte) (0xFF & (character >> 8));
+                buffer[index++] = (byte) (0xFF & character);
+                buffer[index++] = (byte) (0xFF & (baseLowerCase >> 8));
+                buffer[index++] = (byte) (0xFF & baseLowerCase);
+            }
+        }
 
         // Should we include the locale and title of the dictionary ?
 
         destination.write(buffer, 0, index);
         index = 0;
 
-        // Leave the choice of the optimal node order to the flattenTree function.
-        MakedictLog.i("Flattening the tree...");
-        ArrayList<Node> flatNodes = flattenTree(dict.mRoot);
+        // This has to happen before computing the addresses, because the size of the bigram
+        // addresses depends on their order.
+        MakedictLog.i("Sorting bigrams...");
+        sortBigramsByFrequency(flatNodes);
 
         MakedictLog.i("Computing addresses...");
-        computeAddresses(dict, flatNodes);
+        computeAddresses(dict, flatNodes, alphabet);
         MakedictLog.i("Checking array...");
         checkFlatNodeArray(flatNodes);
 
         MakedictLog.i("Writing file...");
         int dataEndOffset = 0;
         for (Node n : flatNodes) {
-            dataEndOffset = writePlacedNode(dict, buffer, n);
+            dataEndOffset = writePlacedNode(dict, buffer, n, alphabet);
         }
 
         showStatistics(flatNodes);
 
         destination.write(buffer, 0, dataEndOffset);
 
+        if (!dict.mTrigrams.isEmpty()) {
+            MakedictLog.i("Writing trigrams...");
+            writeTrigramSection(destination, dict, flatNodes, dataEndOffset);
+        }
+
         destination.close();
         MakedictLog.i("Done");
     }
 
 
+    /**
+     * The hash of a pair of word ids, that decides their bucket in the trigram section.
+     *
+     * This must be the same as TrigramDictionary::hashWordIds in the native code.
+     */
+    /* package for tests */ static int hashWordIds(int firstWordId, int secondWordId) {
+        int hash = firstWordId * 0x9E3779B1 ^ secondWordId;
+        hash ^= hash >>> 15;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >>> 13;
+        return hash;
+    }
+
+    /**
+     * The trigrams of one pair of words, with the ids of the words.
+     */
+    private static class TrigramContext {
+        final int mFirstWordId;
+        final int mSecondWordId;
+        int mBucket;
+        final ArrayList<WeightedString> mFollowers = new ArrayList<WeightedString>();
+        public TrigramContext(int firstWordId, int secondWordId) {
+            mFirstWordId = firstWordId;
+            mSecondWordId = secondWordId;
+        }
+    }
+
+    private static final Comparator<TrigramContext> TRIGRAM_CONTEXT_COMPARATOR =
+            new Comparator<TrigramContext>() {
+        public int compare(TrigramContext c1, TrigramContext c2) {
+            if (c1.mBucket != c2.mBucket) return c1.mBucket < c2.mBucket ? -1 : 1;
+            if (c1.mFirstWordId != c2.mFirstWordId) {
+                return c1.mFirstWordId < c2.mFirstWordId ? -1 : 1;
+            }
+            if (c1.mSecondWordId == c2.mSecondWordId) return 0;
+            return c1.mSecondWordId < c2.mSecondWordId ? -1 : 1;
+        }
+    };
+
+    private static final Comparator<WeightedString> TRIGRAM_FREQUENCY_COMPARATOR =
+            new Comparator<WeightedString>() {
+        public int compare(WeightedString t1, WeightedString t2) {
+            return getTrigramFrequency(t2) - getTrigramFrequency(t1);
+        }
+    };
+
+    private static int getTrigramFrequency(WeightedString trigram) {
+        return Math.max(0, Math.min(trigram.mFrequency, TRIGRAM_MAX_FREQUENCY));
+    }
+
+    /**
+     * Finds the id of a word, which is the rank of the address of its group among the
+     * addresses of all the terminal groups.
+     *
+     * @return the id, or -1 if the word is not in the dictionary.
+     */
+    private static int getWordId(FusionDictionary dict, int[] terminalAddresses, String word) {
+        if (null == word) return -1;
+        final CharGroup group = FusionDictionary.findWordInTree(dict.mRoot, word);
+        if (null == group || !group.isTerminal()) return -1;
+        return Arrays.binarySearch(terminalAddresses, group.mCachedAddress);
+    }
+
+    private static void writeWordId(DataOutputStream out, int wordId) throws IOException {
+        out.writeByte(0xFF & (wordId >> 16));
+        out.writeByte(0xFF & (wordId >> 8));
+        out.writeByte(0xFF & wordId);
+    }
+
+    /**
+     * Writes the trigram section after the nodes.
+     *
+     * The section is keyed by word ids, so that the native code can look up the words that
+     * follow a pair of words with one hash probe. All numbers are big endian.
+     *   context count            4 bytes
+     *   bucket count             4 bytes, a power of 2
+     *   buckets                  (bucket count + 1) * 4 bytes: the index of the first context
+     *                            of each bucket, then the context count
+     *   contexts                 10 bytes each, sorted by bucket (hashWordIds & (count - 1)):
+     *     first word id          3 bytes
+     *     second word id         3 bytes
+     *     index of first target  4 bytes
+     *   target count             4 bytes
+     *   targets                  4 bytes each, for each context in order of decreasing
+     *                            frequency:
+     *     frequency              1 byte, 0 to TRIGRAM_MAX_FREQUENCY
+     *     word id                3 bytes
+     *   section address          4 bytes, from the start of the nodes
+     * The word ids are the ranks of the addresses of the terminal groups.
+     *
+     * @param destination the stream to write to.
+     * @param dict the dictionary, with the trigrams.
+     * @param flatNodes the nodes, with their addresses computed.
+     * @param sectionAddress the address of the section, that is the end of the nodes.
+     */
+    private static void writeTrigramSection(OutputStream destination, FusionDictionary dict,
+            ArrayList<Node> flatNodes, int sectionAddress) throws IOException {
+        int terminalCount = 0;
+        for (Node n : flatNodes) {
+            for (CharGroup group : n.mData) {
+                if (group.isTerminal()) ++terminalCount;
+            }
+        }
+        final int[] terminalAddresses = new int[terminalCount];
+        int terminalIndex = 0;
+        for (Node n : flatNodes) {
+            for (CharGroup group : n.mData) {
+                if (group.isTerminal()) terminalAddresses[terminalIndex++] = group.mCachedAddress;
+            }
+        }
+        Arrays.sort(terminalAddresses);
+
+        // Merge the trigrams of the same pair of words, and drop the unknown words.
+        final HashMap<Long, TrigramContext> contextMap = new HashMap<Long, TrigramContext>();
+        final ArrayList<TrigramContext> contexts = new ArrayList<TrigramContext>();
+        int ignoredCount = 0;
+        for (FusionDictionary.Trigram trigram : dict.mTrigrams) {
+            final int firstWordId = getWordId(dict, terminalAddresses, trigram.mWord1);
+            final int secondWordId = getWordId(dict, terminalAddresses, trigram.mWord2);
+            if (firstWordId < 0 || secondWordId < 0) {
+                ignoredCount += trigram.mFollowers.size();
+                continue;
+            }
+            final Long key = ((long)firstWordId << 32) | secondWordId;
+            TrigramContext context = contextMap.get(key);
+            for (WeightedString follower : trigram.mFollowers) {
+                if (getWordId(dict, terminalAddresses, follower.mWord) < 0) {
+                    ++ignoredCount;
+                    continue;
+                }
+                if (null == context) {
+                    context = new TrigramContext(firstWordId, secondWordId);
+                    contextMap.put(key, context);
+                    contexts.add(context);
+                }
+                context.mFollowers.add(follower);
+            }
+        }
+        if (ignoredCount > 0) {
+            MakedictLog.i("Ignored " + ignoredCount + " trigrams with unknown words");
+        }
+
+        int bucketCount = 1;
+        while (bucketCount < contexts.size()) bucketCount <<= 1;
+        for (TrigramContext context : contexts) {
+            context.mBucket =
+                    hashWordIds(context.mFirstWordId, context.mSecondWordId) & (bucketCount - 1);
+        }
+        Collections.sort(contexts, TRIGRAM_CONTEXT_COMPARATOR);
+
+        final ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        final DataOutputStream out = new DataOutputStream(bytes);
+        out.writeInt(contexts.size());
+        out.writeInt(bucketCount);
+        int contextIndex = 0;
+        for (int bucket = 0; bucket <= bucketCount; ++bucket) {
+            while (contextIndex < contexts.size() && contexts.get(contextIndex).mBucket < bucket) {
+                ++contextIndex;
+            }
+            out.writeInt(contextIndex);
+        }
+        int targetCount = 0;
+        for (TrigramContext context : contexts) {
+            writeWordId(out, context.mFirstWordId);
+            writeWordId(out, context.mSecondWordId);
+            out.writeInt(targetCount);
+            targetCount += context.mFollowers.size();
+        }
+        out.writeInt(targetCount);
+        for (TrigramContext context : contexts) {
+            // The sort is stable: followers of the same frequency keep their order.
+            Collections.sort(context.mFollowers, TRIGRAM_FREQUENCY_COMPARATOR);
+            for (WeightedString follower : context.mFollowers) {
+                out.writeByte(getTrigramFrequency(follower));
+                writeWordId(out, getWordId(dict, terminalAddresses, follower.mWord));
+            }
+        }
+        out.writeInt(sectionAddress);
+        out.flush();
+        MakedictLog.i("Trigrams : " + contexts.size() + " pairs of words, " + targetCount
+                + " trigrams, " + bytes.size() + " bytes");
+        bytes.writeTo(destination);
+    }
+
     // Input methods: Read a binary dictionary to memory.
     // readDictionaryBinary is the public entry point for them.
 
     static final int[] characterBuffer = new int[MAX_WORD_LENGTH];
-    private static CharGroupInfo readCharGroup(RandomAccessFile source,
+    private static CharGroupInfo readCharGroup(RandomAccessFile source, Alphabet alphabet,
             final int originalGroupAddress) throws IOException {
         int addressPointer = originalGroupAddress;
         final int flags = source.readUnsignedByte();
@@ -775,17 +1181,17 @@ public class BinaryDictInputOutput {
         final int characters[];
         if (0 != (flags & FLAG_HAS_MULTIPLE_CHARS)) {
             int index = 0;
-            int character = CharEncoding.readChar(source);
-            addressPointer += CharEncoding.getCharSize(character);
+            int character = CharEncoding.readChar(source, alphabet);
+            addressPointer += CharEncoding.getCharSize(character, alphabet);
             while (-1 != character) {
                 characterBuffer[index++] = character;
-                character = CharEncoding.readChar(source);
-                addressPointer += CharEncoding.getCharSize(character);
+                character = CharEncoding.readChar(source, alphabet);
+                addressPointer += CharEncoding.getCharSize(character, alphabet);
             }
             characters = Arrays.copyOfRange(characterBuffer, 0, index);
         } else {
-            final int character = CharEncoding.readChar(source);
-            addressPointer += CharEncoding.getCharSize(character);
+            final int character = CharEncoding.readChar(source, alphabet);
+            addressPointer += CharEncoding.getCharSize(character, alphabet);
             characters = new int[] { character };
         }
         final int frequency;
@@ -855,12 +1261,13 @@ public class BinaryDictInputOutput {
      *
      * @param source the file to read from.
      * @param headerSize the size of the header.
+     * @param alphabet the alphabet of the dictionary.
      * @param address the address to seek.
      * @return the word, as a string.
      * @throws IOException if the file can't be read.
      */
     private static String getWordAtAddress(RandomAccessFile source, long headerSize,
-            int address) throws IOException {
+            Alphabet alphabet, int address) throws IOException {
         final long originalPointer = source.getFilePointer();
         source.seek(headerSize);
         final int count = source.readUnsignedByte();
@@ -870,7 +1277,7 @@ public class BinaryDictInputOutput {
 
         CharGroupInfo last = null;
         for (int i = count - 1; i >= 0; --i) {
-            CharGroupInfo info = readCharGroup(source, groupOffset);
+            CharGroupInfo info = readCharGroup(source, alphabet, groupOffset);
             groupOffset = info.mEndAddress;
             if (info.mOriginalAddress == address) {
                 builder.append(new String(info.mCharacters, 0, info.mCharacters.length));
@@ -912,11 +1319,12 @@ public class BinaryDictInputOutput {
      *
      * @param source the data file, correctly positioned at the start of a node.
      * @param headerSize the size, in bytes, of the file header.
+     * @param alphabet the alphabet of the dictionary.
      * @param reverseNodeMap a mapping from addresses to already read nodes.
      * @param reverseGroupMap a mapping from addresses to already read character groups.
      * @return the read node with all his children already read.
      */
-    private static Node readNode(RandomAccessFile source, long headerSize,
+    private static Node readNode(RandomAccessFile source, long headerSize, Alphabet alphabet,
             Map<Integer, Node> reverseNodeMap, Map<Integer, CharGroup> reverseGroupMap)
             throws IOException {
         final int nodeOrigin = (int)(source.getFilePointer() - headerSize);
@@ -924,12 +1332,13 @@ public class BinaryDictInputOutput {
         final ArrayList<CharGroup> nodeContents = new ArrayList<CharGroup>();
         int groupOffset = nodeOrigin + 1; // 1 byte for the group count
         for (int i = count; i > 0; --i) {
-            CharGroupInfo info = readCharGroup(source, groupOffset);
+            CharGroupInfo info = readCharGroup(source, alphabet, groupOffset);
             ArrayList<WeightedString> bigrams = null;
             if (null != info.mBigrams) {
                 bigrams = new ArrayList<WeightedString>();
                 for (PendingAttribute bigram : info.mBigrams) {
-                    final String word = getWordAtAddress(source, headerSize, bigram.mAddress);
+                    final String word = getWordAtAddress(source, headerSize, alphabet,
+                            bigram.mAddress);
                     bigrams.add(new WeightedString(word, bigram.mFrequency));
                 }
             }
@@ -938,7 +1347,8 @@ public class BinaryDictInputOutput {
                 if (null == children) {
                     final long currentPosition = source.getFilePointer();
                     source.seek(info.mChildrenAddress + headerSize);
-                    children = readNode(source, headerSize, reverseNodeMap, reverseGroupMap);
+                    children = readNode(source, headerSize, alphabet, reverseNodeMap,
+                            reverseGroupMap);
                     source.seek(currentPosition);
                 }
                 nodeContents.add(
@@ -956,6 +1366,20 @@ public class BinaryDictInputOutput {
         return node;
     }
 
+    /**
+     * Reads the alphabet of a dictionary.
+     *
+     * @param source the file, positioned over the symbol count of the header.
+     * @return the alphabet.
+     */
+    private static Alphabet readAlphabet(RandomAccessFile source) throws IOException {
+        final int[] codePoints = new int[source.readUnsignedByte()];
+        for (int i = 0; i < codePoints.length; ++i) {
+            codePoints[i] = (source.readUnsignedByte() << 16) + source.readUnsignedShort();
+        }
+        return new Alphabet(codePoints);
+    }
+
     /**
      * Reads a random access file and returns the memory representation of the dictionary.
      *
@@ -985,15 +1409,25 @@ public class BinaryDictInputOutput {
         }
 
         // Read options
-        source.readUnsignedShort();
+        final int options = source.readUnsignedShort();
+        final Alphabet alphabet = 0 != (options & OPTION_HAS_ALPHABET)
+                ? readAlphabet(source) : Alphabet.ISO_LATIN_1;
+        final FusionDictionary.DictionaryOptions dictOptions =
+                new FusionDictionary.DictionaryOptions();
+        if (0 != (options & OPTION_HAS_FOLDING_OVERRIDES)) {
+            for (int i = source.readUnsignedByte(); i > 0; --i) {
+                final int character = source.readUnsignedShort();
+                dictOptions.mFoldingOverrides.put(character, source.readUnsignedShort());
+            }
+        }
 
         long headerSize = source.getFilePointer();
         Map<Integer, Node> reverseNodeMapping = new TreeMap<Integer, Node>();
         Map<Integer, CharGroup> reverseGroupMapping = new TreeMap<Integer, CharGroup>();
-        final Node root = readNode(source, headerSize, reverseNodeMapping, reverseGroupMapping);
+        final Node root = readNode(source, headerSize, alphabet, reverseNodeMapping,
+                reverseGroupMapping);
 
-        FusionDictionary newDict = new FusionDictionary(root,
-                new FusionDictionary.DictionaryOptions());
+        FusionDictionary newDict = new FusionDictionary(root, dictOptions);
         if (null != dict) {
             for (Word w : dict) {
                 newDict.add(w.mWord, w.mFrequency, w.mBigrams);
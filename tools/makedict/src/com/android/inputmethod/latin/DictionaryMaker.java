@@ -39,14 +39,18 @@ public class DictionaryMaker {
         private final static String OPTION_VERSION_2 = "-2";
         private final static String OPTION_INPUT_SOURCE = "-s";
         private final static String OPTION_INPUT_BIGRAM_XML = "-b";
+        private final static String OPTION_INPUT_TRIGRAM_XML = "-t";
         private final static String OPTION_OUTPUT_BINARY = "-d";
         private final static String OPTION_OUTPUT_XML = "-x";
+        private final static String OPTION_LOCALE = "-l";
         private final static String OPTION_HELP = "-h";
         public final String mInputBinary;
         public final String mInputUnigramXml;
         public final String mInputBigramXml;
+        public final String mInputTrigramXml;
         public final String mOutputBinary;
         public final String mOutputXml;
+        public final String mLocale;
 
         private void checkIntegrity() {
             checkHasExactlyOneInput();
@@ -61,6 +65,9 @@ public class DictionaryMaker {
             } else if (null != mInputBinary && null != mInputBigramXml) {
                 throw new RuntimeException("Cannot specify a binary input and a separate bigram "
                         + "file");
+            } else if (null != mInputBinary && null != mInputTrigramXml) {
+                throw new RuntimeException("Cannot specify a binary input and a separate trigram "
+                        + "file");
             }
         }
 
@@ -72,15 +79,19 @@ public class DictionaryMaker {
 
         private void displayHelp() {
             MakedictLog.i("Usage: makedict "
-                    + "[-s <unigrams.xml> [-b <bigrams.xml>] | -s <binary input>] "
-                    + " [-d <binary output>] [-x <xml output>] [-2]\n"
+                    + "[-s <unigrams.xml> [-b <bigrams.xml>] [-t <trigrams.xml>] "
+                    + "| -s <binary input>] "
+                    + " [-d <binary output>] [-x <xml output>] [-l <locale>] [-2]\n"
                     + "\n"
                     + "  Converts a source dictionary file to one or several outputs.\n"
-                    + "  Source can be an XML file, with an optional XML bigrams file, or a\n"
-                    + "  binary dictionary file.\n"
+                    + "  Source can be an XML file, with optional XML bigrams and trigrams\n"
+                    + "  files, or a binary dictionary file. Trigrams are only read from XML\n"
+                    + "  and written to binary.\n"
                     + "  Both binary and XML outputs are supported. Both can be output at\n"
                     + "  the same time but outputting several files of the same type is not\n"
-                    + "  supported.");
+                    + "  supported.\n"
+                    + "  The locale adds the folding rules of its language to the binary\n"
+                    + "  output, like the dotless i of Turkish.");
         }
 
         public Arguments(String[] argsArray) {
@@ -91,8 +102,10 @@ public class DictionaryMaker {
             String inputBinary = null;
             String inputUnigramXml = null;
             String inputBigramXml = null;
+            String inputTrigramXml = null;
             String outputBinary = null;
             String outputXml = null;
+            String locale = null;
 
             while (!args.isEmpty()) {
                 final String arg = args.get(0);
@@ -117,10 +130,14 @@ public class DictionaryMaker {
                             }
                         } else if (OPTION_INPUT_BIGRAM_XML.equals(arg)) {
                             inputBigramXml = filename;
+                        } else if (OPTION_INPUT_TRIGRAM_XML.equals(arg)) {
+                            inputTrigramXml = filename;
                         } else if (OPTION_OUTPUT_BINARY.equals(arg)) {
                             outputBinary = filename;
                         } else if (OPTION_OUTPUT_XML.equals(arg)) {
                             outputXml = filename;
+                        } else if (OPTION_LOCALE.equals(arg)) {
+                            locale = filename;
                         }
                     }
                 } else {
@@ -141,8 +158,10 @@ public class DictionaryMaker {
             mInputBinary = inputBinary;
             mInputUnigramXml = inputUnigramXml;
             mInputBigramXml = inputBigramXml;
+            mInputTrigramXml = inputTrigramXml;
             mOutputBinary = outputBinary;
             mOutputXml = outputXml;
+            mLocale = locale;
             checkIntegrity();
         }
     }
@@ -152,6 +171,9 @@ public class DictionaryMaker {
             UnsupportedFormatException {
         final Arguments parsedArgs = new Arguments(args);
         FusionDictionary dictionary = readInputFromParsedArgs(parsedArgs);
+        if (null != parsedArgs.mLocale) {
+            dictionary.mOptions.addFoldingOverrides(parsedArgs.mLocale);
+        }
         writeOutputToParsedArgs(parsedArgs, dictionary);
     }
 
@@ -167,7 +189,8 @@ public class DictionaryMaker {
         if (null != args.mInputBinary) {
             return readBinaryFile(args.mInputBinary);
         } else if (null != args.mInputUnigramXml) {
-            return readXmlFile(args.mInputUnigramXml, args.mInputBigramXml);
+            return readXmlFile(args.mInputUnigramXml, args.mInputBigramXml,
+                    args.mInputTrigramXml);
         } else {
             throw new RuntimeException("No input file specified");
         }
@@ -189,10 +212,12 @@ public class DictionaryMaker {
     }
 
     /**
-     * Read a dictionary from a unigram XML file, and optionally a bigram XML file.
+     * Read a dictionary from a unigram XML file, and optionally bigram and trigram XML files.
      *
      * @param unigramXmlFilename the name of the unigram XML file. May not be null.
      * @param bigramXmlFilename the name of the bigram XML file. Pass null if there are no bigrams.
+     * @param trigramXmlFilename the name of the trigram XML file. Pass null if there are no
+     *        trigrams.
      * @return the read dictionary.
      * @throws FileNotFoundException if one of the files can't be found
      * @throws SAXException if one or more of the XML files is not well-formed
@@ -200,12 +225,15 @@ public class DictionaryMaker {
      * @throws ParserConfigurationException if the system can't create a SAX parser
      */
     private static FusionDictionary readXmlFile(final String unigramXmlFilename,
-            final String bigramXmlFilename) throws FileNotFoundException, SAXException,
-            IOException, ParserConfigurationException {
+            final String bigramXmlFilename, final String trigramXmlFilename)
+            throws FileNotFoundException, SAXException, IOException,
+            ParserConfigurationException {
         final FileInputStream unigrams = new FileInputStream(new File(unigramXmlFilename));
         final FileInputStream bigrams = null == bigramXmlFilename ? null :
                 new FileInputStream(new File(bigramXmlFilename));
-        return XmlDictInputOutput.readDictionaryXml(unigrams, bigrams);
+        final FileInputStream trigrams = null == trigramXmlFilename ? null :
+                new FileInputStream(new File(trigramXmlFilename));
+        return XmlDictInputOutput.readDictionaryXml(unigrams, bigrams, trigrams);
     }
 
     /**
@@ -22,6 +22,7 @@ import java.util.Collections;
 import java.util.Iterator;
 import java.util.LinkedList;
 import java.util.List;
+import java.util.TreeMap;
 
 /**
  * A dictionary that can fusion heads and tails of words for more compression.
@@ -67,6 +68,20 @@ public class FusionDictionary implements Iterable<Word> {
         }
     }
 
+    /**
+     * The words that may follow a pair of words, with their frequencies.
+     */
+    public static class Trigram {
+        final String mWord1;
+        final String mWord2;
+        final ArrayList<WeightedString> mFollowers;
+        public Trigram(String word1, String word2, ArrayList<WeightedString> followers) {
+            mWord1 = word1;
+            mWord2 = word2;
+            mFollowers = followers;
+        }
+    }
+
     /**
      * A group of characters, with a frequency, shortcuts, bigrams, and children.
      *
@@ -124,24 +139,44 @@ public class FusionDictionary implements Iterable<Word> {
 
     /**
      * Options global to the dictionary.
-     *
-     * There are no options at the moment, so this class is empty.
      */
     public static class DictionaryOptions {
+        // The chars whose base lower case is not the default one of the native code in the
+        // locale of the dictionary, with the base lower case they have instead.
+        public final TreeMap<Integer, Integer> mFoldingOverrides =
+                new TreeMap<Integer, Integer>();
+
+        /**
+         * Adds the folding overrides that the language of a locale needs, if any.
+         *
+         * @param locale the locale, like "tr" or "tr_TR".
+         */
+        public void addFoldingOverrides(final String locale) {
+            final String language = locale.split("_")[0];
+            // I is the capital of the dotless i, not of i. The capital of i is the dotted I,
+            // which folds to i by default already.
+            if ("tr".equals(language) || "az".equals(language)) {
+                mFoldingOverrides.put((int)'I', 0x131);
+            }
+        }
     }
 
 
     public final DictionaryOptions mOptions;
     public final Node mRoot;
+    // The trigrams are not part of the tree: they are written in a separate section.
+    public final ArrayList<Trigram> mTrigrams;
 
     public FusionDictionary() {
         mOptions = new DictionaryOptions();
         mRoot = new Node();
+        mTrigrams = new ArrayList<Trigram>();
     }
 
     public FusionDictionary(final Node root, final DictionaryOptions options) {
         mRoot = root;
         mOptions = options;
+        mTrigrams = new ArrayList<Trigram>();
     }
 
     /**
@@ -179,6 +214,20 @@ public class FusionDictionary implements Iterable<Word> {
         add(getCodePoints(word), frequency, bigrams);
     }
 
+    /**
+     * Adds the words that may follow a pair of words.
+     *
+     * Unlike bigrams, the words of trigrams are not added to the dictionary: trigrams with
+     * words that are not in the dictionary when it is written are ignored.
+     *
+     * @param word1 the first word of the pair.
+     * @param word2 the second word of the pair.
+     * @param followers the words that may follow them, with their frequencies.
+     */
+    public void addTrigrams(String word1, String word2, ArrayList<WeightedString> followers) {
+        mTrigrams.add(new Trigram(word1, word2, followers));
+    }
+
     /**
      * Sanity check for a node.
      *
@@ -151,6 +151,43 @@ public class XmlDictInputOutput {
         }
     }
 
+    /**
+     * SAX handler for a trigram XML file.
+     *
+     * The file has a tri element for each pair of words, with a w element for each word that
+     * may follow them, like in a bigram file.
+     */
+    static private class TrigramHandler extends DefaultHandler {
+        private final static String TRIGRAM_W1_W2_TAG = "tri";
+        private final static String TRIGRAM_W3_TAG = "w";
+        private final static String TRIGRAM_W1_ATTRIBUTE = "w1";
+        private final static String TRIGRAM_W2_ATTRIBUTE = "w2";
+        private final static String TRIGRAM_W3_ATTRIBUTE = "w3";
+        private final static String TRIGRAM_FREQ_ATTRIBUTE = "p";
+
+        final FusionDictionary mDictionary;
+        ArrayList<WeightedString> mFollowers;
+
+        public TrigramHandler(FusionDictionary dict) {
+            mDictionary = dict;
+            mFollowers = null;
+        }
+
+        @Override
+        public void startElement(String uri, String localName, String qName, Attributes attrs) {
+            if (TRIGRAM_W1_W2_TAG.equals(localName)) {
+                mFollowers = new ArrayList<WeightedString>();
+                mDictionary.addTrigrams(attrs.getValue(uri, TRIGRAM_W1_ATTRIBUTE),
+                        attrs.getValue(uri, TRIGRAM_W2_ATTRIBUTE), mFollowers);
+            } else if (TRIGRAM_W3_TAG.equals(localName) && null != mFollowers) {
+                String w3 = attrs.getValue(uri, TRIGRAM_W3_ATTRIBUTE);
+                int freq = Integer.parseInt(attrs.getValue(uri, TRIGRAM_FREQ_ATTRIBUTE));
+                // Same scale as the bigrams.
+                mFollowers.add(new WeightedString(w3, freq / 8));
+            }
+        }
+    }
+
     /**
      * Reads a dictionary from an XML file.
      *
@@ -162,6 +199,19 @@ public class XmlDictInputOutput {
      */
     public static FusionDictionary readDictionaryXml(InputStream unigrams, InputStream bigrams)
             throws SAXException, IOException, ParserConfigurationException {
+        return readDictionaryXml(unigrams, bigrams, null);
+    }
+
+    /**
+     * Reads a dictionary from an XML file, with optional bigram and trigram files.
+     *
+     * @param unigrams the file to read the data from.
+     * @param bigrams the bigram file, or null.
+     * @param trigrams the trigram file, or null.
+     * @return the in-memory representation of the dictionary.
+     */
+    public static FusionDictionary readDictionaryXml(InputStream unigrams, InputStream bigrams,
+            InputStream trigrams) throws SAXException, IOException, ParserConfigurationException {
         final SAXParserFactory factory = SAXParserFactory.newInstance();
         factory.setNamespaceAware(true);
         final SAXParser parser = factory.newSAXParser();
@@ -172,6 +222,7 @@ public class XmlDictInputOutput {
         final UnigramHandler unigramHandler =
                 new UnigramHandler(dict, bigramHandler.getBigramMap());
         parser.parse(unigrams, unigramHandler);
+        if (null != trigrams) parser.parse(trigrams, new TrigramHandler(dict));
         return dict;
     }
 
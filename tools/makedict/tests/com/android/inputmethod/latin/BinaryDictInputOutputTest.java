@@ -17,8 +17,16 @@
 package com.android.inputmethod.latin;
 
 import com.android.inputmethod.latin.FusionDictionary.Node;
+import com.android.inputmethod.latin.FusionDictionary.WeightedString;
 
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashSet;
 
 import junit.framework.TestCase;
 
@@ -52,4 +60,129 @@ public class BinaryDictInputOutputTest extends TestCase {
         }
     }
 
+    // Test the bigrams are sorted by decreasing frequency, and that bigrams of the same
+    // frequency keep their order.
+    public void testSortBigramsByFrequency() {
+        final FusionDictionary dict = new FusionDictionary();
+        final ArrayList<WeightedString> bigrams = new ArrayList<WeightedString>();
+        bigrams.add(new WeightedString("bar", 3));
+        bigrams.add(new WeightedString("baz", 10));
+        bigrams.add(new WeightedString("qux", 3));
+        bigrams.add(new WeightedString("quux", 12));
+        dict.add("foo", 1, bigrams);
+        BinaryDictInputOutput.sortBigramsByFrequency(
+                BinaryDictInputOutput.flattenTree(dict.mRoot));
+        assertEquals("quux", bigrams.get(0).mWord);
+        assertEquals("baz", bigrams.get(1).mWord);
+        assertEquals("bar", bigrams.get(2).mWord);
+        assertEquals("qux", bigrams.get(3).mWord);
+    }
+
+    // Test the layout of the trigram section, with the followers sorted by decreasing
+    // frequency and the unknown words dropped.
+    public void testTrigramSection() throws IOException {
+        final FusionDictionary dict = new FusionDictionary();
+        dict.add("aa", 1, null);
+        dict.add("bb", 1, null);
+        dict.add("cc", 1, null);
+        final ArrayList<WeightedString> followers = new ArrayList<WeightedString>();
+        followers.add(new WeightedString("cc", 3));
+        followers.add(new WeightedString("unknown", 15));
+        followers.add(new WeightedString("aa", 9));
+        dict.addTrigrams("aa", "bb", followers);
+        final ByteArrayOutputStream out = new ByteArrayOutputStream();
+        BinaryDictInputOutput.writeDictionaryBinary(out, dict);
+        final byte[] data = out.toByteArray();
+
+        assertTrue("The trigram option is not set", 0 != (data[4] & 0x2));
+        final int end = data.length - 4;
+        final int sectionAddress = ((data[end] & 0xFF) << 24) | ((data[end + 1] & 0xFF) << 16)
+                | ((data[end + 2] & 0xFF) << 8) | (data[end + 3] & 0xFF);
+        // The word ids of aa, bb and cc are 0, 1 and 2: their groups are in this order.
+        final byte[] expected = {
+            0, 0, 0, 1, // context count
+            0, 0, 0, 1, // bucket count
+            0, 0, 0, 0, 0, 0, 0, 1, // buckets
+            0, 0, 0, 0, 0, 1, 0, 0, 0, 0, // (aa, bb), first target 0
+            0, 0, 0, 2, // target count
+            9, 0, 0, 0, // aa
+            3, 0, 0, 2, // cc
+        };
+        final int headerSize = 5;
+        assertTrue("Unexpected trigram section", Arrays.equals(expected,
+                Arrays.copyOfRange(data, headerSize + sectionAddress, end)));
+    }
+
+    // Test an iso-latin-1 dictionary has no alphabet, and a cyrillic one has one that reads back.
+    public void testAlphabet() throws IOException, UnsupportedFormatException {
+        final FusionDictionary latinDict = new FusionDictionary();
+        latinDict.add("hello", 1, null);
+        latinDict.add("help", 1, null);
+        final ByteArrayOutputStream latinOut = new ByteArrayOutputStream();
+        BinaryDictInputOutput.writeDictionaryBinary(latinOut, latinDict);
+        assertTrue("A latin dictionary has an alphabet", 0 == (latinOut.toByteArray()[4] & 0x4));
+
+        // The cyrillic letters save enough bytes to pay for the alphabet, and "caf\u00e9" stays
+        // iso-latin-1 past its end.
+        final HashSet<String> words = new HashSet<String>();
+        for (char c = '\u0430'; c <= '\u044f'; ++c) {
+            words.add("\u043f\u0440\u0438" + c + "\u0432\u0435\u0442");
+        }
+        words.add("caf\u00e9");
+        final FusionDictionary dict = new FusionDictionary();
+        for (String word : words) dict.add(word, 1, null);
+        final File file = File.createTempFile("alphabet", ".dict");
+        try {
+            BinaryDictInputOutput.writeDictionaryBinary(new FileOutputStream(file), dict);
+            final RandomAccessFile source = new RandomAccessFile(file, "r");
+            try {
+                source.seek(4);
+                assertTrue("A cyrillic dictionary has no alphabet",
+                        0 != (source.readUnsignedByte() & 0x4));
+                source.seek(0);
+                final HashSet<String> read = new HashSet<String>();
+                for (Word w : BinaryDictInputOutput.readDictionaryBinary(source, null)) {
+                    read.add(w.mWord);
+                }
+                assertEquals(words, read);
+            } finally {
+                source.close();
+            }
+        } finally {
+            file.delete();
+        }
+    }
+
+    // Test the folding overrides of a locale are in the header, and read back.
+    public void testFoldingOverrides() throws IOException, UnsupportedFormatException {
+        final FusionDictionary dict = new FusionDictionary();
+        dict.add("istanbul", 1, null);
+        dict.add("Isparta", 1, null);
+        dict.mOptions.addFoldingOverrides("tr_TR");
+        final File file = File.createTempFile("folding", ".dict");
+        try {
+            BinaryDictInputOutput.writeDictionaryBinary(new FileOutputStream(file), dict);
+            final RandomAccessFile source = new RandomAccessFile(file, "r");
+            try {
+                final byte[] header = new byte[10];
+                source.readFully(header);
+                assertTrue("The folding override option is not set", 0 != (header[4] & 0x8));
+                // One override, from I to the dotless i, right after the options.
+                final byte[] expected = { 1, 0x00, 0x49, 0x01, 0x31 };
+                assertTrue("Unexpected folding overrides",
+                        Arrays.equals(expected, Arrays.copyOfRange(header, 5, 10)));
+                source.seek(0);
+                final FusionDictionary read = BinaryDictInputOutput.readDictionaryBinary(source,
+                        null);
+                assertEquals(dict.mOptions.mFoldingOverrides, read.mOptions.mFoldingOverrides);
+                final HashSet<String> words = new HashSet<String>();
+                for (Word w : read) words.add(w.mWord);
+                assertEquals(new HashSet<String>(Arrays.asList("istanbul", "Isparta")), words);
+            } finally {
+                source.close();
+            }
+        } finally {
+            file.delete();
+        }
+    }
 }
@@ -0,0 +1,45 @@
+#
+# Copyright (C) 2011 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+LOCAL_PATH := $(call my-dir)
+include $(CLEAR_VARS)
+
+LATINIME_NATIVE_SRC_DIR := ../../native/src
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/$(LATINIME_NATIVE_SRC_DIR)
+
+LOCAL_CFLAGS += -Wall -Wno-unused-parameter -Wno-unused-function
+
+LOCAL_SRC_FILES := \
+    ranking_tuner.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/bigram_dictionary.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/bloom_filter.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/char_utils.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/correction.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/dictionary.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/gesture_decoder.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/input_context.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/proximity_info.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/proximity_info_cache.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/ranking_params.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/terminal_index.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/trigram_dictionary.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/unigram_dictionary.cpp \
+    $(LATINIME_NATIVE_SRC_DIR)/word_index.cpp
+
+LOCAL_MODULE := latinime_ranking_tuner
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
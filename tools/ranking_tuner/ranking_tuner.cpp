@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host-side harness to tune the ranking constants of the native dictionary.
+//
+// It replays a corpus of touch sequences against a binary dictionary once for each combination
+// of the swept parameters, and reports hit@1 and hit@3 of the expected words along with the mean
+// and the 99th percentile of the suggestion latency. The gestures are replayed once, since
+// their decoding doesn't depend on the swept parameters, and are also checked against the
+// budget of a frame.
+//
+// Usage: latinime_ranking_tuner <dictionary> <corpus> [options]
+//   --flags F1,F2,...     Suggestion flags to sweep (see BinaryDictionary.java). Default: 0
+//   --params BLOCK        Parameter block applied to every run, e.g. "MAX_DEPTH_MULTIPLIER=2"
+//   --sweep NAME=V1,V2,.. Values of a ranking constant to sweep; may be repeated
+//   --repeat N            Number of times each query is run for the latency. Default: 1
+//
+// The corpus is a text file with one entry per line; lines starting with # are comments.
+//   keyboard <width> <height> <gridWidth> <gridHeight>
+//   key <code> <x> <y> <width> <height> [<sweetSpotX> <sweetSpotY> <sweetSpotRadius>]
+//   query <expectedWord> <x>,<y> [<x>,<y> ...]
+//   gesture <expectedWord> <x>,<y> [<x>,<y> ...]
+// The keyboard and keys must come before the queries and the gestures. The proximity of each
+// touch of a query is computed from the key geometry, the way the Java ProximityInfo does it.
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
+
+#include "dictionary.h"
+#include "proximity_info.h"
+
+using namespace latinime;
+
+namespace {
+
+// These must match the constants of BinaryDictionary.java
+const int TYPED_LETTER_MULTIPLIER = 2;
+const int FULL_WORD_SCORE_MULTIPLIER = 2;
+const int MAX_WORD_LENGTH = 48;
+const int MAX_WORDS = 18;
+const int MAX_PROXIMITY_CHARS_SIZE = 16;
+// The threshold of the Java ProximityInfo, relative to the most common key width
+const float SEARCH_DISTANCE = 1.2f;
+// A gesture is decoded while the finger goes up, so it must not take longer than a frame.
+const double FRAME_BUDGET_MS = 16.0;
+
+struct Key {
+    int mCode;
+    int mX;
+    int mY;
+    int mWidth;
+    int mHeight;
+    float mSweetSpotCenterX;
+    float mSweetSpotCenterY;
+    float mSweetSpotRadius;
+};
+
+struct Query {
+    std::string mExpectedWord;
+    std::vector<int> mXCoordinates;
+    std::vector<int> mYCoordinates;
+};
+
+struct Corpus {
+    int mKeyboardWidth;
+    int mKeyboardHeight;
+    int mGridWidth;
+    int mGridHeight;
+    std::vector<Key> mKeys;
+    std::vector<Query> mQueries;
+    std::vector<Query> mGestures;
+};
+
+struct Sweep {
+    std::string mName;
+    std::vector<std::string> mValues;
+};
+
+void usage() {
+    fprintf(stderr, "Usage: latinime_ranking_tuner <dictionary> <corpus> [--flags F1,F2,...]"
+            " [--params BLOCK] [--sweep NAME=V1,V2,...]... [--repeat N]\n");
+    exit(1);
+}
+
+std::vector<std::string> split(const std::string &s, const char separator) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (start <= s.size()) {
+        const size_t end = s.find(separator, start);
+        const size_t length = (end == std::string::npos ? s.size() : end) - start;
+        if (length > 0) result.push_back(s.substr(start, length));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    return result;
+}
+
+bool readCorpus(const char *path, Corpus *corpus) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Can't open %s\n", path);
+        return false;
+    }
+    corpus->mKeyboardWidth = 0;
+    char line[16384];
+    int lineNumber = 0;
+    bool succeeded = true;
+    while (succeeded && fgets(line, sizeof(line), file)) {
+        ++lineNumber;
+        std::vector<std::string> tokens;
+        for (char *token = strtok(line, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+            tokens.push_back(token);
+        }
+        if (tokens.empty() || tokens[0][0] == '#') continue;
+        if (tokens[0] == "keyboard" && tokens.size() == 5) {
+            corpus->mKeyboardWidth = atoi(tokens[1].c_str());
+            corpus->mKeyboardHeight = atoi(tokens[2].c_str());
+            corpus->mGridWidth = atoi(tokens[3].c_str());
+            corpus->mGridHeight = atoi(tokens[4].c_str());
+        } else if (tokens[0] == "key" && (tokens.size() == 6 || tokens.size() == 9)) {
+            Key key;
+            key.mCode = atoi(tokens[1].c_str());
+            key.mX = atoi(tokens[2].c_str());
+            key.mY = atoi(tokens[3].c_str());
+            key.mWidth = atoi(tokens[4].c_str());
+            key.mHeight = atoi(tokens[5].c_str());
+            const bool hasSweetSpot = tokens.size() == 9;
+            key.mSweetSpotCenterX = hasSweetSpot
+                    ? atof(tokens[6].c_str()) : key.mX + key.mWidth / 2.0f;
+            key.mSweetSpotCenterY = hasSweetSpot
+                    ? atof(tokens[7].c_str()) : key.mY + key.mHeight / 2.0f;
+            key.mSweetSpotRadius = hasSweetSpot ? atof(tokens[8].c_str()) : 0.0f;
+            corpus->mKeys.push_back(key);
+        } else if ((tokens[0] == "query" && tokens.size() >= 3
+                && static_cast<int>(tokens.size()) - 2 < MAX_WORD_LENGTH)
+                || (tokens[0] == "gesture" && tokens.size() >= 3)) {
+            Query query;
+            query.mExpectedWord = tokens[1];
+            for (size_t i = 2; i < tokens.size(); ++i) {
+                int x, y;
+                if (sscanf(tokens[i].c_str(), "%d,%d", &x, &y) != 2) {
+                    succeeded = false;
+                    break;
+                }
+                query.mXCoordinates.push_back(x);
+                query.mYCoordinates.push_back(y);
+            }
+            if (tokens[0] == "query") {
+                corpus->mQueries.push_back(query);
+            } else {
+                corpus->mGestures.push_back(query);
+            }
+        } else {
+            succeeded = false;
+        }
+    }
+    fclose(file);
+    if (!succeeded) {
+        fprintf(stderr, "%s:%d: can't parse this line\n", path, lineNumber);
+        return false;
+    }
+    if (corpus->mKeyboardWidth <= 0 || corpus->mKeys.empty()
+            || (corpus->mQueries.empty() && corpus->mGestures.empty())) {
+        fprintf(stderr, "%s: needs a keyboard, keys and queries or gestures\n", path);
+        return false;
+    }
+    return true;
+}
+
+int squaredDistanceToEdge(const Key &key, const int x, const int y) {
+    const int left = key.mX;
+    const int right = key.mX + key.mWidth;
+    const int top = key.mY;
+    const int bottom = key.mY + key.mHeight;
+    const int edgeX = x < left ? left : (x > right ? right : x);
+    const int edgeY = y < top ? top : (y > bottom ? bottom : y);
+    const int dx = x - edgeX;
+    const int dy = y - edgeY;
+    return dx * dx + dy * dy;
+}
+
+int getMostCommonKeyWidth(const std::vector<Key> &keys) {
+    std::vector<int> widths;
+    for (size_t i = 0; i < keys.size(); ++i) widths.push_back(keys[i].mWidth);
+    std::sort(widths.begin(), widths.end());
+    int mostCommon = widths[0];
+    int bestCount = 0;
+    for (size_t i = 0; i < widths.size();) {
+        size_t j = i;
+        while (j < widths.size() && widths[j] == widths[i]) ++j;
+        if (static_cast<int>(j - i) > bestCount) {
+            bestCount = j - i;
+            mostCommon = widths[i];
+        }
+        i = j;
+    }
+    return mostCommon;
+}
+
+// Writes the codes of the keys near (x, y), nearest first, padded with -1. If primaryCode is
+// not -1, it comes first.
+void getNearbyCodes(const std::vector<Key> &keys, const int threshold, const int x, const int y,
+        const int primaryCode, int *codes) {
+    std::vector<std::pair<int, int> > nearKeys;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const int distance = squaredDistanceToEdge(keys[i], x, y);
+        if (distance < threshold && keys[i].mCode != primaryCode) {
+            nearKeys.push_back(std::make_pair(distance, keys[i].mCode));
+        }
+    }
+    std::sort(nearKeys.begin(), nearKeys.end());
+    int count = 0;
+    if (primaryCode >= 0) codes[count++] = primaryCode;
+    for (size_t i = 0; i < nearKeys.size() && count < MAX_PROXIMITY_CHARS_SIZE; ++i) {
+        codes[count++] = nearKeys[i].second;
+    }
+    while (count < MAX_PROXIMITY_CHARS_SIZE) codes[count++] = -1;
+}
+
+ProximityInfo *createProximityInfo(const Corpus &corpus, const int threshold) {
+    const std::vector<Key> &keys = corpus.mKeys;
+    const int cellWidth = (corpus.mKeyboardWidth + corpus.mGridWidth - 1) / corpus.mGridWidth;
+    const int cellHeight = (corpus.mKeyboardHeight + corpus.mGridHeight - 1) / corpus.mGridHeight;
+    std::vector<uint32_t> proximityChars(
+            corpus.mGridWidth * corpus.mGridHeight * MAX_PROXIMITY_CHARS_SIZE);
+    for (int y = 0; y < corpus.mGridHeight; ++y) {
+        for (int x = 0; x < corpus.mGridWidth; ++x) {
+            int codes[MAX_PROXIMITY_CHARS_SIZE];
+            getNearbyCodes(keys, threshold, x * cellWidth + cellWidth / 2,
+                    y * cellHeight + cellHeight / 2, -1, codes);
+            for (int i = 0; i < MAX_PROXIMITY_CHARS_SIZE; ++i) {
+                proximityChars[(y * corpus.mGridWidth + x) * MAX_PROXIMITY_CHARS_SIZE + i] =
+                        codes[i] < 0 ? 0 : codes[i];
+            }
+        }
+    }
+    const int keyCount = keys.size();
+    std::vector<int32_t> xs(keyCount), ys(keyCount), widths(keyCount), heights(keyCount);
+    std::vector<int32_t> codes(keyCount);
+    std::vector<float> sweetSpotXs(keyCount), sweetSpotYs(keyCount), sweetSpotRadii(keyCount);
+    for (int i = 0; i < keyCount; ++i) {
+        xs[i] = keys[i].mX;
+        ys[i] = keys[i].mY;
+        widths[i] = keys[i].mWidth;
+        heights[i] = keys[i].mHeight;
+        codes[i] = keys[i].mCode;
+        sweetSpotXs[i] = keys[i].mSweetSpotCenterX;
+        sweetSpotYs[i] = keys[i].mSweetSpotCenterY;
+        sweetSpotRadii[i] = keys[i].mSweetSpotRadius;
+    }
+    return new ProximityInfo(MAX_PROXIMITY_CHARS_SIZE, corpus.mKeyboardWidth,
+            corpus.mKeyboardHeight, corpus.mGridWidth, corpus.mGridHeight, &proximityChars[0],
+            keyCount, &xs[0], &ys[0], &widths[0], &heights[0], &codes[0], &sweetSpotXs[0],
+            &sweetSpotYs[0], &sweetSpotRadii[0]);
+}
+
+bool equalsIgnoreCase(const unsigned short *word, const std::string &expected) {
+    size_t i = 0;
+    for (; i < expected.size(); ++i) {
+        if (!word[i] || Dictionary::toBaseLowerCase(word[i])
+                != Dictionary::toBaseLowerCase((unsigned char)expected[i])) {
+            return false;
+        }
+    }
+    return i >= static_cast<size_t>(MAX_WORD_LENGTH) || !word[i];
+}
+
+double nowMs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+void run(Dictionary *dictionary, ProximityInfo *proximityInfo, const Corpus &corpus,
+        const int threshold, const int flags, const int repeat, const std::string &label) {
+    int hit1 = 0;
+    int hit3 = 0;
+    std::vector<double> latencies;
+    for (size_t q = 0; q < corpus.mQueries.size(); ++q) {
+        const Query &query = corpus.mQueries[q];
+        const int length = query.mXCoordinates.size();
+        std::vector<int> xs(query.mXCoordinates);
+        std::vector<int> ys(query.mYCoordinates);
+        std::vector<int> codes(length * MAX_PROXIMITY_CHARS_SIZE);
+        for (int i = 0; i < length; ++i) {
+            int nearest[MAX_PROXIMITY_CHARS_SIZE];
+            getNearbyCodes(corpus.mKeys, 1, xs[i], ys[i], -1, nearest);
+            int primaryCode = nearest[0];
+            if (primaryCode < 0) {
+                int bestDistance = S_INT_MAX;
+                for (size_t k = 0; k < corpus.mKeys.size(); ++k) {
+                    const int d = squaredDistanceToEdge(corpus.mKeys[k], xs[i], ys[i]);
+                    if (d < bestDistance) {
+                        bestDistance = d;
+                        primaryCode = corpus.mKeys[k].mCode;
+                    }
+                }
+            }
+            getNearbyCodes(corpus.mKeys, threshold, xs[i], ys[i], primaryCode,
+                    &codes[i * MAX_PROXIMITY_CHARS_SIZE]);
+        }
+        unsigned short outWords[MAX_WORDS * MAX_WORD_LENGTH];
+        int frequencies[MAX_WORDS];
+        int count = 0;
+        for (int r = 0; r < repeat; ++r) {
+            memset(outWords, 0, sizeof(outWords));
+            memset(frequencies, 0, sizeof(frequencies));
+            const double start = nowMs();
+            count = dictionary->getSuggestions(proximityInfo, &xs[0], &ys[0], &codes[0], length,
+                    NULL, 0, flags, outWords, frequencies);
+            latencies.push_back(nowMs() - start);
+        }
+        for (int i = 0; i < count && i < 3; ++i) {
+            if (equalsIgnoreCase(outWords + i * MAX_WORD_LENGTH, query.mExpectedWord)) {
+                if (i == 0) ++hit1;
+                ++hit3;
+                break;
+            }
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for (size_t i = 0; i < latencies.size(); ++i) total += latencies[i];
+    const int queryCount = corpus.mQueries.size();
+    printf("flags=%d %s\thit@1=%.4f\thit@3=%.4f\tmean=%.4fms\tp99=%.4fms\n", flags,
+            label.empty() ? "(defaults)" : label.c_str(), (double)hit1 / queryCount,
+            (double)hit3 / queryCount, total / latencies.size(),
+            latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)]);
+}
+
+void runGestures(Dictionary *dictionary, ProximityInfo *proximityInfo, const Corpus &corpus,
+        const int repeat) {
+    int hit1 = 0;
+    int hit3 = 0;
+    std::vector<double> latencies;
+    for (size_t g = 0; g < corpus.mGestures.size(); ++g) {
+        const Query &gesture = corpus.mGestures[g];
+        const int sampleCount = gesture.mXCoordinates.size();
+        unsigned short outWords[MAX_WORDS * MAX_WORD_LENGTH];
+        int frequencies[MAX_WORDS];
+        int count = 0;
+        for (int r = 0; r < repeat; ++r) {
+            memset(outWords, 0, sizeof(outWords));
+            memset(frequencies, 0, sizeof(frequencies));
+            const double start = nowMs();
+            count = dictionary->getGestureSuggestions(proximityInfo, &gesture.mXCoordinates[0],
+                    &gesture.mYCoordinates[0], sampleCount, outWords, frequencies);
+            latencies.push_back(nowMs() - start);
+        }
+        for (int i = 0; i < count && i < 3; ++i) {
+            if (equalsIgnoreCase(outWords + i * MAX_WORD_LENGTH, gesture.mExpectedWord)) {
+                if (i == 0) ++hit1;
+                ++hit3;
+                break;
+            }
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    int overBudget = 0;
+    for (size_t i = 0; i < latencies.size(); ++i) {
+        total += latencies[i];
+        if (latencies[i] > FRAME_BUDGET_MS) ++overBudget;
+    }
+    const int gestureCount = corpus.mGestures.size();
+    printf("gestures\thit@1=%.4f\thit@3=%.4f\tmean=%.4fms\tp99=%.4fms\tmax=%.4fms"
+            "\tover %.0fms=%d\n", (double)hit1 / gestureCount, (double)hit3 / gestureCount,
+            total / latencies.size(),
+            latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)],
+            latencies.back(), FRAME_BUDGET_MS, overBudget);
+}
+
+// Runs every combination of the sweeps from the index-th one on.
+void sweep(Dictionary *dictionary, ProximityInfo *proximityInfo, const Corpus &corpus,
+        const int threshold, const std::vector<int> &flagsList, const int repeat,
+        const std::string &baseParams, const std::vector<Sweep> &sweeps, const size_t index,
+        const std::string &label) {
+    if (index == sweeps.size()) {
+        const std::string block = baseParams + " " + label;
+        if (!dictionary->setRankingParams(block.c_str())) {
+            fprintf(stderr, "Invalid parameters: %s\n", block.c_str());
+            exit(1);
+        }
+        for (size_t i = 0; i < flagsList.size(); ++i) {
+            run(dictionary, proximityInfo, corpus, threshold, flagsList[i], repeat, label);
+        }
+        return;
+    }
+    for (size_t i = 0; i < sweeps[index].mValues.size(); ++i) {
+        const std::string entry = sweeps[index].mName + "=" + sweeps[index].mValues[i];
+        sweep(dictionary, proximityInfo, corpus, threshold, flagsList, repeat, baseParams,
+                sweeps, index + 1, label.empty() ? entry : label + " " + entry);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) usage();
+    std::vector<int> flagsList(1, 0);
+    std::string baseParams;
+    std::vector<Sweep> sweeps;
+    int repeat = 1;
+    for (int i = 3; i < argc; ++i) {
+        if (i + 1 >= argc) usage();
+        const std::string option = argv[i];
+        const std::string value = argv[++i];
+        if (option == "--flags") {
+            flagsList.clear();
+            const std::vector<std::string> flags = split(value, ',');
+            for (size_t j = 0; j < flags.size(); ++j) flagsList.push_back(atoi(flags[j].c_str()));
+        } else if (option == "--params") {
+            baseParams = value;
+        } else if (option == "--sweep") {
+            const size_t equal = value.find('=');
+            if (equal == std::string::npos) usage();
+            Sweep s;
+            s.mName = value.substr(0, equal);
+            s.mValues = split(value.substr(equal + 1), ',');
+            if (s.mValues.empty()) usage();
+            sweeps.push_back(s);
+        } else if (option == "--repeat") {
+            repeat = max(1, atoi(value.c_str()));
+        } else {
+            usage();
+        }
+    }
+    if (flagsList.empty()) usage();
+
+    FILE *file = fopen(argv[1], "rb");
+    if (!file) {
+        fprintf(stderr, "Can't open %s\n", argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    const long dictSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *dictBuf = malloc(dictSize);
+    if (!dictBuf || fread(dictBuf, 1, dictSize, file) != static_cast<size_t>(dictSize)) {
+        fprintf(stderr, "Can't read %s\n", argv[1]);
+        return 1;
+    }
+    fclose(file);
+
+    Corpus corpus;
+    if (!readCorpus(argv[2], &corpus)) return 1;
+
+    const float searchDistance = getMostCommonKeyWidth(corpus.mKeys) * SEARCH_DISTANCE;
+    const int threshold = static_cast<int>(searchDistance * searchDistance);
+    ProximityInfo *proximityInfo = createProximityInfo(corpus, threshold);
+    Dictionary *dictionary = new Dictionary(dictBuf, dictSize, 0, 0, TYPED_LETTER_MULTIPLIER,
+            FULL_WORD_SCORE_MULTIPLIER, MAX_WORD_LENGTH, MAX_WORDS, MAX_PROXIMITY_CHARS_SIZE);
+
+    if (!corpus.mQueries.empty()) {
+        sweep(dictionary, proximityInfo, corpus, threshold, flagsList, repeat, baseParams, sweeps,
+                0, "");
+    }
+    if (!corpus.mGestures.empty()) runGestures(dictionary, proximityInfo, corpus, repeat);
+
+    delete dictionary;
+    delete proximityInfo;
+    free(dictBuf);
+    return 0;
+}